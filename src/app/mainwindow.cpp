@@ -19,6 +19,7 @@
 #include "ui_mainwindow.h"
 
 #include "editcontroller.h"
+#include "layoutcache.h"
 #include "layouter.h"
 #include "elementmodel.h"
 #include "scxmlimporter.h"
@@ -105,6 +106,9 @@ void MainWindow::setupStateMachineView()
 {
     m_stateMachineView = new StateMachineView;
     m_stateMachineView->editController()->setEditModeEnabled(true);
+    // opening the same file again restores its layout instead of recomputing it
+    m_layoutCache.reset(new LayoutCache);
+    m_stateMachineView->scene()->layouter()->setCache(m_layoutCache.data());
     setCentralWidget(m_stateMachineView);
 }
 
@@ -19,6 +19,7 @@
 #include <QMainWindow>
 
 namespace KDSME {
+class LayoutCache;
 class StateMachine;
 class StateMachineView;
 class StateModel;
@@ -75,6 +76,7 @@ private:
     KDSME::TransitionListModel *m_transitionsModel;
 
     KDSME::StateMachineView *m_stateMachineView;
+    QScopedPointer<KDSME::LayoutCache> m_layoutCache;
     QScopedPointer<KDSME::StateMachine, QScopedPointerDeleteLater> m_owningStateMachine;
 };
 
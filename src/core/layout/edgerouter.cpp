@@ -0,0 +1,304 @@
+/*
+  This file is part of the KDAB State Machine Editor Library.
+
+  SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company <info@kdab.com>
+
+  SPDX-License-Identifier: LGPL-2.1-only OR LicenseRef-KDAB-KDStateMachineEditor
+
+  Licensees holding valid commercial KDAB State Machine Editor Library
+  licenses may use this file in accordance with the KDAB State Machine Editor
+  Library License Agreement provided with the Software.
+
+  Contact info@kdab.com if any conditions of this licensing are not clear to you.
+*/
+
+#include "edgerouter.h"
+
+#include "elementwalker.h"
+#include "state.h"
+#include "transition.h"
+
+#include <QFontMetricsF>
+#include <QGuiApplication>
+#include <QLineF>
+#include <QPainterPath>
+#include <QRectF>
+#include <QSet>
+#include <QVector>
+
+#include <limits>
+
+using namespace KDSME;
+
+namespace {
+
+/// Distance kept between a detouring transition and the states it avoids
+const qreal OBSTACLE_MARGIN = 8.0;
+/// Upper limit of obstacles to go around, to bound the costs per transition
+const int MAXIMUM_DETOURS = 8;
+const qreal SELF_LOOP_SIZE = 30.0;
+const qreal LABEL_DISTANCE = 4.0;
+
+QRectF absoluteRect(const State *state)
+{
+    return QRectF(state->absolutePos(), QSizeF(state->width(), state->height()));
+}
+
+/// Ancestors of @p state, including @p state itself
+QSet<const State *> lineage(const State *state)
+{
+    QSet<const State *> states;
+    for (; state; state = state->parentState()) {
+        states.insert(state);
+    }
+    return states;
+}
+
+/// States which may be in the way between @p source and @p target
+QVector<QRectF> obstaclesBetween(const State *source, const State *target)
+{
+    const QSet<const State *> sourceLineage = lineage(source);
+    const QSet<const State *> targetLineage = lineage(target);
+
+    // the regions on the way up from both states to their closest common ancestor
+    QSet<const State *> regions;
+    for (const State *region = source->parentState(); region; region = region->parentState()) {
+        regions.insert(region);
+        if (targetLineage.contains(region)) {
+            break;
+        }
+    }
+    for (const State *region = target->parentState(); region; region = region->parentState()) {
+        regions.insert(region);
+        if (sourceLineage.contains(region)) {
+            break;
+        }
+    }
+
+    QVector<QRectF> obstacles;
+    for (const State *region : std::as_const(regions)) {
+        const auto childStates = region->childStates();
+        for (const State *child : childStates) {
+            if (!child->isVisible() || sourceLineage.contains(child) || targetLineage.contains(child)) {
+                continue;
+            }
+            obstacles.append(absoluteRect(child).adjusted(-OBSTACLE_MARGIN, -OBSTACLE_MARGIN, OBSTACLE_MARGIN, OBSTACLE_MARGIN));
+        }
+    }
+    return obstacles;
+}
+
+/**
+ * Liang-Barsky clipping of the segment @p from -> @p to against @p rect
+ *
+ * @p entry is set to the segment parameter at which the segment enters the rect
+ * @return True in case the segment passes through the interior of @p rect
+ */
+bool intersects(const QPointF &from, const QPointF &to, const QRectF &rect, qreal *entry)
+{
+    const qreal dx = to.x() - from.x();
+    const qreal dy = to.y() - from.y();
+    const qreal p[] = { -dx, dx, -dy, dy };
+    const qreal q[] = { from.x() - rect.left(), rect.right() - from.x(), from.y() - rect.top(), rect.bottom() - from.y() };
+
+    qreal t0 = 0;
+    qreal t1 = 1;
+    for (int i = 0; i < 4; ++i) {
+        if (qFuzzyIsNull(p[i])) {
+            if (q[i] <= 0) {
+                return false; // parallel to and outside of this edge
+            }
+            continue;
+        }
+        const qreal t = q[i] / p[i];
+        if (p[i] < 0) {
+            t0 = qMax(t0, t);
+        } else {
+            t1 = qMin(t1, t);
+        }
+    }
+
+    *entry = t0;
+    return t1 - t0 > 1e-6;
+}
+
+/// Point where the ray from the center of @p rect towards @p towards leaves @p rect
+QPointF borderPoint(const QRectF &rect, const QPointF &towards)
+{
+    const QPointF center = rect.center();
+    const qreal dx = towards.x() - center.x();
+    const qreal dy = towards.y() - center.y();
+    if (qFuzzyIsNull(dx) && qFuzzyIsNull(dy)) {
+        return center;
+    }
+
+    const qreal tx = qFuzzyIsNull(dx) ? std::numeric_limits<qreal>::max() : (rect.width() / 2) / qAbs(dx);
+    const qreal ty = qFuzzyIsNull(dy) ? std::numeric_limits<qreal>::max() : (rect.height() / 2) / qAbs(dy);
+    const qreal t = qMin(qMin(tx, ty), qreal(1));
+    return center + QPointF(dx * t, dy * t);
+}
+
+QVector<QPointF> routeAround(const QPointF &start, const QPointF &end, const QVector<QRectF> &obstacles)
+{
+    QVector<QPointF> points = { start, end };
+    for (int detour = 0; detour < MAXIMUM_DETOURS; ++detour) {
+        // find the first obstacle in the way
+        int segment = -1;
+        QRectF obstacle;
+        qreal nearest = std::numeric_limits<qreal>::max();
+        for (int i = 0; i + 1 < points.size() && segment == -1; ++i) {
+            for (const QRectF &rect : obstacles) {
+                qreal entry = 0;
+                if (intersects(points.at(i), points.at(i + 1), rect, &entry) && entry < nearest) {
+                    segment = i;
+                    obstacle = rect;
+                    nearest = entry;
+                }
+            }
+        }
+        if (segment == -1) {
+            break;
+        }
+
+        // go around the corner which makes for the shortest detour, preferably without hitting the obstacle again
+        const QPointF from = points.at(segment);
+        const QPointF to = points.at(segment + 1);
+        const QPointF corners[] = { obstacle.topLeft(), obstacle.topRight(), obstacle.bottomRight(), obstacle.bottomLeft() };
+        QPointF bestCorner;
+        qreal bestCost = std::numeric_limits<qreal>::max();
+        for (const QPointF &corner : corners) {
+            qreal entry = 0;
+            const bool blocked = intersects(from, corner, obstacle, &entry) || intersects(corner, to, obstacle, &entry);
+            const qreal cost = QLineF(from, corner).length() + QLineF(corner, to).length() + (blocked ? obstacle.width() + obstacle.height() : 0);
+            if (cost < bestCost) {
+                bestCost = cost;
+                bestCorner = corner;
+            }
+        }
+        points.insert(segment + 1, bestCorner);
+    }
+    return points;
+}
+
+QPainterPath smoothPath(const QVector<QPointF> &points)
+{
+    QPainterPath path(points.first());
+    if (points.size() == 2) {
+        path.lineTo(points.last());
+        return path;
+    }
+
+    // use the detour points as control points, passing through the middle between two of them
+    for (int i = 1; i + 1 < points.size(); ++i) {
+        const QPointF end = (i + 2 == points.size()) ? points.at(i + 1) : (points.at(i) + points.at(i + 1)) / 2;
+        path.quadTo(points.at(i), end);
+    }
+    return path;
+}
+
+QPainterPath selfLoop(const QRectF &rect)
+{
+    QPainterPath path(QPointF(rect.right(), rect.center().y() - rect.height() / 4));
+    path.cubicTo(QPointF(rect.right() + SELF_LOOP_SIZE, rect.top() - rect.height() / 4),
+                 QPointF(rect.right() + SELF_LOOP_SIZE, rect.bottom() + rect.height() / 4),
+                 QPointF(rect.right(), rect.center().y() + rect.height() / 4));
+    return path;
+}
+
+QSizeF labelSize(const Transition *transition)
+{
+    const QRectF labelRect = transition->labelBoundingRect();
+    if (!labelRect.isEmpty()) {
+        return labelRect.size();
+    }
+    if (transition->label().isEmpty()) {
+        return QSizeF();
+    }
+
+    const QFontMetricsF fm(QGuiApplication::font());
+    return QSizeF(fm.horizontalAdvance(transition->label()), fm.height());
+}
+
+}
+
+QList<Transition *> EdgeRouter::incidentTransitions(const State *state)
+{
+    QList<Transition *> transitions;
+    if (!state) {
+        return transitions;
+    }
+
+    // only the moved subtree is visited, incoming transitions are found through the targets
+    QVector<const State *> movedStates;
+    ElementWalker walker(ElementWalker::PreOrderTraversal);
+    walker.walkItems(const_cast<State *>(state), [&](Element *element) {
+        if (auto *movedState = qobject_cast<State *>(element)) {
+            movedStates.append(movedState);
+        }
+        return ElementWalker::RecursiveWalk;
+    });
+    const QSet<const State *> moved(movedStates.constBegin(), movedStates.constEnd());
+
+    for (const State *movedState : std::as_const(movedStates)) {
+        const auto outgoing = movedState->transitions();
+        for (Transition *transition : outgoing) {
+            if (transition->targetState() && !moved.contains(transition->targetState())) {
+                transitions.append(transition);
+            }
+        }
+        const auto incoming = movedState->incomingTransitions();
+        for (Transition *transition : incoming) {
+            if (!moved.contains(transition->sourceState())) {
+                transitions.append(transition);
+            }
+        }
+    }
+    return transitions;
+}
+
+void EdgeRouter::route(Transition *transition)
+{
+    const State *source = transition->sourceState();
+    const State *target = transition->targetState();
+    if (!source || !target) {
+        return;
+    }
+
+    const QRectF sourceRect = absoluteRect(source);
+    const QRectF targetRect = absoluteRect(target);
+
+    QPainterPath path;
+    if (source == target) {
+        path = selfLoop(sourceRect);
+    } else {
+        if (sourceRect.contains(targetRect) || targetRect.contains(sourceRect)) {
+            return; // no sensible straight route, keep the shape from the last layout
+        }
+
+        QVector<QPointF> points = routeAround(sourceRect.center(), targetRect.center(), obstaclesBetween(source, target));
+        points.first() = borderPoint(sourceRect, points.at(1));
+        points.last() = borderPoint(targetRect, points.at(points.size() - 2));
+        path = smoothPath(points);
+    }
+
+    QRectF labelRect;
+    const QSizeF size = labelSize(transition);
+    if (!size.isEmpty()) {
+        const QPointF center = path.pointAtPercent(0.5);
+        labelRect = QRectF(QPointF(center.x() + LABEL_DISTANCE, center.y() - size.height() / 2), size);
+    }
+
+    // transitions are positioned relative to their source state
+    const QPointF absolutePos = labelRect.united(path.boundingRect()).topLeft();
+    transition->setPos(absolutePos - source->absolutePos());
+    transition->setShape(path.translated(-absolutePos));
+    transition->setLabelBoundingRect(labelRect.isNull() ? QRectF() : labelRect.translated(-absolutePos));
+}
+
+void EdgeRouter::rerouteTransitions(const State *state)
+{
+    const auto transitions = incidentTransitions(state);
+    for (Transition *transition : transitions) {
+        route(transition);
+    }
+}
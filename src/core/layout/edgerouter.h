@@ -0,0 +1,57 @@
+/*
+  This file is part of the KDAB State Machine Editor Library.
+
+  SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company <info@kdab.com>
+
+  SPDX-License-Identifier: LGPL-2.1-only OR LicenseRef-KDAB-KDStateMachineEditor
+
+  Licensees holding valid commercial KDAB State Machine Editor Library
+  licenses may use this file in accordance with the KDAB State Machine Editor
+  Library License Agreement provided with the Software.
+
+  Contact info@kdab.com if any conditions of this licensing are not clear to you.
+*/
+
+#ifndef KDSME_LAYOUT_EDGEROUTER_H
+#define KDSME_LAYOUT_EDGEROUTER_H
+
+#include "kdsme_core_export.h"
+
+#include <QList>
+
+namespace KDSME {
+
+class State;
+class Transition;
+
+/**
+ * @brief Cheap rerouting of single transitions, without laying out the whole state machine
+ *
+ * Meant to keep transitions attached to states while these get moved or resized interactively.
+ * A transition is routed as a straight line between the borders of its source and target state,
+ * which detours around the corners of other states in its way. Only the states which can
+ * physically be in the way are considered, i.e. the siblings of the source and target states
+ * and of their ancestors up to the closest common ancestor.
+ */
+namespace EdgeRouter {
+/**
+ * @return The transitions whose geometry depends on the position of @p state
+ *
+ * That is, the transitions connecting @p state or one of its descendants to a state outside of @p state.
+ */
+KDSME_CORE_EXPORT QList<Transition *> incidentTransitions(const State *state);
+
+/**
+ * @brief Recompute the shape and label bounding rect of @p transition from the current state geometry
+ */
+KDSME_CORE_EXPORT void route(Transition *transition);
+
+/**
+ * @brief Reroute all transitions returned by incidentTransitions()
+ */
+KDSME_CORE_EXPORT void rerouteTransitions(const State *state);
+}
+
+}
+
+#endif // KDSME_LAYOUT_EDGEROUTER_H
@@ -17,8 +17,8 @@
 
 #include "graphvizlayouterbackend_p.h"
 #include "element.h"
+#include "layoutresult.h"
 #include "state.h"
-#include "transition.h"
 
 #include "debug.h"
 
@@ -40,33 +40,13 @@ GraphvizLayerLayouter::~GraphvizLayerLayouter()
 
 QRectF GraphvizLayerLayouter::layout(State *state, const LayoutProperties *properties)
 {
-    m_backend->openLayout(state, properties);
-
-    const QList<State *> childStates = state->childStates();
-
-    // Step 1: Create Graphviz structures out of the State/Transition tree
-    // Step 1.1: build nodes
-    for (State *childState : childStates) {
-        m_backend->buildState(childState);
-    }
-    // Step 1.2: build edges
-    for (const State *childState : childStates) {
-        const auto stateTransitions = childState->transitions();
-        for (Transition *transition : stateTransitions) {
-            // TODO: What to do with transitions crossing hierarchies?
-            if (!childStates.contains(transition->targetState())) {
-                continue; // ignore for now
-            }
-            m_backend->buildTransition(transition);
-        }
-    }
-
-    m_backend->layout();
-
-    // Step 2: Import the information from the Graphviz structures to the State/Transition tree
-    m_backend->import();
+    // TODO: What to do with transitions crossing hierarchies? They are ignored for now
+    const LayoutResult result = computeLayout(LayoutRegion::fromState(state), properties);
+    result.apply();
+    return result.boundingRect;
+}
 
-    const QRectF boundingRect = m_backend->boundingRect();
-    m_backend->closeLayout();
-    return boundingRect;
+LayoutResult GraphvizLayerLayouter::computeLayout(const LayoutRegion &region, const LayoutProperties *properties)
+{
+    return m_backend->computeLayout(region, properties);
 }
@@ -22,6 +22,9 @@ class GraphvizLayouterBackend;
 
 namespace KDSME {
 
+struct LayoutRegion;
+struct LayoutResult;
+
 class GraphvizLayerLayouter : public Layouter
 {
     Q_OBJECT
@@ -32,6 +35,14 @@ public:
 
     QRectF layout(State *state, const LayoutProperties *properties) override;
 
+    /**
+     * Lay out the states of @p region without modifying any element
+     *
+     * @note May be called from a worker thread, only the copied inputs are read
+     * @sa LayoutRegion::fromState(), LayoutResult::apply()
+     */
+    LayoutResult computeLayout(const LayoutRegion &region, const LayoutProperties *properties);
+
 private:
     GraphvizLayouterBackend *m_backend;
 };
@@ -17,14 +17,31 @@
 
 #include "graphvizlayouterbackend_p.h"
 #include "element.h"
+#include "elementwalker.h"
 #include "state.h"
+#include "transition.h"
 
 #include "debug.h"
 
 #include <QRectF>
+#include <QSet>
 
 using namespace KDSME;
 
+namespace {
+
+/// Strict ancestors of @p state, up to and excluding @p root
+QSet<const State *> ancestors(const State *root, const State *state)
+{
+    QSet<const State *> result;
+    for (const State *parent = state->parentState(); parent && parent != root; parent = parent->parentState()) {
+        result.insert(parent);
+    }
+    return result;
+}
+
+}
+
 GraphvizLayouter::GraphvizLayouter(QObject *parent)
     : Layouter(parent)
     , m_backend(new GraphvizLayouterBackend)
@@ -45,6 +62,25 @@ QRectF GraphvizLayouter::layout(State *state, const LayoutProperties *properties
 
     qCDebug(KDSME_CORE) << state << properties;
 
+    beginLayout(state, properties);
+
+    if (!isDirty(state) && lastBoundingRect().isValid()) {
+        endLayout();
+        return lastBoundingRect();
+    }
+
+    QRectF boundingRect;
+    QByteArray cacheKey;
+    if (restoreFromCache(state, properties, &cacheKey, &boundingRect)) {
+        setLastBoundingRect(boundingRect);
+        endLayout();
+        return boundingRect;
+    }
+
+    // Graphviz lays out the whole compound graph at once, unchanged regions are laid out
+    // as opaque nodes keeping the layout of their contents
+    m_backend->setReusedStates(reusableStates(state));
+
     // open context
     m_backend->openLayout(state, properties);
 
@@ -59,7 +95,51 @@ QRectF GraphvizLayouter::layout(State *state, const LayoutProperties *properties
     // Step 2: Import the information from the Graphviz structures to the State/Transition tree
     m_backend->import();
 
-    const QRectF boundingRect = m_backend->boundingRect();
+    boundingRect = m_backend->boundingRect();
     m_backend->closeLayout();
+
+    storeInCache(state, cacheKey, boundingRect);
+
+    setLastBoundingRect(boundingRect);
+    endLayout();
     return boundingRect;
 }
+
+QSet<const State *> GraphvizLayouter::reusableStates(State *root) const
+{
+    if (!isIncremental()) {
+        return {};
+    }
+
+    // regions with transitions crossing their boundary need to be laid out along with the rest
+    QSet<const State *> crossedStates;
+    ElementWalker walker(ElementWalker::PreOrderTraversal);
+    walker.walkItems(root, [&](Element *element) {
+        if (auto *transition = qobject_cast<Transition *>(element)) {
+            if (transition->sourceState() && transition->targetState()) {
+                const auto sourceAncestors = ancestors(root, transition->sourceState());
+                const auto targetAncestors = ancestors(root, transition->targetState());
+                crossedStates += sourceAncestors - targetAncestors;
+                crossedStates += targetAncestors - sourceAncestors;
+            }
+        }
+        return ElementWalker::RecursiveWalk;
+    });
+
+    QSet<const State *> result;
+    walker.walkItems(root, [&](Element *element) {
+        auto *state = qobject_cast<State *>(element);
+        if (!state || state == root || state->childStates().isEmpty()) {
+            return ElementWalker::RecursiveWalk;
+        }
+        if (!state->isExpanded()) {
+            return ElementWalker::ContinueWalk;
+        }
+        if (isDirty(state) || crossedStates.contains(state) || qIsNull(state->width()) || qIsNull(state->height())) {
+            return ElementWalker::RecursiveWalk;
+        }
+        result.insert(state);
+        return ElementWalker::ContinueWalk;
+    });
+    return result;
+}
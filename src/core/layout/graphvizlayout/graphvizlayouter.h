@@ -20,6 +20,9 @@
 
 #include "layouter.h"
 
+#include <QRectF>
+#include <QSet>
+
 class GraphvizLayouterBackend;
 
 namespace KDSME {
@@ -31,12 +34,15 @@ class KDSME_CORE_EXPORT GraphvizLayouter : public Layouter
     Q_OBJECT
 
 public:
-    explicit GraphvizLayouter(QObject *parent = nullptr);
+    Q_INVOKABLE explicit GraphvizLayouter(QObject *parent = nullptr);
     ~GraphvizLayouter();
 
     QRectF layout(State *state, const LayoutProperties *properties) override;
 
 private:
+    /// In incremental mode, the clean regions whose layout can be kept as is
+    QSet<const State *> reusableStates(State *root) const;
+
     GraphvizLayouterBackend *m_backend;
 };
 
@@ -24,6 +24,7 @@
 #include "elementmodel.h"
 #include "elementwalker.h"
 #include "layoutproperties.h"
+#include "layoutresult.h"
 #include "layoututils.h"
 #include "util/objecthelper.h"
 
@@ -38,10 +39,13 @@
 
 #include <QDir>
 #include <QFile>
+#include <QMutex>
 #include <QPainterPath>
 #include <QPoint>
 
+#include <algorithm>
 #include <clocale> //for LC_NUMERIC
+#include <iterator>
 
 #define IF_DEBUG(x)
 
@@ -64,47 +68,127 @@ const qreal DOT_DEFAULT_DPI = 72.0;
 const qreal DISPLAY_DPI = 96.0;
 const qreal TO_DOT_DPI_RATIO = DISPLAY_DPI / DOT_DEFAULT_DPI;
 
-QVector<QPair<const char *, const char *>> attributesForState(const State *state)
-{
-    typedef QPair<const char *, const char *> EntryType;
-    typedef QVector<EntryType> ResultType;
-
-    if (const auto *pseudoState = qobject_cast<const PseudoState *>(state)) {
-        switch (pseudoState->kind()) {
-        case PseudoState::InitialState:
-            return ResultType()
-                << EntryType("label", "") // get rid off 'no space for label' warnings
-                << EntryType("shape", "circle")
-                << EntryType("fixedsize", "true")
-                << EntryType("height", "0.20")
-                << EntryType("width", "0.20");
-        default:
-            break;
-        }
+/// Node attributes set by the backend, see NODE_ATTRIBUTE_NAMES
+enum NodeAttribute
+{
+    NodeLabelAttribute,
+    NodeShapeAttribute,
+    NodeFixedSizeAttribute,
+    NodeWidthAttribute,
+    NodeHeightAttribute,
+    NodeStyleAttribute,
+    NodeFillColorAttribute,
+    NodeAttributeCount
+};
+
+const char *const NODE_ATTRIBUTE_NAMES[NodeAttributeCount] = {
+    "label",
+    "shape",
+    "fixedsize",
+    "width",
+    "height",
+    "style",
+    "fillcolor",
+};
+
+/// Edge attributes set by the backend, see EDGE_ATTRIBUTE_NAMES
+enum EdgeAttribute
+{
+    EdgeLabelAttribute,
+    EdgeTailAttribute,
+    EdgeHeadAttribute,
+    EdgeAttributeCount
+};
+
+const char *const EDGE_ATTRIBUTE_NAMES[EdgeAttributeCount] = {
+    "label",
+    "ltail",
+    "lhead",
+};
+
+/// Attributes of the root graph, set once per layout
+const char *const GRAPH_ATTRIBUTES[][2] = {
+    { "overlap", "prism" },
+    { "overlap_shrink", "true" },
+    { "splines", "true" },
+    { "pad", "0.0" },
+    { "dpi", "96.0" },
+    { "nodesep", "0.2" },
+};
+
+struct NodeAttributeValue
+{
+    NodeAttribute attribute;
+    const char *value;
+};
+
+const QVector<NodeAttributeValue> &attributesForState(Element::Type type, bool isInitialState)
+{
+    static const QVector<NodeAttributeValue> initialStateAttributes = {
+        { NodeLabelAttribute, "" }, // get rid off 'no space for label' warnings
+        { NodeShapeAttribute, "circle" },
+        { NodeFixedSizeAttribute, "true" },
+        { NodeHeightAttribute, "0.20" },
+        { NodeWidthAttribute, "0.20" },
+    };
+    static const QVector<NodeAttributeValue> historyStateAttributes = {
+        { NodeLabelAttribute, "H*" }, // get rid off 'no space for label' warnings
+        { NodeShapeAttribute, "circle" },
+        { NodeFixedSizeAttribute, "true" },
+    };
+    static const QVector<NodeAttributeValue> finalStateAttributes = {
+        { NodeShapeAttribute, "doublecircle" },
+        { NodeLabelAttribute, "" },
+        { NodeStyleAttribute, "filled" },
+        { NodeFillColorAttribute, "black" },
+        { NodeFixedSizeAttribute, "true" },
+        { NodeHeightAttribute, "0.15" },
+        { NodeWidthAttribute, "0.15" },
+    };
+    static const QVector<NodeAttributeValue> defaultAttributes = {
+        { NodeShapeAttribute, "rectangle" },
+        { NodeStyleAttribute, "rounded" },
+    };
+
+    if (isInitialState) {
+        return initialStateAttributes;
     }
 
-    if (state->type() == State::HistoryStateType) {
-        return ResultType()
-            << EntryType("label", "H*") // get rid off 'no space for label' warnings
-            << EntryType("shape", "circle")
-            << EntryType("fixedsize", "true");
+    if (type == State::HistoryStateType) {
+        return historyStateAttributes;
     }
 
-    if (state->type() == State::FinalStateType) {
-        return ResultType()
-            << EntryType("shape", "doublecircle")
-            << EntryType("label", "")
-            << EntryType("style", "filled")
-            << EntryType("fillcolor", "black")
-            << EntryType("fixedsize", "true")
-            << EntryType("height", "0.15")
-            << EntryType("width", "0.15");
+    if (type == State::FinalStateType) {
+        return finalStateAttributes;
     }
 
-    // default:
-    return ResultType()
-        << EntryType("shape", "rectangle")
-        << EntryType("style", "rounded");
+    return defaultAttributes;
+}
+
+bool isInitialState(const State *state)
+{
+    const auto *pseudoState = qobject_cast<const PseudoState *>(state);
+    return pseudoState && pseudoState->kind() == PseudoState::InitialState;
+}
+
+/// Same as ObjectHelper::addressToString(), without the detour through QString
+QByteArray addressToName(const void *p)
+{
+    return "0x" + QByteArray::number(reinterpret_cast<quint64>(p), 16);
+}
+
+/**
+ * Graphviz keeps process-global state while laying out a graph (e.g. the attribute
+ * symbols in common/globals.h) and while loading plugins into a context, so only one
+ * layout or context (de-)initialization may run at a time.
+ *
+ * Everything else (building the graph, importing the results) runs on per-backend
+ * data only and thus may happen in several threads at once.
+ */
+QMutex &layoutMutex()
+{
+    static QMutex mutex;
+    return mutex;
 }
 
 bool isAncestorCollapsed(const State *current)
@@ -129,12 +213,17 @@ struct GraphvizLayouterBackend::Private // NOLINT(clang-analyzer-cplusplus.NewDe
     void buildState(State *state, Agraph_t *graph);
     void buildTransitions(const State *state, Agraph_t *graph);
     void buildTransition(Transition *transition, Agraph_t *graph);
+    /// Build the nodes and edges of @p region, in the order of its inputs
+    void buildRegion(const LayoutRegion &region, QVector<Agnode_t *> *nodes, QVector<Agedge_t *> *edges);
 
-    void import();
-    void importItem(Element *item, void *obj) const;
-    void importState(State *state, Agnode_t *node) const;
-    void importState(State *state, Agraph_t *graph) const;
-    void importTransition(Transition *transition, Agedge_t *edge) const;
+    void import(LayoutResult *result) const;
+    void importItem(Element *item, void *obj, LayoutResult *result, QHash<const Element *, QPointF> *absolutePositions) const;
+    /**
+     * Return the new absolute position of the parent of @p element
+     *
+     * Falls back to the current position in case the parent is not part of this layout run
+     */
+    QPointF parentAbsolutePos(const Element *element, const QHash<const Element *, QPointF> &absolutePositions) const;
 
     /// Allocate resources from Graphviz
     void openContext(const QString &id);
@@ -145,6 +234,10 @@ struct GraphvizLayouterBackend::Private // NOLINT(clang-analyzer-cplusplus.NewDe
      * Return the bounding rect of the label for graph @p graph in global coordinate system
      */
     QRectF boundingRectForGraph(Agraph_t *graph) const;
+    /**
+     * Return the bounding rect of node @p node in global coordinate system
+     */
+    QRectF rectForNode(Agnode_t *node) const;
     /**
      * Return the bounding rect of the label for edge @p edge in global coordinate system
      */
@@ -155,6 +248,17 @@ struct GraphvizLayouterBackend::Private // NOLINT(clang-analyzer-cplusplus.NewDe
     QPainterPath pathForEdge(Agedge_t *edge) const;
 
     inline Agnode_t *agnodeForState(State *state) const;
+    /// Whether @p state is laid out as a subgraph, with its descendants
+    bool isCluster(const State *state) const;
+
+    /**
+     * Set @p attribute of @p node resp. @p edge to @p value
+     *
+     * The attribute symbol is declared on first use and looked up through the cache afterwards,
+     * which has the same effect as agsafeset() without resolving the attribute name each time.
+     */
+    void setNodeAttribute(Agnode_t *node, NodeAttribute attribute, const char *value);
+    void setEdgeAttribute(Agedge_t *edge, EdgeAttribute attribute, const char *value);
 
     /// Root Graphviz graph used for layouting
     Agraph_t *m_graph = nullptr;
@@ -162,12 +266,19 @@ struct GraphvizLayouterBackend::Private // NOLINT(clang-analyzer-cplusplus.NewDe
     GVC_t *m_context = nullptr;
 
     LayoutMode m_layoutMode = RecursiveMode;
+    AttributeMode m_attributeMode = SymbolAttributes;
     const LayoutProperties *m_properties = nullptr;
+    QSet<const State *> m_reusedStates;
 
     /// Mapping from state machine items to Graphviz layout items
     QPointer<State> m_root;
     QHash<Element *, Agnode_t *> m_elementToDummyNodeMap;
     QHash<Element *, void *> m_elementToPointerMap;
+
+    /// Attribute symbols of m_graph, declared lazily
+    Agsym_t *m_nodeSymbols[NodeAttributeCount] = {};
+    Agsym_t *m_edgeSymbols[EdgeAttributeCount] = {};
+    Agsym_t *m_graphLabelSymbol = nullptr;
 };
 
 GraphvizLayouterBackend::Private::Private()
@@ -192,16 +303,25 @@ void GraphvizLayouterBackend::Private::buildState(State *state, Agraph_t *graph)
     const LocaleLocker _;
 
     // build nodes
-    if (m_layoutMode == RecursiveMode && !state->childStates().isEmpty()) {
-        const QString graphName = u"cluster" + addressToString(state);
-        Agraph_t *newGraph = _agsubg(graph, graphName);
+    if (isCluster(state)) {
+        const QByteArray graphName = "cluster" + addressToName(state);
+        Agraph_t *newGraph = _agsubg(graph, graphName.constData());
 
         m_elementToPointerMap[state] = newGraph;
-        _agset(newGraph, QStringLiteral("label"), state->label().isEmpty() ? QObject::tr("<unnamed>") : state->label() + u" ###"); // add a placeholder for the expand/collapse button
+        const QString label = state->label().isEmpty() ? QObject::tr("<unnamed>") : state->label() + u" ###"; // add a placeholder for the expand/collapse button
+        if (m_attributeMode == NameAttributes) {
+            _agset(newGraph, QStringLiteral("label"), label);
+        } else {
+            if (!m_graphLabelSymbol) {
+                m_graphLabelSymbol = _agattr(m_graph, AGRAPH, "label");
+            }
+            _agxset(newGraph, m_graphLabelSymbol, label.toUtf8().constData());
+        }
 
-        auto dummyNode = _agnode(newGraph, u"dummynode_" + graphName);
-        _agset(dummyNode, QStringLiteral("shape"), QStringLiteral("point"));
-        _agset(dummyNode, QStringLiteral("style"), QStringLiteral("invis"));
+        const QByteArray dummyNodeName = "dummynode_" + graphName;
+        auto dummyNode = _agnode(newGraph, dummyNodeName.constData());
+        setNodeAttribute(dummyNode, NodeShapeAttribute, "point");
+        setNodeAttribute(dummyNode, NodeStyleAttribute, "invis");
         m_elementToDummyNodeMap[state] = dummyNode;
 
         if (!isAncestorCollapsed(state)) {
@@ -215,25 +335,62 @@ void GraphvizLayouterBackend::Private::buildState(State *state, Agraph_t *graph)
             return;
         }
 
-        Agnode_t *newNode = _agnode(graph, addressToString(state));
+        Agnode_t *newNode = _agnode(graph, addressToName(state).constData());
         m_elementToPointerMap[state] = newNode;
 
         if (!qIsNull(state->width()) && !qIsNull(state->height())) {
-            _agset(newNode, QStringLiteral("width"), QString::number(state->width() / DISPLAY_DPI));
-            _agset(newNode, QStringLiteral("height"), QString::number(state->height() / DISPLAY_DPI));
-            _agset(newNode, QStringLiteral("fixedsize"), QStringLiteral("true"));
+            setNodeAttribute(newNode, NodeWidthAttribute, QByteArray::number(state->width() / DISPLAY_DPI).constData());
+            setNodeAttribute(newNode, NodeHeightAttribute, QByteArray::number(state->height() / DISPLAY_DPI).constData());
+            setNodeAttribute(newNode, NodeFixedSizeAttribute, "true");
         }
         if (!state->label().isEmpty()) {
-            _agset(newNode, QStringLiteral("label"), state->label());
+            setNodeAttribute(newNode, NodeLabelAttribute, state->label().toUtf8().constData());
         }
 
-        const auto attrs = attributesForState(qobject_cast<State *>(state));
-        for (const auto &kv : attrs) {
-            _agset(newNode, QString::fromLatin1(kv.first), QString::fromLatin1(kv.second));
+        const auto &attrs = attributesForState(state->type(), isInitialState(state));
+        for (const auto &attr : attrs) {
+            setNodeAttribute(newNode, attr.attribute, attr.value);
         }
     }
 }
 
+void GraphvizLayouterBackend::Private::buildRegion(const LayoutRegion &region, QVector<Agnode_t *> *nodes, QVector<Agedge_t *> *edges)
+{
+    const LocaleLocker _;
+
+    // same attributes as buildState() and buildTransition() in NonRecursiveMode
+    nodes->reserve(region.states.size());
+    for (int i = 0; i < region.states.size(); ++i) {
+        const LayoutRegion::StateInput &input = region.states.at(i);
+        const QByteArray name = "n" + QByteArray::number(i);
+        Agnode_t *node = _agnode(m_graph, name.constData());
+        if (!qIsNull(input.width) && !qIsNull(input.height)) {
+            setNodeAttribute(node, NodeWidthAttribute, QByteArray::number(input.width / DISPLAY_DPI).constData());
+            setNodeAttribute(node, NodeHeightAttribute, QByteArray::number(input.height / DISPLAY_DPI).constData());
+            setNodeAttribute(node, NodeFixedSizeAttribute, "true");
+        }
+        if (!input.label.isEmpty()) {
+            setNodeAttribute(node, NodeLabelAttribute, input.label.toUtf8().constData());
+        }
+        const auto &attrs = attributesForState(input.type, input.isInitialState);
+        for (const auto &attr : attrs) {
+            setNodeAttribute(node, attr.attribute, attr.value);
+        }
+        nodes->append(node);
+    }
+
+    edges->reserve(region.transitions.size());
+    for (int i = 0; i < region.transitions.size(); ++i) {
+        const LayoutRegion::TransitionInput &input = region.transitions.at(i);
+        const QByteArray name = "e" + QByteArray::number(i);
+        Agedge_t *edge = _agedge(m_graph, nodes->at(input.source), nodes->at(input.target), name.constData(), true);
+        if (!input.label.isEmpty() && m_properties->showTransitionLabels()) {
+            setEdgeAttribute(edge, EdgeLabelAttribute, input.label.toUtf8().constData());
+        }
+        edges->append(edge);
+    }
+}
+
 void GraphvizLayouterBackend::Private::buildTransitions(const State *state, Agraph_t *graph)
 {
     IF_DEBUG(qCDebug(KDSME_CORE) << state->label() << *state << graph);
@@ -243,7 +400,7 @@ void GraphvizLayouterBackend::Private::buildTransitions(const State *state, Agra
         buildTransition(transition, graph);
     }
 
-    if (m_layoutMode == RecursiveMode) {
+    if (m_layoutMode == RecursiveMode && !m_reusedStates.contains(state)) {
         const auto childStates = state->childStates();
         for (const State *childState : childStates) {
             buildTransitions(childState, graph); // recursive call
@@ -279,58 +436,99 @@ void GraphvizLayouterBackend::Private::buildTransition(Transition *transition, A
     Agedge_t *edge = _agedge(graph,
                              sourceDummyNode ? sourceDummyNode : source,
                              targetDummyNode ? targetDummyNode : target,
-                             addressToString(transition), true);
+                             addressToName(transition).constData(), true);
     if (!transition->label().isEmpty() && m_properties->showTransitionLabels()) {
-        _agset(edge, QStringLiteral("label"), transition->label());
+        setEdgeAttribute(edge, EdgeLabelAttribute, transition->label().toUtf8().constData());
     }
 
     // in order to connect subgraphs we need to leverage ltail + lhead attribute of edges
     // see: https://stackoverflow.com/questions/2012036/graphviz-how-to-connect-subgraphs
     if (sourceDummyNode) {
-        const QString graphName = u"cluster" + addressToString(sourceState);
-        _agset(edge, QStringLiteral("ltail"), graphName);
+        const QByteArray graphName = "cluster" + addressToName(sourceState);
+        setEdgeAttribute(edge, EdgeTailAttribute, graphName.constData());
     }
     if (targetDummyNode) {
-        const QString graphName = u"cluster" + addressToString(targetState);
-        _agset(edge, QStringLiteral("lhead"), graphName);
+        const QByteArray graphName = "cluster" + addressToName(targetState);
+        setEdgeAttribute(edge, EdgeHeadAttribute, graphName.constData());
     }
     m_elementToPointerMap[transition] = edge;
     Q_ASSERT(edge);
 }
 
-void GraphvizLayouterBackend::Private::import()
+void GraphvizLayouterBackend::Private::import(LayoutResult *result) const
 {
     IF_DEBUG(qCDebug(KDSME_CORE) << m_elementToPointerMap.keys();)
 
     const LocaleLocker _;
+    // new absolute positions of the items imported so far, parents are visited before their children
+    QHash<const Element *, QPointF> absolutePositions;
     ElementWalker walker(ElementWalker::PreOrderTraversal);
-    walker.walkItems(m_root, [this](Element *element) {
+    walker.walkItems(m_root, [&](Element *element) {
         if (auto obj = m_elementToPointerMap.value(element)) {
-            importItem(element, obj);
+            importItem(element, obj, result, &absolutePositions);
         }
-        return ElementWalker::RecursiveWalk;
+        // the descendants keep their positions relative to the reused state
+        return m_reusedStates.contains(qobject_cast<State *>(element)) ? ElementWalker::ContinueWalk : ElementWalker::RecursiveWalk;
     });
+    result->boundingRect = boundingRectForGraph(m_graph);
 }
 
-void GraphvizLayouterBackend::Private::importItem(Element *item, void *obj) const
+void GraphvizLayouterBackend::Private::importItem(Element *item, void *obj, LayoutResult *result,
+                                                  QHash<const Element *, QPointF> *absolutePositions) const
 {
     if (auto *state = qobject_cast<State *>(item)) {
-        if (m_layoutMode == RecursiveMode && !state->childStates().isEmpty()) {
-            importState(state, static_cast<Agraph_t *>(obj));
-        } else {
-            importState(state, static_cast<Agnode_t *>(obj));
+        const QRectF rect = isCluster(state)
+            ? boundingRectForGraph(static_cast<Agraph_t *>(obj))
+            : rectForNode(static_cast<Agnode_t *>(obj));
+        IF_DEBUG(qCDebug(KDSME_CORE) << state->label() << *state << rect);
+
+        const QPointF absolutePos = rect.topLeft();
+        absolutePositions->insert(state, absolutePos);
+
+        QPointF pos = absolutePos;
+        if (m_layoutMode == RecursiveMode) {
+            pos -= parentAbsolutePos(state, *absolutePositions);
         }
+        result->states.append(LayoutResult::StateGeometry { state, pos, rect.width(), rect.height() });
     } else if (auto *transition = qobject_cast<Transition *>(item)) {
-        importTransition(transition, static_cast<Agedge_t *>(obj));
+        auto *edge = static_cast<Agedge_t *>(obj);
+        IF_DEBUG(qCDebug(KDSME_CORE) << transition << edge);
+
+        // transform to local coordinate system, set position offset
+        const QPainterPath path = pathForEdge(edge);
+        const QRectF labelRect = labelRectForEdge(edge);
+        const QRectF boundingRect = labelRect.united(path.boundingRect());
+        const QPointF absolutePos = boundingRect.topLeft();
+        const Element *parent = transition->parentElement();
+        Q_ASSERT(parent);
+
+        QPointF pos;
+        if (m_layoutMode == RecursiveMode) {
+            pos = absolutePos - parentAbsolutePos(transition, *absolutePositions);
+        } else {
+            // the source state was imported into the same layer, its new position is the absolute one
+            const auto it = absolutePositions->constFind(parent);
+            pos = absolutePos - (it != absolutePositions->constEnd() ? *it : parent->pos());
+        }
+        result->transitions.append(LayoutResult::TransitionGeometry { transition, pos, path.translated(-absolutePos), labelRect.translated(-absolutePos) });
     }
 }
 
-void GraphvizLayouterBackend::Private::importState(State *state, Agnode_t *node) const
+QPointF GraphvizLayouterBackend::Private::parentAbsolutePos(const Element *element,
+                                                           const QHash<const Element *, QPointF> &absolutePositions) const
 {
-    Q_ASSERT(state);
-    Q_ASSERT(node);
+    const Element *parent = element->parentElement();
+    if (!parent) {
+        return QPointF();
+    }
 
-    IF_DEBUG(qCDebug(KDSME_CORE) << "before" << state->label() << *state << node);
+    const auto it = absolutePositions.constFind(parent);
+    return (it != absolutePositions.constEnd() ? *it : parent->absolutePos());
+}
+
+QRectF GraphvizLayouterBackend::Private::rectForNode(Agnode_t *node) const
+{
+    Q_ASSERT(node);
 
     // cppcheck-suppress-begin cstyleCast
     // Fetch the X coordinate, apply the DPI conversion rate (actual DPI / 72, used by dot)
@@ -340,66 +538,11 @@ void GraphvizLayouterBackend::Private::importState(State *state, Agnode_t *node)
     const qreal y = (GD_bb(m_graph).UR.y - ND_coord(node).y) * TO_DOT_DPI_RATIO;
 
     // Transform the width and height from inches to pixels
-
-    state->setWidth(ND_width(node) * DISPLAY_DPI);
-    state->setHeight(ND_height(node) * DISPLAY_DPI);
+    const qreal width = ND_width(node) * DISPLAY_DPI;
+    const qreal height = ND_height(node) * DISPLAY_DPI;
     // cppcheck-suppress-end cstyleCast
 
-    const QPointF absolutePos = QPointF(x - state->width() / 2, y - state->height() / 2);
-    if (m_layoutMode == RecursiveMode) {
-        const QPointF relativePos = absolutePos - (state->parentElement() ? state->parentElement()->absolutePos() : QPointF());
-        state->setPos(relativePos);
-    } else {
-        state->setPos(absolutePos);
-    }
-
-    IF_DEBUG(qCDebug(KDSME_CORE) << "after" << state->label() << *state << node);
-}
-
-void GraphvizLayouterBackend::Private::importState(State *state, Agraph_t *graph) const
-{
-    Q_ASSERT(state);
-    Q_ASSERT(graph);
-
-    IF_DEBUG(qCDebug(KDSME_CORE) << "before" << state->label() << *state << graph);
-
-    const QRectF rect = boundingRectForGraph(graph);
-
-    state->setWidth(rect.width());
-    state->setHeight(rect.height());
-
-    const QPointF absolutePos = rect.topLeft();
-    if (m_layoutMode == RecursiveMode) {
-        const QPointF relativePos = absolutePos - (state->parentElement() ? state->parentElement()->absolutePos() : QPointF());
-        state->setPos(relativePos);
-    } else {
-        state->setPos(absolutePos);
-    }
-
-    IF_DEBUG(qCDebug(KDSME_CORE) << "after" << state->label() << *state << graph);
-}
-
-void GraphvizLayouterBackend::Private::importTransition(Transition *transition, Agedge_t *edge) const
-{
-    Q_ASSERT(transition);
-    Q_ASSERT(edge);
-
-    IF_DEBUG(qCDebug(KDSME_CORE) << "before" << transition << edge);
-    // transform to local coordinate system, set position offset
-    const QPainterPath path = pathForEdge(edge);
-    const QRectF labelRect = labelRectForEdge(edge);
-    const QRectF boundingRect = labelRect.united(path.boundingRect());
-    const QPointF absolutePos = boundingRect.topLeft();
-    Q_ASSERT(transition->parentElement());
-    if (m_layoutMode == RecursiveMode) {
-        const QPointF relativePos = absolutePos - transition->parentElement()->absolutePos();
-        transition->setPos(relativePos);
-    } else {
-        transition->setPos(absolutePos - transition->parentElement()->pos());
-    }
-    transition->setShape(path.translated(-absolutePos));
-    transition->setLabelBoundingRect(labelRect.translated(-absolutePos));
-    IF_DEBUG(qCDebug(KDSME_CORE) << "after" << transition << edge);
+    return QRectF(x - width / 2, y - height / 2, width, height);
 }
 
 extern "C" {
@@ -414,6 +557,9 @@ void GraphvizLayouterBackend::Private::openContext(const QString &id)
 
     m_elementToDummyNodeMap.clear();
     m_elementToPointerMap.clear();
+    std::fill(std::begin(m_nodeSymbols), std::end(m_nodeSymbols), nullptr);
+    std::fill(std::begin(m_edgeSymbols), std::end(m_edgeSymbols), nullptr);
+    m_graphLabelSymbol = nullptr;
 
 #ifdef WITH_CGRAPH
     m_graph = _agopen(id, Agdirected, &AgDefaultDisc);
@@ -423,14 +569,11 @@ void GraphvizLayouterBackend::Private::openContext(const QString &id)
 
     // modify settings
     if (m_layoutMode == RecursiveMode) {
-        _agset(m_graph, QStringLiteral("compound"), QStringLiteral("true"));
+        _agset(m_graph, "compound", "true");
+    }
+    for (const auto &attr : GRAPH_ATTRIBUTES) {
+        _agset(m_graph, attr[0], attr[1]);
     }
-    _agset(m_graph, QStringLiteral("overlap"), QStringLiteral("prism"));
-    _agset(m_graph, QStringLiteral("overlap_shrink"), QStringLiteral("true"));
-    _agset(m_graph, QStringLiteral("splines"), QStringLiteral("true"));
-    _agset(m_graph, QStringLiteral("pad"), QStringLiteral("0.0"));
-    _agset(m_graph, QStringLiteral("dpi"), QStringLiteral("96.0"));
-    _agset(m_graph, QStringLiteral("nodesep"), QStringLiteral("0.2"));
 }
 
 void GraphvizLayouterBackend::Private::closeLayout()
@@ -527,6 +670,39 @@ Agnode_t *GraphvizLayouterBackend::Private::agnodeForState(State *state) const
     return static_cast<Agnode_t *>(m_elementToPointerMap.value(state));
 }
 
+bool GraphvizLayouterBackend::Private::isCluster(const State *state) const
+{
+    return m_layoutMode == RecursiveMode && !state->childStates().isEmpty() && !m_reusedStates.contains(state);
+}
+
+void GraphvizLayouterBackend::Private::setNodeAttribute(Agnode_t *node, NodeAttribute attribute, const char *value)
+{
+    if (m_attributeMode == NameAttributes) {
+        _agset(node, QString::fromLatin1(NODE_ATTRIBUTE_NAMES[attribute]), QString::fromUtf8(value));
+        return;
+    }
+
+    Agsym_t *&symbol = m_nodeSymbols[attribute];
+    if (!symbol) {
+        symbol = _agattr(m_graph, AGNODE, NODE_ATTRIBUTE_NAMES[attribute]);
+    }
+    _agxset(node, symbol, value);
+}
+
+void GraphvizLayouterBackend::Private::setEdgeAttribute(Agedge_t *edge, EdgeAttribute attribute, const char *value)
+{
+    if (m_attributeMode == NameAttributes) {
+        _agset(edge, QString::fromLatin1(EDGE_ATTRIBUTE_NAMES[attribute]), QString::fromUtf8(value));
+        return;
+    }
+
+    Agsym_t *&symbol = m_edgeSymbols[attribute];
+    if (!symbol) {
+        symbol = _agattr(m_graph, AGEDGE, EDGE_ATTRIBUTE_NAMES[attribute]);
+    }
+    _agxset(edge, symbol, value);
+}
+
 #if !KDSME_STATIC_GRAPHVIZ && !defined(Q_OS_WINDOWS)
 extern "C" {
 
@@ -543,6 +719,7 @@ GraphvizLayouterBackend::GraphvizLayouterBackend()
     : d(new Private)
 {
     // create context
+    const QMutexLocker locker(&layoutMutex());
 #if KDSME_STATIC_GRAPHVIZ
     d->m_context = gvContextWithStaticPlugins();
 #elif !defined(Q_OS_WINDOWS)
@@ -559,6 +736,7 @@ GraphvizLayouterBackend::~GraphvizLayouterBackend()
 
     // close context
     Q_ASSERT(d->m_context);
+    const QMutexLocker locker(&layoutMutex());
     gvFreeContext(d->m_context);
     d->m_context = nullptr;
 
@@ -575,12 +753,31 @@ void GraphvizLayouterBackend::setLayoutMode(LayoutMode mode)
     d->m_layoutMode = mode;
 }
 
+GraphvizLayouterBackend::AttributeMode GraphvizLayouterBackend::attributeMode() const
+{
+    return d->m_attributeMode;
+}
+
+void GraphvizLayouterBackend::setAttributeMode(AttributeMode mode)
+{
+    d->m_attributeMode = mode;
+}
+
+void GraphvizLayouterBackend::setReusedStates(const QSet<const State *> &states)
+{
+    d->m_reusedStates = states;
+}
+
 void GraphvizLayouterBackend::layout()
 {
     // do the actual layouting
-    _gvLayout(d->m_context, d->m_graph, DEFAULT_LAYOUT_TOOL);
+    {
+        const LocaleLocker _; // attributes such as the node sizes get parsed here
+        const QMutexLocker locker(&layoutMutex());
+        _gvLayout(d->m_context, d->m_graph, DEFAULT_LAYOUT_TOOL);
+    }
 
-    if (qEnvironmentVariableIsSet("KDSME_DEBUG_GRAPHVIZ")) {
+    if (qEnvironmentVariableIsSet("KDSME_DEBUG_GRAPHVIZ") && d->m_root) {
         const auto state = d->m_root;
         const auto machine = state->machine();
         Q_ASSERT(machine);
@@ -627,6 +824,44 @@ void GraphvizLayouterBackend::closeLayout()
     d->closeLayout();
 }
 
+LayoutResult GraphvizLayouterBackend::computeLayout(const LayoutRegion &region, const LayoutProperties *properties)
+{
+    d->m_root = nullptr;
+    d->m_properties = properties;
+    d->openContext(QStringLiteral("GraphvizLayouterBackend@%1").arg(addressToString(this)));
+
+    QVector<Agnode_t *> nodes;
+    QVector<Agedge_t *> edges;
+    d->buildRegion(region, &nodes, &edges);
+
+    layout();
+
+    LayoutResult result;
+    {
+        const LocaleLocker _;
+        result.states.reserve(nodes.size());
+        for (int i = 0; i < nodes.size(); ++i) {
+            const QRectF rect = d->rectForNode(nodes.at(i));
+            result.states.append(LayoutResult::StateGeometry { region.states.at(i).state, rect.topLeft(), rect.width(), rect.height() });
+        }
+
+        // transitions are positioned relative to their source state
+        result.transitions.reserve(edges.size());
+        for (int i = 0; i < edges.size(); ++i) {
+            const LayoutRegion::TransitionInput &input = region.transitions.at(i);
+            const QPainterPath path = d->pathForEdge(edges.at(i));
+            const QRectF labelRect = d->labelRectForEdge(edges.at(i));
+            const QPointF absolutePos = labelRect.united(path.boundingRect()).topLeft();
+            const QPointF pos = absolutePos - result.states.at(input.source).pos;
+            result.transitions.append(LayoutResult::TransitionGeometry { input.transition, pos, path.translated(-absolutePos), labelRect.translated(-absolutePos) });
+        }
+        result.boundingRect = d->boundingRectForGraph(d->m_graph);
+    }
+
+    d->closeLayout();
+    return result;
+}
+
 void GraphvizLayouterBackend::buildState(State *state)
 {
     d->buildState(state, d->m_graph);
@@ -644,7 +879,16 @@ void GraphvizLayouterBackend::buildTransition(Transition *transition)
 
 void GraphvizLayouterBackend::import()
 {
-    d->import();
+    LayoutResult result;
+    d->import(&result);
+    result.apply();
+}
+
+LayoutResult GraphvizLayouterBackend::result() const
+{
+    LayoutResult result;
+    d->import(&result);
+    return result;
 }
 
 QRectF GraphvizLayouterBackend::boundingRect() const
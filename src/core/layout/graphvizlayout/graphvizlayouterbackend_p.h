@@ -16,21 +16,30 @@
 #ifndef KDSME_LAYOUT_GRAPHVIZLAYOUTERBACKEND_P_H
 #define KDSME_LAYOUT_GRAPHVIZLAYOUTERBACKEND_P_H
 
+#include "kdsme_core_export.h"
+
+#include <QSet>
 #include <QString>
 #include <clocale>
+#include <locale.h>
+#ifdef Q_OS_MACOS
+#include <xlocale.h>
+#endif
 
 QT_BEGIN_NAMESPACE
 class QRectF;
 QT_END_NAMESPACE
 
 namespace KDSME {
+struct LayoutRegion;
+struct LayoutResult;
 class LayoutProperties;
 class Transition;
 class State;
 class StateMachineScene;
 }
 
-class GraphvizLayouterBackend
+class KDSME_CORE_EXPORT GraphvizLayouterBackend
 {
 public:
     enum LayoutMode
@@ -39,6 +48,12 @@ public:
         NonRecursiveMode ///< Only a direct import of state machine elements
     };
 
+    enum AttributeMode
+    {
+        SymbolAttributes, ///< Attributes are set through symbols declared once per graph
+        NameAttributes ///< Attributes are looked up by name each time, converted from QString
+    };
+
     GraphvizLayouterBackend();
     ~GraphvizLayouterBackend();
 
@@ -53,6 +68,26 @@ public:
     LayoutMode layoutMode() const;
     void setLayoutMode(LayoutMode mode);
 
+    /**
+     * How attributes are set on the Graphviz objects
+     *
+     * NameAttributes is how attributes used to be set, only kept for benchmarking.
+     *
+     * @note Default is SymbolAttributes
+     */
+    AttributeMode attributeMode() const;
+    void setAttributeMode(AttributeMode mode);
+
+    /**
+     * States which keep the current layout of their descendants
+     *
+     * They are laid out as nodes of their current size, their descendants and the transitions
+     * between those are neither built nor imported. No transition may cross their boundary.
+     *
+     * @note Only used in RecursiveMode, default is none
+     */
+    void setReusedStates(const QSet<const KDSME::State *> &states);
+
     void openLayout(KDSME::State *state, const KDSME::LayoutProperties *properties);
     void closeLayout();
 
@@ -71,8 +106,31 @@ public:
 
     void buildTransition(KDSME::Transition *transition);
 
+    /**
+     * Lay out @p region in a context of its own, without touching any element
+     *
+     * Only reads the copied inputs, hence may be called from any thread.
+     * @note Replaces openLayout(), the build*() functions, layout(), result() and closeLayout()
+     */
+    KDSME::LayoutResult computeLayout(const KDSME::LayoutRegion &region, const KDSME::LayoutProperties *properties);
+
+    /**
+     * Run the Graphviz layout on the graph built so far
+     *
+     * @note Safe to call from multiple threads with different backend instances,
+     * the actual Graphviz layout step is serialized internally
+     */
     void layout();
+    /**
+     * Apply the computed layout to the state machine elements
+     */
     void import();
+    /**
+     * Return the computed layout without applying it to the state machine elements
+     *
+     * @sa import()
+     */
+    KDSME::LayoutResult result() const;
 
     QRectF boundingRect() const;
 
@@ -92,18 +150,23 @@ private:
 };
 
 /**
- * RAII-based guard for setting the locale to "C" during this object's lifetime
+ * RAII-based guard for setting the numeric locale to "C" during this object's lifetime
  *
  * Graphviz internally uses atof() and friends to convert strings to numbers, and these are locale-specific.
  * We need to make sure the current locale is "C" so these conversions are done correctly.
  *
+ * Only the locale of the calling thread is changed (uselocale() resp. a per-thread locale on Windows),
+ * so layouts may run in several threads at once without other threads seeing the "C" locale.
+ *
  * Also see: https://marc.info/?l=graphviz-interest&m=129408843223794&w=2
  */
 class LocaleLocker // clazy:exclude=rule-of-three
 {
 public:
+#ifdef Q_OS_WIN
     inline LocaleLocker()
-        : m_oldlocale(qstrdup(setlocale(LC_NUMERIC, nullptr)))
+        : m_oldPerThreadLocale(_configthreadlocale(_ENABLE_PER_THREAD_LOCALE))
+        , m_oldlocale(qstrdup(setlocale(LC_NUMERIC, nullptr)))
     {
         setlocale(LC_NUMERIC, "C");
     }
@@ -112,10 +175,45 @@ public:
     {
         setlocale(LC_NUMERIC, m_oldlocale);
         delete[] m_oldlocale;
+        _configthreadlocale(m_oldPerThreadLocale);
     }
 
 private:
+    const int m_oldPerThreadLocale;
     const char *m_oldlocale;
+#else
+    inline LocaleLocker()
+        : m_locale(createNumericCLocale())
+        , m_oldlocale(m_locale ? uselocale(m_locale) : static_cast<locale_t>(nullptr))
+    {
+    }
+
+    inline ~LocaleLocker()
+    {
+        if (m_locale) {
+            uselocale(m_oldlocale);
+            freelocale(m_locale);
+        }
+    }
+
+private:
+    /// Copy of the calling thread's locale, with only LC_NUMERIC switched to "C"
+    static locale_t createNumericCLocale()
+    {
+        const locale_t base = duplocale(uselocale(static_cast<locale_t>(nullptr)));
+        if (!base) {
+            return base;
+        }
+        const locale_t locale = newlocale(LC_NUMERIC_MASK, "C", base);
+        if (!locale) {
+            freelocale(base);
+        }
+        return locale;
+    }
+
+    const locale_t m_locale;
+    const locale_t m_oldlocale;
+#endif
 };
 
 #endif
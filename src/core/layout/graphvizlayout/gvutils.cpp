@@ -116,12 +116,82 @@ Agraph_t *GVUtils::_agsubg(Agraph_t *graph, const QString &attr, bool create)
 #endif
 }
 
+Agnode_t *GVUtils::_agnode(Agraph_t *graph, const char *name, bool create)
+{
+#ifdef WITH_CGRAPH
+    Agnode_t *n = agnode(graph, const_cast<char *>(name), create);
+    _agbindrec(n, "Agnodeinfo_t", sizeof(Agnodeinfo_t), MOVE_TO_FRONT);
+    return n;
+#else
+    Q_UNUSED(create);
+    return agnode(graph, const_cast<char *>(name));
+#endif
+}
+
+Agedge_t *GVUtils::_agedge(Agraph_t *graph, Agnode_t *tail, Agnode_t *head,
+                           const char *name, bool create)
+{
+#ifdef WITH_CGRAPH
+    Agedge_t *e = agedge(graph, tail, head, const_cast<char *>(name), create);
+    _agbindrec(e, "Agedgeinfo_t", sizeof(Agedgeinfo_t), MOVE_TO_FRONT);
+    return e;
+#else
+    Q_UNUSED(name);
+    Q_UNUSED(create);
+    return agedge(graph, tail, head);
+#endif
+}
+
+Agraph_t *GVUtils::_agsubg(Agraph_t *graph, const char *name, bool create)
+{
+#ifdef WITH_CGRAPH
+    Agraph_t *g = agsubg(graph, const_cast<char *>(name), create);
+    _agbindrec(g, "Agraphinfo_t", sizeof(Agraphinfo_t), MOVE_TO_FRONT);
+    return g;
+#else
+    Q_UNUSED(create);
+    return agsubg(graph, const_cast<char *>(name));
+#endif
+}
+
 int GVUtils::_agset(void *object, const QString &attr, const QString &value)
 {
     return agsafeset(object, attr.toLocal8Bit().data(),
                      value.toLocal8Bit().data(), const_cast<char *>(""));
 }
 
+int GVUtils::_agset(void *object, const char *attr, const char *value)
+{
+    return agsafeset(object, const_cast<char *>(attr),
+                     const_cast<char *>(value), const_cast<char *>(""));
+}
+
+Agsym_t *GVUtils::_agattr(Agraph_t *graph, int kind, const char *name, const char *defaultValue)
+{
+#ifdef WITH_CGRAPH
+    return agattr(graph, kind, const_cast<char *>(name), const_cast<char *>(defaultValue));
+#else
+    switch (kind) {
+    case AGNODE:
+        return agnodeattr(graph, const_cast<char *>(name), const_cast<char *>(defaultValue));
+    case AGEDGE:
+        return agedgeattr(graph, const_cast<char *>(name), const_cast<char *>(defaultValue));
+    default:
+        return agraphattr(graph, const_cast<char *>(name), const_cast<char *>(defaultValue));
+    }
+#endif
+}
+
+int GVUtils::_agxset(void *object, Agsym_t *symbol, const char *value)
+{
+    Q_ASSERT(symbol);
+#ifdef WITH_CGRAPH
+    return agxset(object, symbol, const_cast<char *>(value));
+#else
+    return agxset(object, symbol->index, const_cast<char *>(value));
+#endif
+}
+
 int GVUtils::_gvLayout(GVC_t *gvc, graph_t *g, const char *engine)
 {
     return gvLayout(gvc, g, engine);
@@ -52,8 +52,26 @@ Agedge_t *_agedge(Agraph_t *graph, Agnode_t *tail, Agnode_t *head,
                   const QString &name = QString(), bool create = true);
 Agraph_t *_agsubg(Agraph_t *graph, const QString &attr, bool create = true);
 
+/// Overloads taking names which are already encoded, no conversion takes place
+Agnode_t *_agnode(Agraph_t *graph, const char *name, bool create = true);
+Agedge_t *_agedge(Agraph_t *graph, Agnode_t *tail, Agnode_t *head,
+                  const char *name, bool create = true);
+Agraph_t *_agsubg(Agraph_t *graph, const char *name, bool create = true);
+
 /// Directly use agsafeset which always works, contrarily to agset
 int _agset(void *object, const QString &attr, const QString &value);
+int _agset(void *object, const char *attr, const char *value);
+
+/**
+ * Declare attribute @p name for all objects of type @p kind (AGRAPH, AGNODE or AGEDGE) in @p graph
+ *
+ * The returned symbol can be used with _agxset(), which avoids looking the attribute up by name
+ * each time it is set. Must be called on the root graph, subgraphs share its symbols.
+ */
+Agsym_t *_agattr(Agraph_t *graph, int kind, const char *name, const char *defaultValue = "");
+
+/// Set the value of the attribute declared as @p symbol on @p object
+int _agxset(void *object, Agsym_t *symbol, const char *value);
 
 }
 
@@ -22,37 +22,30 @@
 #include "graphvizlayout/graphvizlayouter.h"
 #endif
 #include "layoutproperties.h"
+#include "layoutresult.h"
 #include "layoututils.h"
 #include "elementwalker.h"
 #include "element.h"
+#include "objecthelper.h"
+#include "remotelayouter.h"
 #include "state.h"
+#include "sugiyamalayouter.h"
 #include "transition.h"
 
 #include "debug.h"
 #include <QElapsedTimer>
+#include <QFileInfo>
 #include <QFontMetrics>
+#include <QMutex>
 #include <QRectF>
+#include <QThreadPool>
 
 using namespace KDSME;
 
 namespace {
 
-QRectF boundingRectForCollapsedRegion(State *state, const LayoutProperties *prop)
-{
-    static const QRectF minimumSize(0, 0, 100, 20);
-
-    Q_ASSERT(state);
-    if (!state) {
-        return minimumSize;
-    }
-
-    const QString label = state->label();
-    const QFontMetricsF fm(prop->regionLabelFont());
-    const qreal width = fm.horizontalAdvance(label);
-    const qreal height = fm.height();
-    const qreal margin = prop->regionLabelMargins();
-    return QRectF(0, 0, width + prop->regionLabelButtonBoxSize().width() + 2 * margin, height + 2 * margin);
-}
+/// Time in milliseconds a worker process may take for a single region
+const int REGION_TIMEOUT = 30000;
 
 }
 
@@ -92,6 +85,8 @@ LayerwiseLayouter::LayerwiseLayouter(QObject *parent)
 #endif
     , m_regionLayouter(new RegionLayouter(this))
     , m_properties(nullptr)
+    , m_parallel(false)
+    , m_threadPool(nullptr)
 {
     qCDebug(KDSME_CORE) << "Using" << m_layerLayouter << "as layouter";
 }
@@ -101,12 +96,136 @@ QRectF LayerwiseLayouter::layout(State *state, const LayoutProperties *propertie
     Q_ASSERT(state);
     m_properties = properties;
 
-    ElementWalker walker(ElementWalker::PostOrderTraversal);
-    walker.walkItems(state, [&](Element *element) { return layoutState(element); });
+    beginLayout(state, properties);
+
+    if (m_parallel) {
+        layoutParallel(state);
+    } else {
+        ElementWalker walker(ElementWalker::PostOrderTraversal);
+        walker.walkItems(state, [&](Element *element) { return layoutState(element); });
+    }
+
+    endLayout();
 
     return QRect();
 }
 
+bool LayerwiseLayouter::isParallel() const
+{
+    return m_parallel;
+}
+
+void LayerwiseLayouter::setParallel(bool parallel)
+{
+    if (m_parallel == parallel)
+        return;
+
+    m_parallel = parallel;
+    Q_EMIT parallelChanged(m_parallel);
+}
+
+void LayerwiseLayouter::layoutParallel(State *root)
+{
+    // Group the regions by nesting level: a region only depends on the sizes
+    // of its child regions, which are laid out one level below
+    QVector<QVector<State *>> levels;
+    ElementWalker walker(ElementWalker::PreOrderTraversal);
+    walker.walkItems(root, [&](Element *element) {
+        auto *state = qobject_cast<State *>(element);
+        if (state && !state->childStates().isEmpty() && isDirty(state)) {
+            const int level = ObjectHelper::depth(root, state);
+            if (levels.size() <= level) {
+                levels.resize(level + 1);
+            }
+            levels[level].append(state);
+        }
+        return ElementWalker::RecursiveWalk;
+    });
+
+    if (!m_threadPool) {
+        m_threadPool = new QThreadPool(this);
+#if HAVE_GRAPHVIZ
+        for (int i = 0; i < m_threadPool->maxThreadCount(); ++i) {
+            m_workerLayerLayouters.append(new GraphvizLayerLayouter(this));
+        }
+#endif
+    }
+
+#if HAVE_GRAPHVIZ
+    QMutex mutex;
+    QVector<GraphvizLayerLayouter *> idleLayerLayouters = m_workerLayerLayouters;
+    // Graphviz lays out one graph at a time per process, see layoutMutex(), hence the
+    // regions go to the worker processes, the in-process layouters are only a fallback
+    const bool useWorkers = QFileInfo(RemoteLayouter::workerProgram()).isExecutable();
+#endif
+
+    for (int level = levels.size() - 1; level >= 0; --level) {
+        QVector<State *> regions;
+        QVector<QByteArray> cacheKeys;
+        for (State *state : levels.at(level)) {
+            QByteArray cacheKey;
+            if (!restoreFromCache(state, m_properties, &cacheKey)) {
+                regions.append(state);
+                cacheKeys.append(cacheKey);
+            }
+        }
+
+        // the workers only get copies of the inputs, the elements are read in this thread only
+        QVector<LayoutRegion> inputs(regions.size());
+        for (int i = 0; i < regions.size(); ++i) {
+            if (regions.at(i)->isExpanded()) {
+                inputs[i] = LayoutRegion::fromState(regions.at(i));
+            }
+        }
+
+        QVector<LayoutResult> results(regions.size());
+        LayoutResult *resultData = results.data(); // written to by the workers
+
+        for (int i = 0; i < regions.size(); ++i) {
+            if (!regions.at(i)->isExpanded()) {
+                continue;
+            }
+
+            const LayoutRegion *input = &inputs.at(i);
+            m_threadPool->start([&, i, input]() {
+#if HAVE_GRAPHVIZ
+                if (useWorkers && RemoteLayouter::layoutRegion(*input, m_properties, REGION_TIMEOUT, &resultData[i])) {
+                    return;
+                }
+
+                GraphvizLayerLayouter *layerLayouter = nullptr;
+                {
+                    const QMutexLocker locker(&mutex);
+                    layerLayouter = idleLayerLayouters.takeLast();
+                }
+                resultData[i] = layerLayouter->computeLayout(*input, m_properties);
+
+                const QMutexLocker locker(&mutex);
+                idleLayerLayouters.append(layerLayouter);
+#else
+                resultData[i] = SugiyamaLayouter::computeLayout(*input, m_properties);
+#endif
+            });
+        }
+        m_threadPool->waitForDone();
+
+        // Apply the results in the thread owning the elements, then size the
+        // regions before moving on to the parent level
+        for (int i = 0; i < regions.size(); ++i) {
+            State *state = regions.at(i);
+            QRectF boundingRect;
+            if (state->isExpanded()) {
+                resultData[i].apply();
+                boundingRect = resultData[i].boundingRect;
+            } else {
+                boundingRect = LayoutUtils::boundingRectForCollapsedRegion(state, m_properties);
+            }
+            m_regionLayouter->layoutRegion(state, boundingRect, m_properties);
+            storeInCache(state, cacheKeys.at(i), boundingRect);
+        }
+    }
+}
+
 ElementWalker::VisitResult LayerwiseLayouter::layoutState(Element *element)
 {
     auto *state = qobject_cast<State *>(element);
@@ -114,19 +233,36 @@ ElementWalker::VisitResult LayerwiseLayouter::layoutState(Element *element)
         return ElementWalker::RecursiveWalk;
     }
 
+    // in incremental mode, regions which did not change keep their previous layout
+    if (!isDirty(state)) {
+        return ElementWalker::RecursiveWalk;
+    }
+
+    QByteArray cacheKey;
+    if (restoreFromCache(state, m_properties, &cacheKey)) {
+        return ElementWalker::RecursiveWalk;
+    }
+
     QRectF boundingRect;
 #if HAVE_GRAPHVIZ
     if (state->isExpanded()) {
         boundingRect = m_layerLayouter->layout(state, m_properties);
     } else {
-        boundingRect = boundingRectForCollapsedRegion(state, m_properties);
+        boundingRect = LayoutUtils::boundingRectForCollapsedRegion(state, m_properties);
     }
 #else
-    // let's just show collapsed states in this case
-    boundingRect = boundingRectForCollapsedRegion(state, m_properties);
+    // no Graphviz around, fall back to the built-in layered layout
+    if (state->isExpanded()) {
+        const LayoutResult result = SugiyamaLayouter::computeLayout(state, m_properties);
+        result.apply();
+        boundingRect = result.boundingRect;
+    } else {
+        boundingRect = LayoutUtils::boundingRectForCollapsedRegion(state, m_properties);
+    }
 #endif
 
     m_regionLayouter->layoutRegion(state, boundingRect, m_properties);
+    storeInCache(state, cacheKey, boundingRect);
 
     return ElementWalker::RecursiveWalk;
 }
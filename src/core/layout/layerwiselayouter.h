@@ -22,6 +22,11 @@
 #include "elementwalker.h"
 
 #include <QtCore/qglobal.h>
+#include <QVector>
+
+QT_BEGIN_NAMESPACE
+class QThreadPool;
+QT_END_NAMESPACE
 
 namespace KDSME {
 
@@ -41,18 +46,47 @@ public:
 class KDSME_CORE_EXPORT LayerwiseLayouter : public Layouter
 {
     Q_OBJECT
+    Q_PROPERTY(bool parallel READ isParallel WRITE setParallel NOTIFY parallelChanged FINAL)
 
 public:
-    explicit LayerwiseLayouter(QObject *parent = nullptr);
+    Q_INVOKABLE explicit LayerwiseLayouter(QObject *parent = nullptr);
 
     QRectF layout(State *state, const LayoutProperties *properties) override;
 
+    /**
+     * Whether sibling regions are laid out concurrently on a worker pool
+     *
+     * Regions on the same nesting level do not depend on each other, they are
+     * laid out in parallel, and the results get applied before continuing with
+     * the parent level. The inputs of each region are copied in the calling
+     * thread, the workers never read the elements.
+     *
+     * Graphviz keeps process-global state while laying out, so one process only
+     * lays out one graph at a time. With Graphviz, the regions are therefore sent
+     * to the RemoteLayouter worker processes, see RemoteLayouter::workerProgram().
+     * In case the worker is not available, they are laid out in-process and only
+     * building the graphs and reading back the results overlap, which gains little.
+     *
+     * @note Default is false
+     */
+    bool isParallel() const;
+    void setParallel(bool parallel);
+
+Q_SIGNALS:
+    void parallelChanged(bool parallel);
+
 private:
     ElementWalker::VisitResult layoutState(Element *element);
+    void layoutParallel(State *root);
 
     GraphvizLayerLayouter *m_layerLayouter;
     RegionLayouter *m_regionLayouter;
     const LayoutProperties *m_properties;
+
+    bool m_parallel;
+    QThreadPool *m_threadPool;
+    /// One layer layouter per worker thread, each with its own backend
+    QVector<GraphvizLayerLayouter *> m_workerLayerLayouters;
 };
 
 }
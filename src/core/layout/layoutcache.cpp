@@ -0,0 +1,281 @@
+/*
+  This file is part of the KDAB State Machine Editor Library.
+
+  SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company <info@kdab.com>
+
+  SPDX-License-Identifier: LGPL-2.1-only OR LicenseRef-KDAB-KDStateMachineEditor
+
+  Licensees holding valid commercial KDAB State Machine Editor Library
+  licenses may use this file in accordance with the KDAB State Machine Editor
+  Library License Agreement provided with the Software.
+
+  Contact info@kdab.com if any conditions of this licensing are not clear to you.
+*/
+
+#include "layoutcache.h"
+
+#include "layoutimportexport.h"
+#include "layoutproperties.h"
+#include "state.h"
+#include "transition.h"
+
+#include "debug.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRectF>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QVector>
+
+using namespace KDSME;
+
+namespace {
+
+/// Bump whenever the hashed structure or the stored data changes
+const int CACHE_FORMAT_VERSION = 1;
+
+/// Indices of the states on the way from @p root down to @p state, empty if @p state is not a descendant of @p root
+QVector<int> indexPath(const State *root, const State *state)
+{
+    QVector<int> path;
+    while (state && state != root) {
+        const State *parent = state->parentState();
+        if (!parent) {
+            return {};
+        }
+        path.prepend(parent->childStates().indexOf(const_cast<State *>(state)));
+        state = parent;
+    }
+    return state ? path : QVector<int>();
+}
+
+void writeStructure(QDataStream &stream, const State *root, const State *state)
+{
+    stream << static_cast<int>(state->type()) << state->label() << state->isExpanded()
+           << static_cast<int>(state->childMode());
+    if (const auto *pseudoState = qobject_cast<const PseudoState *>(state)) {
+        stream << static_cast<int>(pseudoState->kind());
+    } else if (const auto *historyState = qobject_cast<const HistoryState *>(state)) {
+        stream << static_cast<int>(historyState->historyType());
+    }
+
+    const auto childStates = state->childStates();
+    if (childStates.isEmpty()) {
+        // only leaf states have their size as input, the size of composite states is computed
+        stream << state->width() << state->height();
+    }
+
+    stream << static_cast<qint32>(childStates.size());
+    for (const State *child : childStates) {
+        writeStructure(stream, root, child);
+    }
+
+    const auto transitions = state->transitions();
+    stream << static_cast<qint32>(transitions.size());
+    for (const Transition *transition : transitions) {
+        stream << static_cast<int>(transition->type()) << transition->label()
+               << indexPath(root, transition->targetState()) << (transition->targetState() != nullptr);
+    }
+}
+
+void writeProperties(QDataStream &stream, const LayoutProperties *properties)
+{
+    stream << properties->regionMargins() << properties->regionLabelFont().toString()
+           << properties->regionLabelMargins() << properties->regionLabelButtonBoxSize()
+           << properties->showTransitionLabels();
+}
+
+QJsonObject rectToJson(const QRectF &rect)
+{
+    QJsonObject res;
+    res[u"x"] = rect.x();
+    res[u"y"] = rect.y();
+    res[u"width"] = rect.width();
+    res[u"height"] = rect.height();
+    return res;
+}
+
+QRectF rectFromJson(const QJsonObject &data)
+{
+    return QRectF(data.value(u"x").toDouble(), data.value(u"y").toDouble(),
+                  data.value(u"width").toDouble(), data.value(u"height").toDouble());
+}
+
+}
+
+struct LayoutCache::Private
+{
+    QString filePath(const QByteArray &key) const;
+    QFileInfoList entries() const;
+    /// Size of all entries, only scanned from disk the first time
+    qint64 size() const;
+    /// Remove the least recently used entries until the size is within the limit
+    void evict();
+
+    QDir m_directory;
+    qint64 m_maximumSize = 32 * 1024 * 1024;
+    mutable qint64 m_size = -1;
+};
+
+QString LayoutCache::Private::filePath(const QByteArray &key) const
+{
+    return m_directory.filePath(QString::fromLatin1(key) + u".json");
+}
+
+QFileInfoList LayoutCache::Private::entries() const
+{
+    // oldest modification time first, restore() touches the entries it uses
+    return m_directory.entryInfoList({ QStringLiteral("*.json") }, QDir::Files, QDir::Time | QDir::Reversed);
+}
+
+qint64 LayoutCache::Private::size() const
+{
+    if (m_size < 0) {
+        m_size = 0;
+        const auto infos = entries();
+        for (const QFileInfo &info : infos) {
+            m_size += info.size();
+        }
+    }
+    return m_size;
+}
+
+void LayoutCache::Private::evict()
+{
+    if (size() <= m_maximumSize) {
+        return;
+    }
+
+    const auto infos = entries();
+    for (const QFileInfo &info : infos) {
+        if (m_size <= m_maximumSize) {
+            break;
+        }
+        if (QFile::remove(info.filePath())) {
+            m_size -= info.size();
+        }
+    }
+}
+
+LayoutCache::LayoutCache(const QString &directory)
+    : d(new Private)
+{
+    if (directory.isEmpty()) {
+        d->m_directory.setPath(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + u"/layouts");
+    } else {
+        d->m_directory.setPath(directory);
+    }
+}
+
+LayoutCache::~LayoutCache()
+{
+}
+
+QString LayoutCache::directory() const
+{
+    return d->m_directory.path();
+}
+
+qint64 LayoutCache::maximumSize() const
+{
+    return d->m_maximumSize;
+}
+
+void LayoutCache::setMaximumSize(qint64 bytes)
+{
+    d->m_maximumSize = bytes;
+    d->evict();
+}
+
+qint64 LayoutCache::size() const
+{
+    return d->size();
+}
+
+QByteArray LayoutCache::key(const State *state, const LayoutProperties *properties, const QByteArray &layouterName)
+{
+    Q_ASSERT(state);
+    Q_ASSERT(properties);
+
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_6_0);
+    stream << CACHE_FORMAT_VERSION << layouterName;
+    writeProperties(stream, properties);
+    writeStructure(stream, state, state);
+
+    return QCryptographicHash::hash(data, QCryptographicHash::Sha1).toHex();
+}
+
+bool LayoutCache::restore(State *state, const LayoutProperties *properties, const QByteArray &layouterName, QRectF *boundingRect) const
+{
+    return restore(state, key(state, properties, layouterName), boundingRect);
+}
+
+bool LayoutCache::restore(State *state, const QByteArray &key, QRectF *boundingRect) const
+{
+    QFile file(d->filePath(key));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    const QJsonObject data = QJsonDocument::fromJson(file.readAll()).object();
+    const QJsonObject layout = data.value(u"layout").toObject();
+    if (!LayoutImportExport::matches(layout, state)) {
+        qCDebug(KDSME_CORE) << "Ignoring stale layout cache entry:" << file.fileName();
+        return false;
+    }
+
+    // keeps the entry from being evicted soon
+    file.setFileTime(QDateTime::currentDateTimeUtc(), QFileDevice::FileModificationTime);
+
+    LayoutImportExport::importLayout(layout, state);
+    if (boundingRect) {
+        *boundingRect = rectFromJson(data.value(u"boundingRect").toObject());
+    }
+    return true;
+}
+
+void LayoutCache::store(const State *state, const QByteArray &key, const QRectF &boundingRect)
+{
+    if (!d->m_directory.mkpath(QStringLiteral("."))) {
+        qCWarning(KDSME_CORE) << "Cannot create layout cache directory:" << d->m_directory.path();
+        return;
+    }
+
+    QJsonObject data;
+    data[u"boundingRect"] = rectToJson(boundingRect);
+    data[u"layout"] = LayoutImportExport::exportLayout(state);
+
+    // before writing, an existing entry gets replaced
+    const QFileInfo oldEntry(d->filePath(key));
+    const qint64 oldSize = d->size() - (oldEntry.exists() ? oldEntry.size() : 0);
+    QSaveFile file(oldEntry.filePath());
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(KDSME_CORE) << "Cannot write layout cache entry:" << file.fileName();
+        return;
+    }
+    const qint64 written = file.write(QJsonDocument(data).toJson(QJsonDocument::Compact));
+    if (!file.commit()) {
+        return;
+    }
+
+    d->m_size = oldSize + written;
+    d->evict();
+}
+
+void LayoutCache::clear()
+{
+    const auto entries = d->m_directory.entryList({ QStringLiteral("*.json") }, QDir::Files);
+    for (const QString &entry : entries) {
+        d->m_directory.remove(entry);
+    }
+    d->m_size = -1;
+}
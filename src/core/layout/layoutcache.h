@@ -0,0 +1,107 @@
+/*
+  This file is part of the KDAB State Machine Editor Library.
+
+  SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company <info@kdab.com>
+
+  SPDX-License-Identifier: LGPL-2.1-only OR LicenseRef-KDAB-KDStateMachineEditor
+
+  Licensees holding valid commercial KDAB State Machine Editor Library
+  licenses may use this file in accordance with the KDAB State Machine Editor
+  Library License Agreement provided with the Software.
+
+  Contact info@kdab.com if any conditions of this licensing are not clear to you.
+*/
+
+#ifndef KDSME_LAYOUT_LAYOUTCACHE_H
+#define KDSME_LAYOUT_LAYOUTCACHE_H
+
+#include "kdsme_core_export.h"
+
+#include <QByteArray>
+#include <QScopedPointer>
+#include <QString>
+
+QT_BEGIN_NAMESPACE
+class QRectF;
+QT_END_NAMESPACE
+
+namespace KDSME {
+
+class LayoutProperties;
+class State;
+
+/**
+ * @brief Persistent on-disk cache of layout results
+ *
+ * Entries are keyed by a hash of the structure of a state and its descendants (types, labels,
+ * expanded flags, child modes, transitions and sizes of leaf states), the layout properties and
+ * the name of the layouter. The stored data is the one of LayoutImportExport::exportLayout().
+ *
+ * Since laying out changes the sizes of leaf states, the key has to be computed before laying out
+ * and passed to store() afterwards.
+ *
+ * The entries are bounded by maximumSize(), the least recently used ones get removed first.
+ *
+ * @sa Layouter::setCache()
+ */
+class KDSME_CORE_EXPORT LayoutCache
+{
+public:
+    /**
+     * Create a cache storing its entries in @p directory
+     *
+     * In case @p directory is empty, a "layouts" subdirectory of QStandardPaths::CacheLocation is used.
+     */
+    explicit LayoutCache(const QString &directory = QString());
+    ~LayoutCache();
+
+    QString directory() const;
+
+    /**
+     * Maximum size of all entries in bytes
+     *
+     * store() removes the least recently stored or restored entries beyond that.
+     *
+     * @note Default is 32 MiB
+     */
+    qint64 maximumSize() const;
+    void setMaximumSize(qint64 bytes);
+    /// Size of all entries in bytes
+    qint64 size() const;
+
+    /**
+     * @return The key identifying the layout of @p state as computed by @p layouterName
+     */
+    static QByteArray key(const State *state, const LayoutProperties *properties, const QByteArray &layouterName);
+
+    /**
+     * Restore the layout of @p state and its descendants, if cached
+     *
+     * @p boundingRect is set to the bounding rect the layouter returned back then.
+     * @return True in case the layout was found in the cache and applied to @p state
+     */
+    bool restore(State *state, const LayoutProperties *properties, const QByteArray &layouterName, QRectF *boundingRect = nullptr) const;
+    /// Same as above, with @p key as returned by key()
+    bool restore(State *state, const QByteArray &key, QRectF *boundingRect = nullptr) const;
+
+    /**
+     * Store the current layout of @p state and its descendants under @p key
+     *
+     * @p key must have been computed by key() before @p state got laid out. Removes the least recently
+     * used entries in case the cache grows beyond maximumSize().
+     */
+    void store(const State *state, const QByteArray &key, const QRectF &boundingRect);
+
+    /// Remove all entries
+    void clear();
+
+private:
+    Q_DISABLE_COPY(LayoutCache)
+
+    struct Private;
+    QScopedPointer<Private> d;
+};
+
+}
+
+#endif // KDSME_LAYOUT_LAYOUTCACHE_H
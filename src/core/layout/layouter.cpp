@@ -15,9 +15,289 @@
 
 #include "layouter.h"
 
+#include "elementwalker.h"
+#include "layoutcache.h"
+#include "layoutproperties.h"
+#include "state.h"
+#include "transition.h"
+
+#include <QEvent>
+#include <QMetaProperty>
+#include <QRectF>
+#include <QPointer>
+#include <QSet>
+
 using namespace KDSME;
 
+struct Layouter::Private
+{
+    void watch(Layouter *q, Element *element);
+    /// Stop tracking changes of all elements, e.g. because they are not laid out anymore
+    void unwatchAll(Layouter *q);
+
+    bool m_incremental = false;
+    bool m_fullLayoutRequired = true;
+    LayoutCache *m_cache = nullptr;
+
+    QPointer<State> m_root;
+    QPointer<const LayoutProperties> m_properties;
+    QRectF m_lastBoundingRect;
+
+    /// Bumped on every change, allows telling which changes a clone already saw
+    quint64 m_generation = 0;
+    /// Generation in which a full layout got requested last
+    quint64 m_fullLayoutGeneration = 0;
+    /// States which need to be laid out again, with the generation they were changed in last
+    QHash<const Element *, quint64> m_dirtyStates;
+    /// Elements we are currently tracking changes of
+    QSet<Element *> m_watchedElements;
+};
+
+void Layouter::Private::watch(Layouter *q, Element *element)
+{
+    if (m_watchedElements.contains(element)) {
+        return;
+    }
+    m_watchedElements.insert(element);
+
+    QObject::connect(element, &QObject::destroyed, q, [this, element]() {
+        m_watchedElements.remove(element);
+        m_dirtyStates.remove(element);
+    });
+    QObject::connect(element, &Element::labelChanged, q, [q, element]() { q->invalidate(element); });
+
+    if (auto *state = qobject_cast<State *>(element)) {
+        QObject::connect(state, &State::expandedChanged, q, [q, state]() { q->invalidate(state); });
+        QObject::connect(state, &State::childModeChanged, q, [q, state]() { q->invalidate(state); });
+        // catch added, removed and reparented child elements
+        state->installEventFilter(q);
+    } else if (auto *transition = qobject_cast<Transition *>(element)) {
+        QObject::connect(transition, &Transition::targetStateChanged, q, [q, transition]() { q->invalidate(transition); });
+    }
+}
+
+void Layouter::Private::unwatchAll(Layouter *q)
+{
+    // the elements are only ever connected to the layouter by watch()
+    for (Element *element : std::as_const(m_watchedElements)) {
+        QObject::disconnect(element, nullptr, q, nullptr);
+        element->removeEventFilter(q);
+    }
+    m_watchedElements.clear();
+}
+
 Layouter::Layouter(QObject *parent)
     : QObject(parent)
+    , d(new Private)
+{
+}
+
+Layouter::~Layouter()
+{
+}
+
+bool Layouter::isIncremental() const
+{
+    return d->m_incremental;
+}
+
+void Layouter::setIncremental(bool incremental)
+{
+    if (d->m_incremental == incremental)
+        return;
+
+    d->m_incremental = incremental;
+    if (!d->m_incremental) {
+        d->unwatchAll(this);
+    }
+    // we did not track anything while not being in incremental mode
+    invalidateAll();
+    Q_EMIT incrementalChanged(d->m_incremental);
+}
+
+void Layouter::invalidate(Element *element)
+{
+    if (!element)
+        return;
+
+    // still recorded while a full layout is pending, a clone may have taken care of that already
+    const quint64 generation = ++d->m_generation;
+    for (const Element *current = element; current; current = current->parentElement()) {
+        if (qobject_cast<const State *>(current)) {
+            d->m_dirtyStates.insert(current, generation);
+        }
+    }
+}
+
+void Layouter::invalidateAll()
+{
+    d->m_fullLayoutRequired = true;
+    d->m_fullLayoutGeneration = ++d->m_generation;
+    d->m_dirtyStates.clear();
+}
+
+void Layouter::beginLayout(State *root, const LayoutProperties *properties)
+{
+    if (d->m_root != root) {
+        d->unwatchAll(this);
+        d->m_root = root;
+        invalidateAll();
+    }
+
+    if (d->m_properties != properties) {
+        if (d->m_properties) {
+            disconnect(d->m_properties, &LayoutProperties::changed, this, &Layouter::invalidateAll);
+        }
+        d->m_properties = properties;
+        if (d->m_properties) {
+            connect(d->m_properties, &LayoutProperties::changed, this, &Layouter::invalidateAll);
+        }
+        invalidateAll();
+    }
+}
+
+void Layouter::endLayout()
+{
+    d->m_fullLayoutRequired = false;
+    d->m_dirtyStates.clear();
+    watchRoot();
+}
+
+void Layouter::watchRoot()
+{
+    if (!d->m_incremental || !d->m_root) {
+        return;
+    }
+
+    ElementWalker walker(ElementWalker::PreOrderTraversal);
+    walker.walkItems(d->m_root, [this](Element *element) {
+        d->watch(this, element);
+        return ElementWalker::RecursiveWalk;
+    });
+}
+
+LayoutCache *Layouter::cache() const
+{
+    return d->m_cache;
+}
+
+void Layouter::setCache(LayoutCache *cache)
+{
+    d->m_cache = cache;
+}
+
+Layouter *Layouter::clone() const
+{
+    auto *copy = qobject_cast<Layouter *>(metaObject()->newInstance());
+    if (!copy) {
+        return nullptr;
+    }
+
+    const QMetaObject *metaObject = this->metaObject();
+    for (int i = 0; i < metaObject->propertyCount(); ++i) {
+        const QMetaProperty property = metaObject->property(i);
+        if (!property.isWritable() || !property.isStored()
+            || (property.metaType().flags() & QMetaType::PointerToQObject)) {
+            continue;
+        }
+        property.write(copy, property.read(this));
+    }
+    copy->setCache(d->m_cache);
+    return copy;
+}
+
+bool Layouter::mayBlock() const
+{
+    return false;
+}
+
+quint64 Layouter::prepareClone(Layouter *clone, State *root, const LayoutProperties *properties,
+                               const LayoutProperties *propertiesCopy, const QHash<const Element *, Element *> &copies)
+{
+    Q_ASSERT(clone);
+
+    // from now on, the changes are tracked against root and properties
+    beginLayout(root, properties);
+
+    clone->d->m_root = qobject_cast<State *>(copies.value(root));
+    clone->d->m_properties = propertiesCopy;
+    clone->d->m_lastBoundingRect = d->m_lastBoundingRect;
+    clone->d->m_fullLayoutRequired = d->m_fullLayoutRequired;
+    clone->d->m_dirtyStates.clear();
+    for (auto it = d->m_dirtyStates.constBegin(); it != d->m_dirtyStates.constEnd(); ++it) {
+        if (const Element *copy = copies.value(it.key())) {
+            clone->d->m_dirtyStates.insert(copy, 0);
+        }
+    }
+    return d->m_generation;
+}
+
+void Layouter::cloneLayoutApplied(State *root, const QRectF &boundingRect, quint64 token)
+{
+    if (d->m_root != root) {
+        return; // laid out something else in the meantime
+    }
+
+    d->m_lastBoundingRect = boundingRect;
+    if (d->m_fullLayoutGeneration <= token) {
+        d->m_fullLayoutRequired = false;
+    }
+    for (auto it = d->m_dirtyStates.begin(); it != d->m_dirtyStates.end();) {
+        if (it.value() <= token) {
+            it = d->m_dirtyStates.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    watchRoot();
+}
+
+bool Layouter::isDirty(const State *state) const
+{
+    return !d->m_incremental || d->m_fullLayoutRequired || d->m_dirtyStates.contains(state);
+}
+
+QRectF Layouter::lastBoundingRect() const
+{
+    return d->m_lastBoundingRect;
+}
+
+void Layouter::setLastBoundingRect(const QRectF &boundingRect)
+{
+    d->m_lastBoundingRect = boundingRect;
+}
+
+bool Layouter::restoreFromCache(State *state, const LayoutProperties *properties, QByteArray *key, QRectF *boundingRect) const
+{
+    Q_ASSERT(key);
+    key->clear();
+    if (!d->m_cache) {
+        return false;
+    }
+
+    *key = LayoutCache::key(state, properties, metaObject()->className());
+    if (d->m_cache->restore(state, *key, boundingRect)) {
+        key->clear();
+        return true;
+    }
+    return false;
+}
+
+void Layouter::storeInCache(const State *state, const QByteArray &key, const QRectF &boundingRect) const
+{
+    if (!d->m_cache || key.isEmpty()) {
+        return;
+    }
+
+    d->m_cache->store(state, key, boundingRect);
+}
+
+bool Layouter::eventFilter(QObject *object, QEvent *event)
 {
+    if (event->type() == QEvent::ChildAdded || event->type() == QEvent::ChildRemoved) {
+        if (auto *state = qobject_cast<State *>(object)) {
+            invalidate(state);
+        }
+    }
+    return QObject::eventFilter(object, event);
 }
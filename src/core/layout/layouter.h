@@ -19,6 +19,7 @@
 #include "kdsme_core_export.h"
 
 #include <QObject>
+#include <QHash>
 #include <QList>
 
 QT_BEGIN_NAMESPACE
@@ -27,17 +28,145 @@ QT_END_NAMESPACE
 
 namespace KDSME {
 
+class Element;
+class LayoutCache;
 class LayoutProperties;
 class State;
 
 class KDSME_CORE_EXPORT Layouter : public QObject
 {
     Q_OBJECT
+    Q_PROPERTY(bool incremental READ isIncremental WRITE setIncremental NOTIFY incrementalChanged FINAL)
 
 public:
     explicit Layouter(QObject *parent = nullptr);
+    ~Layouter();
 
     virtual QRectF layout(State *state, const LayoutProperties *properties) = 0;
+
+    /**
+     * Whether this layouter tracks changes of the elements it has laid out
+     *
+     * In incremental mode, changes to labels, expanded flags, child modes or
+     * the element hierarchy mark the enclosing region (and all its ancestors) dirty.
+     * The next call to layout() may then reuse the previous results for everything else.
+     *
+     * @note Default is false
+     */
+    bool isIncremental() const;
+    void setIncremental(bool incremental);
+
+    /**
+     * Mark the region enclosing @p element and all its ancestors as dirty
+     */
+    void invalidate(KDSME::Element *element);
+    /**
+     * Mark everything as dirty, the next call to layout() will do a full layout
+     */
+    void invalidateAll();
+
+    /**
+     * Cache used to restore layouts of unchanged regions across sessions
+     *
+     * @note Default is nullptr, i.e. no caching. The cache is not owned by the layouter.
+     */
+    LayoutCache *cache() const;
+    void setCache(LayoutCache *cache);
+
+    /**
+     * Create a layouter with the same settings, used to lay out copies of the elements in another thread
+     *
+     * The default implementation creates a new instance through the Q_INVOKABLE constructor, then
+     * copies all stored properties and the cache.
+     *
+     * @return nullptr in case this layouter cannot be copied
+     * @sa LayoutSnapshot
+     */
+    virtual Layouter *clone() const;
+
+    /**
+     * Whether layout() may block for a long time, e.g. because it waits for another process
+     *
+     * StateMachineScene never calls layout() of such layouters in the user interface thread,
+     * but always lays out in the background.
+     *
+     * @note Default is false
+     */
+    virtual bool mayBlock() const;
+
+    /**
+     * Prepare @p clone, as returned by clone(), to lay out the copies of @p root and its descendants
+     *
+     * @p copies maps the elements to their copies, @p propertiesCopy is the copy of @p properties.
+     * In incremental mode, the clone only lays out again what changed since the last layout of this
+     * layouter.
+     *
+     * @return The token to pass to cloneLayoutApplied()
+     */
+    quint64 prepareClone(Layouter *clone, State *root, const LayoutProperties *properties,
+                         const LayoutProperties *propertiesCopy, const QHash<const Element *, Element *> &copies);
+    /**
+     * Notify this layouter that the result of the clone prepared with @p token got applied to @p root
+     *
+     * Changes made after prepareClone() stay pending.
+     */
+    void cloneLayoutApplied(State *root, const QRectF &boundingRect, quint64 token);
+
+Q_SIGNALS:
+    void incrementalChanged(bool incremental);
+
+protected:
+    /**
+     * Must be called by subclasses at the start of layout()
+     *
+     * Requests a full layout in case @p root or @p properties changed since the last run
+     */
+    void beginLayout(State *root, const LayoutProperties *properties);
+    /**
+     * Must be called by subclasses at the end of layout()
+     *
+     * Clears the dirty state and starts tracking elements which were not known yet
+     */
+    void endLayout();
+
+    /**
+     * @return True in case @p state needs to be laid out again
+     *
+     * @note Always true if not in incremental mode
+     */
+    bool isDirty(const State *state) const;
+
+    /**
+     * Bounding rect returned by the last layout run, invalid if there was none
+     *
+     * Allows returning early from layout() in case nothing changed.
+     */
+    QRectF lastBoundingRect() const;
+    void setLastBoundingRect(const QRectF &boundingRect);
+
+    /**
+     * Restore the layout of @p state from the cache, if any
+     *
+     * Must be called before laying out @p state. On a cache miss, @p key is set to the key to pass
+     * to storeInCache() after laying out, the layout changes the sizes the key is computed from.
+     *
+     * @return True in case @p state and its descendants were laid out from the cache
+     */
+    bool restoreFromCache(State *state, const LayoutProperties *properties, QByteArray *key, QRectF *boundingRect = nullptr) const;
+    /**
+     * Store the layout of @p state and its descendants in the cache under @p key, if there is a cache
+     *
+     * Does nothing in case @p key is empty.
+     */
+    void storeInCache(const State *state, const QByteArray &key, const QRectF &boundingRect) const;
+
+    bool eventFilter(QObject *object, QEvent *event) override;
+
+private:
+    void watchRoot();
+
+    struct Private;
+    QScopedPointer<Private> d;
 };
 
 }
@@ -0,0 +1,64 @@
+/*
+  This file is part of the KDAB State Machine Editor Library.
+
+  SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company <info@kdab.com>
+
+  SPDX-License-Identifier: LGPL-2.1-only OR LicenseRef-KDAB-KDStateMachineEditor
+
+  Licensees holding valid commercial KDAB State Machine Editor Library
+  licenses may use this file in accordance with the KDAB State Machine Editor
+  Library License Agreement provided with the Software.
+
+  Contact info@kdab.com if any conditions of this licensing are not clear to you.
+*/
+
+#include "layoutresult.h"
+
+#include "state.h"
+#include "transition.h"
+
+#include <QHash>
+
+using namespace KDSME;
+
+LayoutRegion LayoutRegion::fromState(const State *state)
+{
+    LayoutRegion region;
+    const auto childStates = state->childStates();
+    QHash<const State *, int> indices;
+    indices.reserve(childStates.size());
+    region.states.reserve(childStates.size());
+    for (State *childState : childStates) {
+        const auto *pseudoState = qobject_cast<const PseudoState *>(childState);
+        indices.insert(childState, region.states.size());
+        region.states.append(StateInput { childState, childState->type(), pseudoState && pseudoState->kind() == PseudoState::InitialState,
+                                          childState->label(), childState->width(), childState->height() });
+    }
+
+    for (int source = 0; source < region.states.size(); ++source) {
+        const auto transitions = region.states.at(source).state->transitions();
+        for (Transition *transition : transitions) {
+            const auto it = indices.constFind(transition->targetState());
+            if (it == indices.constEnd()) {
+                continue;
+            }
+            region.transitions.append(TransitionInput { transition, source, *it, transition->label() });
+        }
+    }
+    return region;
+}
+
+void LayoutResult::apply() const
+{
+    for (const StateGeometry &geometry : states) {
+        geometry.state->setPos(geometry.pos);
+        geometry.state->setWidth(geometry.width);
+        geometry.state->setHeight(geometry.height);
+    }
+
+    for (const TransitionGeometry &geometry : transitions) {
+        geometry.transition->setPos(geometry.pos);
+        geometry.transition->setShape(geometry.shape);
+        geometry.transition->setLabelBoundingRect(geometry.labelBoundingRect);
+    }
+}
@@ -0,0 +1,114 @@
+/*
+  This file is part of the KDAB State Machine Editor Library.
+
+  SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company <info@kdab.com>
+
+  SPDX-License-Identifier: LGPL-2.1-only OR LicenseRef-KDAB-KDStateMachineEditor
+
+  Licensees holding valid commercial KDAB State Machine Editor Library
+  licenses may use this file in accordance with the KDAB State Machine Editor
+  Library License Agreement provided with the Software.
+
+  Contact info@kdab.com if any conditions of this licensing are not clear to you.
+*/
+
+#ifndef KDSME_LAYOUT_LAYOUTRESULT_H
+#define KDSME_LAYOUT_LAYOUTRESULT_H
+
+#include "kdsme_core_export.h"
+
+#include "element.h"
+
+#include <QPainterPath>
+#include <QPointF>
+#include <QRectF>
+#include <QString>
+#include <QVector>
+
+namespace KDSME {
+
+class State;
+class Transition;
+
+/**
+ * @brief Inputs of the layout of a single region, copied from the elements
+ *
+ * Holds the direct children of a state and the transitions between them, so the region can be
+ * laid out in a worker thread without reading the elements there. The element pointers are only
+ * kept to map the result back, they must not be dereferenced outside the owning thread.
+ */
+struct KDSME_CORE_EXPORT LayoutRegion
+{
+    struct StateInput
+    {
+        State *state;
+        Element::Type type;
+        /// Whether the state is a PseudoState of kind InitialState
+        bool isInitialState;
+        QString label;
+        qreal width;
+        qreal height;
+    };
+
+    struct TransitionInput
+    {
+        Transition *transition;
+        /// Index into states
+        int source;
+        /// Index into states
+        int target;
+        QString label;
+    };
+
+    /**
+     * Copy the children of @p state and the transitions between them
+     *
+     * Transitions leaving the region are left out.
+     *
+     * @note Must be called from the thread the elements live in
+     */
+    static LayoutRegion fromState(const State *state);
+
+    QVector<StateInput> states;
+    QVector<TransitionInput> transitions;
+};
+
+/**
+ * @brief Geometry computed by a layout run, not yet applied to the elements
+ *
+ * Allows computing a layout without writing to the elements, e.g. in a worker thread.
+ * Positions are relative to the parent element, as in Element::pos().
+ */
+struct KDSME_CORE_EXPORT LayoutResult
+{
+    struct StateGeometry
+    {
+        State *state;
+        QPointF pos;
+        qreal width;
+        qreal height;
+    };
+
+    struct TransitionGeometry
+    {
+        Transition *transition;
+        QPointF pos;
+        QPainterPath shape;
+        QRectF labelBoundingRect;
+    };
+
+    QVector<StateGeometry> states;
+    QVector<TransitionGeometry> transitions;
+    QRectF boundingRect;
+
+    /**
+     * Write the collected geometry to the elements
+     *
+     * @note Must be called from the thread the elements live in
+     */
+    void apply() const;
+};
+
+}
+
+#endif // KDSME_LAYOUT_LAYOUTRESULT_H
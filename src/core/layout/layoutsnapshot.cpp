@@ -0,0 +1,226 @@
+/*
+  This file is part of the KDAB State Machine Editor Library.
+
+  SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company <info@kdab.com>
+
+  SPDX-License-Identifier: LGPL-2.1-only OR LicenseRef-KDAB-KDStateMachineEditor
+
+  Licensees holding valid commercial KDAB State Machine Editor Library
+  licenses may use this file in accordance with the KDAB State Machine Editor
+  Library License Agreement provided with the Software.
+
+  Contact info@kdab.com if any conditions of this licensing are not clear to you.
+*/
+
+#include "layoutsnapshot.h"
+
+#include "debug.h"
+#include "elementwalker.h"
+#include "layouter.h"
+#include "layoutproperties.h"
+#include "state.h"
+#include "transition.h"
+
+#include <QAtomicInt>
+#include <QHash>
+#include <QMetaProperty>
+#include <QPointer>
+#include <QThread>
+#include <QVector>
+
+using namespace KDSME;
+
+namespace {
+
+/// Copy all plain value properties, object references need to be remapped by the caller
+void copyProperties(const QObject *from, QObject *to)
+{
+    const QMetaObject *metaObject = from->metaObject();
+    for (int i = 0; i < metaObject->propertyCount(); ++i) {
+        const QMetaProperty property = metaObject->property(i);
+        if (!property.isWritable() || !property.isStored()) {
+            continue;
+        }
+        if (property.metaType().flags() & QMetaType::PointerToQObject) {
+            continue;
+        }
+        property.write(to, property.read(from));
+    }
+}
+
+Element *createElement(Element::Type type)
+{
+    switch (type) {
+    case Element::TransitionType:
+        return new Transition;
+    case Element::SignalTransitionType:
+        return new SignalTransition(nullptr);
+    case Element::TimeoutTransitionType:
+        return new TimeoutTransition(nullptr);
+    case Element::StateType:
+        return new State;
+    case Element::HistoryStateType:
+        return new HistoryState;
+    case Element::StateMachineType:
+        return new StateMachine;
+    case Element::FinalStateType:
+        return new FinalState;
+    case Element::PseudoStateType:
+        return new PseudoState;
+    default:
+        return nullptr;
+    }
+}
+
+}
+
+struct LayoutSnapshot::Private
+{
+    /// Hand the copies over to @p thread, nullptr detaches them from any thread
+    void moveCopiesToThread(QThread *thread);
+
+    QPointer<State> m_root;
+    QScopedPointer<State> m_rootCopy;
+    QScopedPointer<LayoutProperties> m_properties;
+    QPointer<Layouter> m_layouter;
+    QScopedPointer<Layouter> m_layouterCopy;
+    /// Identifies the changes the copy of the layouter knows about, see Layouter::prepareClone()
+    quint64 m_token = 0;
+
+    /// Pairs of copies and their originals, parents before their children
+    QVector<QPair<Element *, QPointer<Element>>> m_elements;
+    QRectF m_boundingRect;
+    QAtomicInt m_cancelled;
+};
+
+void LayoutSnapshot::Private::moveCopiesToThread(QThread *thread)
+{
+    if (m_rootCopy) {
+        m_rootCopy->moveToThread(thread);
+    }
+    m_properties->moveToThread(thread);
+    if (m_layouterCopy) {
+        m_layouterCopy->moveToThread(thread);
+    }
+}
+
+LayoutSnapshot::LayoutSnapshot(State *root, const LayoutProperties *properties, Layouter *layouter)
+    : d(new Private)
+{
+    Q_ASSERT(root);
+    Q_ASSERT(properties);
+    Q_ASSERT(layouter);
+
+    d->m_root = root;
+    d->m_properties.reset(new LayoutProperties);
+    copyProperties(properties, d->m_properties.data());
+
+    QHash<const Element *, Element *> copies;
+    ElementWalker walker(ElementWalker::PreOrderTraversal);
+    walker.walkItems(root, [&](Element *element) {
+        Element *parentCopy = nullptr;
+        if (element != root) {
+            parentCopy = copies.value(qobject_cast<Element *>(element->parent()));
+            if (!parentCopy) {
+                return ElementWalker::RecursiveWalk; // parent could not be copied
+            }
+        }
+
+        Element *copy = createElement(element->type());
+        if (!copy) {
+            return ElementWalker::RecursiveWalk;
+        }
+
+        copyProperties(element, copy);
+        copy->setParent(parentCopy);
+        copies.insert(element, copy);
+        d->m_elements.append(qMakePair(copy, QPointer<Element>(element)));
+        return ElementWalker::RecursiveWalk;
+    });
+
+    // transitions may point to states visited after them, remap once all copies exist
+    for (const auto &pair : std::as_const(d->m_elements)) {
+        if (auto *transition = qobject_cast<Transition *>(pair.first)) {
+            const auto *original = static_cast<const Transition *>(pair.second.data());
+            transition->setTargetState(qobject_cast<State *>(copies.value(original->targetState())));
+        }
+    }
+
+    d->m_rootCopy.reset(qobject_cast<State *>(copies.value(root)));
+
+    d->m_layouter = layouter;
+    d->m_layouterCopy.reset(layouter->clone());
+    if (d->m_layouterCopy) {
+        d->m_token = layouter->prepareClone(d->m_layouterCopy.data(), root, properties, d->m_properties.data(), copies);
+    } else {
+        qCWarning(KDSME_CORE) << "Cannot copy layouter:" << layouter->metaObject()->className();
+    }
+
+    // the copies are modified and possibly deleted in another thread
+    d->moveCopiesToThread(nullptr);
+}
+
+LayoutSnapshot::~LayoutSnapshot()
+{
+}
+
+State *LayoutSnapshot::root() const
+{
+    return d->m_root.data();
+}
+
+bool LayoutSnapshot::isValid() const
+{
+    return d->m_rootCopy && d->m_layouterCopy;
+}
+
+bool LayoutSnapshot::layout()
+{
+    if (isCancelled() || !isValid()) {
+        return false;
+    }
+
+    d->moveCopiesToThread(QThread::currentThread());
+    d->m_boundingRect = d->m_layouterCopy->layout(d->m_rootCopy.data(), d->m_properties.data());
+    d->moveCopiesToThread(nullptr);
+    return true;
+}
+
+void LayoutSnapshot::cancel()
+{
+    d->m_cancelled.storeRelease(1);
+}
+
+bool LayoutSnapshot::isCancelled() const
+{
+    return d->m_cancelled.loadAcquire();
+}
+
+LayoutResult LayoutSnapshot::result() const
+{
+    LayoutResult result;
+    result.boundingRect = d->m_boundingRect;
+    for (const auto &pair : std::as_const(d->m_elements)) {
+        Element *original = pair.second.data();
+        if (!original) {
+            continue;
+        }
+
+        if (auto *state = qobject_cast<State *>(original)) {
+            const Element *copy = pair.first;
+            result.states.append(LayoutResult::StateGeometry { state, copy->pos(), copy->width(), copy->height() });
+        } else if (auto *transition = qobject_cast<Transition *>(original)) {
+            const auto *copy = static_cast<const Transition *>(pair.first);
+            result.transitions.append(LayoutResult::TransitionGeometry { transition, copy->pos(), copy->shape(), copy->labelBoundingRect() });
+        }
+    }
+    return result;
+}
+
+void LayoutSnapshot::apply()
+{
+    result().apply();
+    if (d->m_layouter) {
+        d->m_layouter->cloneLayoutApplied(d->m_root.data(), d->m_boundingRect, d->m_token);
+    }
+}
@@ -0,0 +1,100 @@
+/*
+  This file is part of the KDAB State Machine Editor Library.
+
+  SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company <info@kdab.com>
+
+  SPDX-License-Identifier: LGPL-2.1-only OR LicenseRef-KDAB-KDStateMachineEditor
+
+  Licensees holding valid commercial KDAB State Machine Editor Library
+  licenses may use this file in accordance with the KDAB State Machine Editor
+  Library License Agreement provided with the Software.
+
+  Contact info@kdab.com if any conditions of this licensing are not clear to you.
+*/
+
+#ifndef KDSME_LAYOUT_LAYOUTSNAPSHOT_H
+#define KDSME_LAYOUT_LAYOUTSNAPSHOT_H
+
+#include "kdsme_core_export.h"
+
+#include "layoutresult.h"
+
+#include <QScopedPointer>
+
+namespace KDSME {
+
+class Layouter;
+class LayoutProperties;
+class State;
+
+/**
+ * @brief Immutable copy of everything a layouter needs to know about a state machine
+ *
+ * The snapshot is taken in the thread owning the elements. Afterwards, layout() may run in any
+ * thread since it only operates on private copies of the elements and of the layouter, while the
+ * originals stay untouched until apply() is called in the owning thread again.
+ *
+ * The copies do not belong to any thread in between, layout() adopts them for the time it runs.
+ */
+class KDSME_CORE_EXPORT LayoutSnapshot
+{
+public:
+    /**
+     * Copy @p root, its descendants, @p properties and @p layouter
+     *
+     * The copy of @p layouter keeps its settings, its cache and, in incremental mode, knows
+     * which regions changed since @p layouter laid out @p root last.
+     *
+     * @note Must be called from the thread the elements and @p layouter live in
+     * @sa Layouter::clone()
+     */
+    LayoutSnapshot(State *root, const LayoutProperties *properties, Layouter *layouter);
+    ~LayoutSnapshot();
+
+    /// The state the snapshot was taken from, nullptr in case it got deleted in the meantime
+    State *root() const;
+
+    /// False in case @p layouter could not be copied, layout() fails then
+    bool isValid() const;
+
+    /**
+     * Lay out the copied elements using the copy of the layouter
+     *
+     * @return False in case the layout got cancelled before it started, or in case the snapshot is not valid
+     */
+    bool layout();
+
+    /**
+     * Request to skip the layout, in case layout() did not start yet
+     *
+     * @note Thread-safe
+     */
+    void cancel();
+    bool isCancelled() const;
+
+    /**
+     * @return The geometry computed by layout(), mapped back to the original elements
+     *
+     * Elements deleted since the snapshot was taken are left out.
+     *
+     * @note Must be called from the thread the elements live in
+     */
+    LayoutResult result() const;
+
+    /**
+     * Apply result() and let the layouter the snapshot was taken with know the layout is current
+     *
+     * @note Must be called from the thread the elements live in
+     */
+    void apply();
+
+private:
+    Q_DISABLE_COPY(LayoutSnapshot)
+
+    struct Private;
+    QScopedPointer<Private> d;
+};
+
+}
+
+#endif // KDSME_LAYOUT_LAYOUTSNAPSHOT_H
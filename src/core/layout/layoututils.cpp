@@ -16,12 +16,14 @@
 #include "layoututils.h"
 
 #include "element.h"
+#include "layoutproperties.h"
 #include "state.h"
 #include "transition.h"
 
 #include <QGuiApplication>
 #include "debug.h"
 #include <QFontMetricsF>
+#include <QRectF>
 #include <QSizeF>
 
 using namespace KDSME;
@@ -37,6 +39,23 @@ QSizeF LayoutUtils::sizeForLabel(const QString &label)
     return QSizeF(width + (2 * margin), fm.height() + (2 * margin));
 }
 
+QRectF LayoutUtils::boundingRectForCollapsedRegion(const State *state, const LayoutProperties *properties)
+{
+    static const QRectF minimumSize(0, 0, 100, 20);
+
+    Q_ASSERT(state);
+    if (!state) {
+        return minimumSize;
+    }
+
+    const QString label = state->label();
+    const QFontMetricsF fm(properties->regionLabelFont());
+    const qreal width = fm.horizontalAdvance(label);
+    const qreal height = fm.height();
+    const qreal margin = properties->regionLabelMargins();
+    return QRectF(0, 0, width + properties->regionLabelButtonBoxSize().width() + 2 * margin, height + 2 * margin);
+}
+
 bool LayoutUtils::moveInner(State *state, const QPointF &offset) // cppcheck-suppress constParameterPointer // clazy:exclude=function-args-by-value
 {
     if (!state) {
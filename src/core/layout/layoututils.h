@@ -22,6 +22,7 @@
 
 QT_BEGIN_NAMESPACE
 class QPointF;
+class QRectF;
 class QSizeF;
 class QString;
 QT_END_NAMESPACE
@@ -29,6 +30,7 @@ QT_END_NAMESPACE
 namespace KDSME {
 
 class Element;
+class LayoutProperties;
 class State;
 
 class KDSME_CORE_EXPORT LayoutUtils
@@ -36,6 +38,9 @@ class KDSME_CORE_EXPORT LayoutUtils
 public:
     static QSizeF sizeForLabel(const QString &label);
 
+    /// Size of the region of state @p state when collapsed, i.e. only showing its label
+    static QRectF boundingRectForCollapsedRegion(const State *state, const LayoutProperties *properties);
+
     /// Move all direct children of state @p state by offset @p offset
     static bool moveInner(State *state, const QPointF &offset);
 
@@ -0,0 +1,897 @@
+/*
+  This file is part of the KDAB State Machine Editor Library.
+
+  SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company <info@kdab.com>
+
+  SPDX-License-Identifier: LGPL-2.1-only OR LicenseRef-KDAB-KDStateMachineEditor
+
+  Licensees holding valid commercial KDAB State Machine Editor Library
+  licenses may use this file in accordance with the KDAB State Machine Editor
+  Library License Agreement provided with the Software.
+
+  Contact info@kdab.com if any conditions of this licensing are not clear to you.
+*/
+
+#include "remotelayouter.h"
+
+#include <config-kdsme.h>
+
+#include "layerwiselayouter.h"
+#include "layoutimportexport.h"
+#include "layoutproperties.h"
+#include "layoutresult.h"
+#include "state.h"
+#include "sugiyamalayouter.h"
+#include "transition.h"
+#if HAVE_GRAPHVIZ
+#include "graphvizlayout/graphvizlayerlayouter.h"
+#include "graphvizlayout/graphvizlayouter.h"
+#endif
+
+#include "debug.h"
+
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QDir>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QPainterPath>
+#include <QProcess>
+#include <QQueue>
+#include <QRectF>
+#include <QSemaphore>
+#include <QSharedPointer>
+#include <QThread>
+#include <QTimer>
+#include <QtEndian>
+
+using namespace KDSME;
+
+namespace {
+
+const int DEFAULT_TIMEOUT = 30000;
+
+/// Size of the length prefix of each message exchanged with a worker
+const int FRAME_HEADER_SIZE = sizeof(quint32);
+
+const QMetaObject *layouterType(const QByteArray &name)
+{
+    static const QMetaObject *const types[] = {
+#if HAVE_GRAPHVIZ
+        &GraphvizLayouter::staticMetaObject,
+#endif
+        &LayerwiseLayouter::staticMetaObject,
+        &SugiyamaLayouter::staticMetaObject,
+    };
+    for (const QMetaObject *type : types) {
+        if (name == type->className()) {
+            return type;
+        }
+    }
+    return nullptr;
+}
+
+/// @return The indices leading from @p root to @p state, null in case @p state is not a descendant of @p root
+QJsonValue indexPath(const State *root, const State *state)
+{
+    QJsonArray path;
+    while (state && state != root) {
+        const State *parent = state->parentState();
+        if (!parent) {
+            return QJsonValue();
+        }
+        path.prepend(parent->childStates().indexOf(const_cast<State *>(state)));
+        state = parent;
+    }
+    return state ? QJsonValue(path) : QJsonValue();
+}
+
+State *stateAt(State *root, const QJsonArray &path)
+{
+    State *state = root;
+    for (const QJsonValue &index : path) {
+        const auto childStates = state->childStates();
+        const int i = index.toInt(-1);
+        if (i < 0 || i >= childStates.size()) {
+            return nullptr;
+        }
+        state = childStates.at(i);
+    }
+    return state;
+}
+
+QJsonObject structureToJson(const State *root, const State *state)
+{
+    QJsonObject res;
+    res[u"type"] = static_cast<int>(state->type());
+    res[u"label"] = state->label();
+    res[u"expanded"] = state->isExpanded();
+    res[u"childMode"] = static_cast<int>(state->childMode());
+    if (const auto *pseudoState = qobject_cast<const PseudoState *>(state)) {
+        res[u"kind"] = static_cast<int>(pseudoState->kind());
+    } else if (const auto *historyState = qobject_cast<const HistoryState *>(state)) {
+        res[u"historyType"] = static_cast<int>(historyState->historyType());
+    }
+
+    QJsonArray states;
+    const auto childStates = state->childStates();
+    for (const State *child : childStates) {
+        states.push_back(structureToJson(root, child)); // cppcheck-suppress useStlAlgorithm
+    }
+    res[u"childStates"] = states;
+
+    QJsonArray transitions;
+    const auto stateTransitions = state->transitions();
+    for (const Transition *transition : stateTransitions) {
+        QJsonObject data;
+        data[u"label"] = transition->label();
+        data[u"target"] = indexPath(root, transition->targetState());
+        transitions.push_back(data);
+    }
+    res[u"transitions"] = transitions;
+    return res;
+}
+
+State *createState(const QJsonObject &data, State *parent)
+{
+    State *state = nullptr;
+    switch (data.value(u"type").toInt()) {
+    case Element::StateMachineType:
+        state = parent ? new State(parent) : new StateMachine;
+        break;
+    case Element::HistoryStateType:
+        state = new HistoryState(static_cast<HistoryState::HistoryType>(data.value(u"historyType").toInt()), parent);
+        break;
+    case Element::FinalStateType:
+        state = new FinalState(parent);
+        break;
+    case Element::PseudoStateType:
+        state = new PseudoState(static_cast<PseudoState::Kind>(data.value(u"kind").toInt()), parent);
+        break;
+    default:
+        state = new State(parent);
+        break;
+    }
+    state->setLabel(data.value(u"label").toString());
+    state->setExpanded(data.value(u"expanded").toBool(true));
+    state->setChildMode(static_cast<State::ChildMode>(data.value(u"childMode").toInt()));
+
+    const QJsonArray childStates = data.value(u"childStates").toArray();
+    for (const QJsonValue &child : childStates) {
+        createState(child.toObject(), state);
+    }
+    return state;
+}
+
+/// Second pass after all states exist, since transitions may point anywhere below @p root
+void createTransitions(const QJsonObject &data, State *root, State *state)
+{
+    const QJsonArray childData = data.value(u"childStates").toArray();
+    const auto childStates = state->childStates();
+    for (int i = 0; i < childData.size() && i < childStates.size(); ++i) {
+        createTransitions(childData.at(i).toObject(), root, childStates.at(i));
+    }
+
+    const QJsonArray transitions = data.value(u"transitions").toArray();
+    for (const QJsonValue &value : transitions) {
+        const QJsonObject transitionData = value.toObject();
+        auto *transition = new Transition(state);
+        transition->setLabel(transitionData.value(u"label").toString());
+        const QJsonValue target = transitionData.value(u"target");
+        if (target.isArray()) {
+            transition->setTargetState(stateAt(root, target.toArray()));
+        }
+    }
+}
+
+QJsonObject propertiesToJson(const LayoutProperties *properties)
+{
+    QJsonObject res;
+    res[u"regionMargins"] = properties->regionMargins();
+    res[u"regionLabelFont"] = properties->regionLabelFont().toString();
+    res[u"regionLabelMargins"] = properties->regionLabelMargins();
+    res[u"regionLabelButtonBoxWidth"] = properties->regionLabelButtonBoxSize().width();
+    res[u"regionLabelButtonBoxHeight"] = properties->regionLabelButtonBoxSize().height();
+    res[u"showTransitionLabels"] = properties->showTransitionLabels();
+    return res;
+}
+
+void propertiesFromJson(const QJsonObject &data, LayoutProperties *properties)
+{
+    properties->setRegionMargins(data.value(u"regionMargins").toDouble());
+    QFont font;
+    if (font.fromString(data.value(u"regionLabelFont").toString())) {
+        properties->setRegionLabelFont(font);
+    }
+    properties->setRegionLabelMargins(data.value(u"regionLabelMargins").toDouble());
+    properties->setRegionLabelButtonBoxSize(QSizeF(data.value(u"regionLabelButtonBoxWidth").toDouble(),
+                                                   data.value(u"regionLabelButtonBoxHeight").toDouble()));
+    properties->setShowTransitionLabels(data.value(u"showTransitionLabels").toBool());
+}
+
+QJsonArray rectToJson(const QRectF &rect)
+{
+    return QJsonArray { rect.x(), rect.y(), rect.width(), rect.height() };
+}
+
+QRectF rectFromJson(const QJsonArray &data)
+{
+    return QRectF(data.at(0).toDouble(), data.at(1).toDouble(), data.at(2).toDouble(), data.at(3).toDouble());
+}
+
+/// The element pointers stay behind, states and transitions are identified by their index
+QJsonObject regionToJson(const LayoutRegion &region)
+{
+    QJsonArray states;
+    for (const LayoutRegion::StateInput &input : region.states) {
+        QJsonObject data;
+        data[u"type"] = static_cast<int>(input.type);
+        data[u"initialState"] = input.isInitialState;
+        data[u"label"] = input.label;
+        data[u"width"] = input.width;
+        data[u"height"] = input.height;
+        states.push_back(data);
+    }
+
+    QJsonArray transitions;
+    for (const LayoutRegion::TransitionInput &input : region.transitions) {
+        QJsonObject data;
+        data[u"source"] = input.source;
+        data[u"target"] = input.target;
+        data[u"label"] = input.label;
+        transitions.push_back(data);
+    }
+
+    QJsonObject res;
+    res[u"states"] = states;
+    res[u"transitions"] = transitions;
+    return res;
+}
+
+bool regionFromJson(const QJsonObject &data, LayoutRegion *region)
+{
+    const QJsonArray states = data.value(u"states").toArray();
+    for (const QJsonValue &value : states) {
+        const QJsonObject input = value.toObject();
+        region->states.append(LayoutRegion::StateInput { nullptr, static_cast<Element::Type>(input.value(u"type").toInt()),
+                                                         input.value(u"initialState").toBool(), input.value(u"label").toString(),
+                                                         input.value(u"width").toDouble(), input.value(u"height").toDouble() });
+    }
+
+    const QJsonArray transitions = data.value(u"transitions").toArray();
+    for (const QJsonValue &value : transitions) {
+        const QJsonObject input = value.toObject();
+        const int source = input.value(u"source").toInt(-1);
+        const int target = input.value(u"target").toInt(-1);
+        if (source < 0 || source >= region->states.size() || target < 0 || target >= region->states.size()) {
+            return false;
+        }
+        region->transitions.append(LayoutRegion::TransitionInput { nullptr, source, target, input.value(u"label").toString() });
+    }
+    return true;
+}
+
+/// Geometry in the order of the region's states and transitions
+QJsonObject resultToJson(const LayoutResult &result)
+{
+    QJsonArray states;
+    for (const LayoutResult::StateGeometry &geometry : result.states) {
+        states.push_back(rectToJson(QRectF(geometry.pos, QSizeF(geometry.width, geometry.height))));
+    }
+
+    QJsonArray transitions;
+    for (const LayoutResult::TransitionGeometry &geometry : result.transitions) {
+        QJsonObject data;
+        data[u"x"] = geometry.pos.x();
+        data[u"y"] = geometry.pos.y();
+        data[u"labelBoundingRect"] = rectToJson(geometry.labelBoundingRect);
+        QByteArray shapeData;
+        QDataStream ds(&shapeData, QIODevice::WriteOnly);
+        ds << geometry.shape;
+        data[u"shape"] = QLatin1String(shapeData.toBase64());
+        transitions.push_back(data);
+    }
+
+    QJsonObject res;
+    res[u"states"] = states;
+    res[u"transitions"] = transitions;
+    return res;
+}
+
+QByteArray errorReply(const QString &message)
+{
+    QJsonObject reply;
+    reply[u"ok"] = false;
+    reply[u"error"] = message;
+    return QJsonDocument(reply).toJson(QJsonDocument::Compact);
+}
+
+QString defaultWorkerProgram()
+{
+    const QString program = qEnvironmentVariable("KDSME_LAYOUT_WORKER");
+    if (!program.isEmpty()) {
+        return program;
+    }
+    return QDir(QCoreApplication::applicationDirPath()).filePath(QStringLiteral("kdsme_layoutworker"));
+}
+
+/**
+ * Pool of worker processes shared by all RemoteLayouter instances
+ *
+ * The processes are owned by a dedicated thread, callers from any other thread hand over their
+ * requests and block until a worker answered, crashed or timed out. Messages in both directions
+ * are prefixed with their size as big-endian 32-bit integer.
+ *
+ * The thread is stopped on QCoreApplication::aboutToQuit(), while its event loop still runs.
+ */
+class LayoutWorkerPool
+{
+public:
+    LayoutWorkerPool();
+    ~LayoutWorkerPool();
+
+    /**
+     * Send @p request to the next free worker and wait for its reply
+     *
+     * @return False in case the worker could not be started, crashed or did not answer within @p timeout milliseconds
+     */
+    bool process(const QByteArray &request, int timeout, QByteArray *reply);
+
+    QString program() const;
+    void setProgram(const QString &program);
+
+    int maximumWorkerCount() const;
+    void setMaximumWorkerCount(int count);
+
+    /// Stop the worker processes and the thread, fails all pending and later requests
+    void stop();
+
+private:
+    Q_DISABLE_COPY(LayoutWorkerPool)
+
+    struct Job
+    {
+        QByteArray request;
+        int timeout = -1;
+        QByteArray reply;
+        bool ok = false;
+        QSemaphore done;
+    };
+
+    struct Worker
+    {
+        QProcess *process = nullptr;
+        QTimer *timer = nullptr;
+        QSharedPointer<Job> job;
+        QByteArray buffer;
+    };
+
+    // the following are only called in m_thread
+    void schedule();
+    Worker *createWorker();
+    void startJob(Worker *worker, const QSharedPointer<Job> &job);
+    void readReply(Worker *worker);
+    void finishJob(Worker *worker, bool ok);
+    void workerFailed(Worker *worker);
+    void shutdown();
+
+    QThread m_thread;
+    /// Context object living in m_thread, parent of all processes
+    QObject *m_context;
+    QQueue<QSharedPointer<Job>> m_queue;
+    QList<Worker *> m_workers;
+
+    /// Guards m_stopped, jobs are only posted to m_thread while holding it
+    QMutex m_stopMutex;
+    bool m_stopped = false;
+    QMetaObject::Connection m_aboutToQuitConnection;
+
+    mutable QMutex m_settingsMutex;
+    QString m_program;
+    int m_maximumWorkerCount;
+};
+
+Q_GLOBAL_STATIC(LayoutWorkerPool, workerPool)
+
+LayoutWorkerPool::LayoutWorkerPool()
+    : m_context(new QObject)
+    , m_maximumWorkerCount(QThread::idealThreadCount())
+{
+    m_thread.setObjectName(QStringLiteral("KDSME layout worker pool"));
+    m_context->moveToThread(&m_thread);
+    m_thread.start();
+
+    // static destruction comes too late, the processes need a running event loop to shut down
+    if (QCoreApplication *app = QCoreApplication::instance()) {
+        m_aboutToQuitConnection = QObject::connect(app, &QCoreApplication::aboutToQuit, app, [this] { stop(); }, Qt::DirectConnection);
+    }
+}
+
+LayoutWorkerPool::~LayoutWorkerPool()
+{
+    QObject::disconnect(m_aboutToQuitConnection);
+    stop();
+    delete m_context;
+}
+
+void LayoutWorkerPool::stop()
+{
+    {
+        const QMutexLocker locker(&m_stopMutex);
+        if (m_stopped) {
+            return;
+        }
+        m_stopped = true;
+
+        // queued after all jobs posted so far, which shutdown() fails
+        QMetaObject::invokeMethod(
+            m_context, [this] {
+                shutdown();
+                m_thread.quit();
+            },
+            Qt::QueuedConnection);
+    }
+    m_thread.wait();
+}
+
+bool LayoutWorkerPool::process(const QByteArray &request, int timeout, QByteArray *reply)
+{
+    Q_ASSERT(QThread::currentThread() != &m_thread);
+
+    auto job = QSharedPointer<Job>::create();
+    job->request = request;
+    job->timeout = timeout;
+    {
+        const QMutexLocker locker(&m_stopMutex);
+        if (m_stopped) {
+            return false;
+        }
+        QMetaObject::invokeMethod(
+            m_context, [this, job] {
+                m_queue.enqueue(job);
+                schedule();
+            },
+            Qt::QueuedConnection);
+    }
+
+    job->done.acquire();
+    if (!job->ok) {
+        return false;
+    }
+    *reply = job->reply;
+    return true;
+}
+
+QString LayoutWorkerPool::program() const
+{
+    const QMutexLocker locker(&m_settingsMutex);
+    return m_program.isEmpty() ? defaultWorkerProgram() : m_program;
+}
+
+void LayoutWorkerPool::setProgram(const QString &program)
+{
+    const QMutexLocker locker(&m_settingsMutex);
+    m_program = program;
+}
+
+int LayoutWorkerPool::maximumWorkerCount() const
+{
+    const QMutexLocker locker(&m_settingsMutex);
+    return m_maximumWorkerCount;
+}
+
+void LayoutWorkerPool::setMaximumWorkerCount(int count)
+{
+    const QMutexLocker locker(&m_settingsMutex);
+    m_maximumWorkerCount = qMax(1, count);
+}
+
+void LayoutWorkerPool::schedule()
+{
+    while (!m_queue.isEmpty()) {
+        Worker *worker = nullptr;
+        for (Worker *candidate : std::as_const(m_workers)) {
+            if (!candidate->job) {
+                worker = candidate;
+                break;
+            }
+        }
+        if (!worker) {
+            if (m_workers.size() >= maximumWorkerCount()) {
+                return; // the next worker finishing its job picks up the queue
+            }
+            worker = createWorker();
+        }
+        startJob(worker, m_queue.dequeue());
+    }
+}
+
+LayoutWorkerPool::Worker *LayoutWorkerPool::createWorker()
+{
+    auto *worker = new Worker;
+    worker->process = new QProcess(m_context);
+    worker->process->setProcessChannelMode(QProcess::ForwardedErrorChannel);
+    worker->timer = new QTimer(m_context);
+    worker->timer->setSingleShot(true);
+
+    QObject::connect(worker->process, &QProcess::readyReadStandardOutput, m_context, [this, worker] {
+        readReply(worker);
+    });
+    // queued, since QProcess may report a failure to start from within start() already
+    QObject::connect(
+        worker->process, &QProcess::errorOccurred, m_context, [this, worker](QProcess::ProcessError error) {
+            if (error == QProcess::FailedToStart) {
+                workerFailed(worker);
+            }
+        },
+        Qt::QueuedConnection);
+    QObject::connect(
+        worker->process, &QProcess::finished, m_context, [this, worker] {
+            workerFailed(worker);
+        },
+        Qt::QueuedConnection);
+    QObject::connect(worker->timer, &QTimer::timeout, worker->process, &QProcess::kill);
+
+    m_workers.append(worker);
+    return worker;
+}
+
+void LayoutWorkerPool::startJob(Worker *worker, const QSharedPointer<Job> &job)
+{
+    worker->job = job;
+    worker->buffer.clear();
+
+    if (worker->process->state() == QProcess::NotRunning) {
+        worker->process->start(program(), QStringList());
+    }
+
+    QByteArray header(FRAME_HEADER_SIZE, Qt::Uninitialized);
+    qToBigEndian<quint32>(job->request.size(), header.data());
+    // written data is buffered until the process is up
+    worker->process->write(header);
+    worker->process->write(job->request);
+
+    if (job->timeout >= 0) {
+        worker->timer->start(job->timeout);
+    }
+}
+
+void LayoutWorkerPool::readReply(Worker *worker)
+{
+    worker->buffer += worker->process->readAllStandardOutput();
+    if (!worker->job || worker->buffer.size() < FRAME_HEADER_SIZE) {
+        return;
+    }
+
+    const quint32 size = qFromBigEndian<quint32>(worker->buffer.constData());
+    if (static_cast<quint32>(worker->buffer.size() - FRAME_HEADER_SIZE) < size) {
+        return;
+    }
+
+    worker->job->reply = worker->buffer.mid(FRAME_HEADER_SIZE, size);
+    worker->buffer.remove(0, FRAME_HEADER_SIZE + size);
+    finishJob(worker, true);
+    schedule();
+}
+
+void LayoutWorkerPool::finishJob(Worker *worker, bool ok)
+{
+    worker->timer->stop();
+    const QSharedPointer<Job> job = std::move(worker->job);
+    worker->job.reset();
+    job->ok = ok;
+    job->done.release();
+}
+
+void LayoutWorkerPool::workerFailed(Worker *worker)
+{
+    if (!m_workers.removeOne(worker)) {
+        return; // both errorOccurred() and finished() were emitted
+    }
+
+    qCWarning(KDSME_CORE) << "Layout worker" << worker->process->program() << "failed:" << worker->process->errorString();
+    if (worker->job) {
+        finishJob(worker, false);
+    }
+    worker->process->disconnect(m_context);
+    worker->process->deleteLater();
+    worker->timer->deleteLater();
+    delete worker;
+
+    schedule();
+}
+
+void LayoutWorkerPool::shutdown()
+{
+    while (!m_queue.isEmpty()) {
+        const QSharedPointer<Job> job = m_queue.dequeue();
+        job->done.release();
+    }
+
+    for (Worker *worker : std::as_const(m_workers)) {
+        if (worker->job) {
+            finishJob(worker, false);
+        }
+        worker->process->disconnect(m_context);
+        worker->process->kill();
+        worker->process->waitForFinished(1000);
+        delete worker->process;
+        delete worker->timer;
+        delete worker;
+    }
+    m_workers.clear();
+}
+
+}
+
+struct RemoteLayouter::Private
+{
+    QByteArray m_layouterName = LayerwiseLayouter::staticMetaObject.className();
+    QByteArray m_fallbackLayouterName = SugiyamaLayouter::staticMetaObject.className();
+    int m_timeout = DEFAULT_TIMEOUT;
+};
+
+RemoteLayouter::RemoteLayouter(QObject *parent)
+    : Layouter(parent)
+    , d(new Private)
+{
+}
+
+RemoteLayouter::~RemoteLayouter()
+{
+}
+
+QByteArray RemoteLayouter::layouterName() const
+{
+    return d->m_layouterName;
+}
+
+void RemoteLayouter::setLayouterName(const QByteArray &name)
+{
+    if (d->m_layouterName == name)
+        return;
+
+    d->m_layouterName = name;
+    invalidateAll();
+    Q_EMIT layouterNameChanged(name);
+}
+
+int RemoteLayouter::timeout() const
+{
+    return d->m_timeout;
+}
+
+void RemoteLayouter::setTimeout(int timeout)
+{
+    if (d->m_timeout == timeout)
+        return;
+
+    d->m_timeout = timeout;
+    Q_EMIT timeoutChanged(timeout);
+}
+
+QByteArray RemoteLayouter::fallbackLayouterName() const
+{
+    return d->m_fallbackLayouterName;
+}
+
+void RemoteLayouter::setFallbackLayouterName(const QByteArray &name)
+{
+    if (d->m_fallbackLayouterName == name)
+        return;
+
+    d->m_fallbackLayouterName = name;
+    Q_EMIT fallbackLayouterNameChanged(name);
+}
+
+QRectF RemoteLayouter::layout(State *state, const LayoutProperties *properties)
+{
+    if (!state) {
+        qCWarning(KDSME_CORE) << "Null state passed to layout function";
+        return QRectF();
+    }
+
+    beginLayout(state, properties);
+
+    // the worker lays out the whole state at once, hence we can only
+    // reuse the previous result if no region changed at all
+    if (!isDirty(state) && lastBoundingRect().isValid()) {
+        endLayout();
+        return lastBoundingRect();
+    }
+
+    QByteArray reply;
+    QRectF boundingRect;
+    LayoutWorkerPool *pool = workerPool();
+    if (!pool || !pool->process(encodeRequest(state, properties, d->m_layouterName), d->m_timeout, &reply)
+        || !applyReply(reply, state, &boundingRect)) {
+        const QMetaObject *type = layouterType(d->m_fallbackLayouterName);
+        const QScopedPointer<Layouter> fallback(type ? qobject_cast<Layouter *>(type->newInstance()) : nullptr);
+        if (fallback) {
+            qCWarning(KDSME_CORE) << "Remote layout with" << d->m_layouterName << "failed, laying out in-process with"
+                                  << d->m_fallbackLayouterName << "instead";
+            boundingRect = fallback->layout(state, properties);
+        } else {
+            qCWarning(KDSME_CORE) << "Remote layout with" << d->m_layouterName << "failed, keeping the previous geometry";
+        }
+    }
+
+    setLastBoundingRect(boundingRect);
+    endLayout();
+    return boundingRect;
+}
+
+bool RemoteLayouter::mayBlock() const
+{
+    return true;
+}
+
+QString RemoteLayouter::workerProgram()
+{
+    LayoutWorkerPool *pool = workerPool();
+    return pool ? pool->program() : QString();
+}
+
+void RemoteLayouter::setWorkerProgram(const QString &program)
+{
+    if (LayoutWorkerPool *pool = workerPool()) {
+        pool->setProgram(program);
+    }
+}
+
+int RemoteLayouter::maximumWorkerCount()
+{
+    LayoutWorkerPool *pool = workerPool();
+    return pool ? pool->maximumWorkerCount() : 0;
+}
+
+void RemoteLayouter::setMaximumWorkerCount(int count)
+{
+    if (LayoutWorkerPool *pool = workerPool()) {
+        pool->setMaximumWorkerCount(count);
+    }
+}
+
+void RemoteLayouter::stopWorkers()
+{
+    // do not create the pool just for stopping it
+    if (workerPool.exists()) {
+        workerPool()->stop();
+    }
+}
+
+QByteArray RemoteLayouter::encodeRequest(const State *state, const LayoutProperties *properties, const QByteArray &layouterName)
+{
+    QJsonObject request;
+    request[u"layouter"] = QString::fromLatin1(layouterName);
+    request[u"properties"] = propertiesToJson(properties);
+    request[u"structure"] = structureToJson(state, state);
+    // current geometry, for the elements the remote layouter leaves untouched
+    request[u"layout"] = LayoutImportExport::exportLayout(state);
+    return QJsonDocument(request).toJson(QJsonDocument::Compact);
+}
+
+QByteArray RemoteLayouter::processRequest(const QByteArray &request)
+{
+    QJsonParseError error;
+    const QJsonObject data = QJsonDocument::fromJson(request, &error).object();
+    if (error.error != QJsonParseError::NoError) {
+        return errorReply(error.errorString());
+    }
+
+    if (data.contains(u"region")) {
+#if HAVE_GRAPHVIZ
+        LayoutProperties properties;
+        propertiesFromJson(data.value(u"properties").toObject(), &properties);
+
+        LayoutRegion region;
+        if (!regionFromJson(data.value(u"region").toObject(), &region)) {
+            return errorReply(QStringLiteral("Invalid region"));
+        }
+
+        GraphvizLayerLayouter layerLayouter;
+        const LayoutResult result = layerLayouter.computeLayout(region, &properties);
+
+        QJsonObject reply;
+        reply[u"ok"] = true;
+        reply[u"boundingRect"] = rectToJson(result.boundingRect);
+        reply[u"result"] = resultToJson(result);
+        return QJsonDocument(reply).toJson(QJsonDocument::Compact);
+#else
+        return errorReply(QStringLiteral("Region layouts need Graphviz"));
+#endif
+    }
+
+    const QByteArray layouterName = data.value(u"layouter").toString().toLatin1();
+    const QMetaObject *type = layouterType(layouterName);
+    const QScopedPointer<Layouter> layouter(type ? qobject_cast<Layouter *>(type->newInstance()) : nullptr);
+    if (!layouter) {
+        return errorReply(u"Unknown layouter: " + QString::fromLatin1(layouterName));
+    }
+
+    LayoutProperties properties;
+    propertiesFromJson(data.value(u"properties").toObject(), &properties);
+
+    const QJsonObject structure = data.value(u"structure").toObject();
+    const QScopedPointer<State> root(createState(structure, nullptr));
+    createTransitions(structure, root.data(), root.data());
+    LayoutImportExport::importLayout(data.value(u"layout").toObject(), root.data());
+
+    const QRectF boundingRect = layouter->layout(root.data(), &properties);
+
+    QJsonObject reply;
+    reply[u"ok"] = true;
+    reply[u"boundingRect"] = rectToJson(boundingRect);
+    reply[u"layout"] = LayoutImportExport::exportLayout(root.data());
+    return QJsonDocument(reply).toJson(QJsonDocument::Compact);
+}
+
+bool RemoteLayouter::applyReply(const QByteArray &reply, State *state, QRectF *boundingRect)
+{
+    const QJsonObject data = QJsonDocument::fromJson(reply).object();
+    if (!data.value(u"ok").toBool()) {
+        qCWarning(KDSME_CORE) << "Remote layout failed:" << data.value(u"error").toString();
+        return false;
+    }
+
+    const QJsonObject layout = data.value(u"layout").toObject();
+    if (!LayoutImportExport::matches(layout, state)) {
+        qCWarning(KDSME_CORE) << "Remote layout does not match" << state;
+        return false;
+    }
+
+    LayoutImportExport::importLayout(layout, state);
+    if (boundingRect) {
+        *boundingRect = rectFromJson(data.value(u"boundingRect").toArray());
+    }
+    return true;
+}
+
+bool RemoteLayouter::layoutRegion(const LayoutRegion &region, const LayoutProperties *properties, int timeout, LayoutResult *result)
+{
+    QJsonObject request;
+    request[u"properties"] = propertiesToJson(properties);
+    request[u"region"] = regionToJson(region);
+
+    QByteArray reply;
+    LayoutWorkerPool *pool = workerPool();
+    if (!pool || !pool->process(QJsonDocument(request).toJson(QJsonDocument::Compact), timeout, &reply)) {
+        return false;
+    }
+
+    const QJsonObject data = QJsonDocument::fromJson(reply).object();
+    if (!data.value(u"ok").toBool()) {
+        qCWarning(KDSME_CORE) << "Remote layout failed:" << data.value(u"error").toString();
+        return false;
+    }
+
+    const QJsonObject resultData = data.value(u"result").toObject();
+    const QJsonArray states = resultData.value(u"states").toArray();
+    const QJsonArray transitions = resultData.value(u"transitions").toArray();
+    if (states.size() != region.states.size() || transitions.size() != region.transitions.size()) {
+        qCWarning(KDSME_CORE) << "Remote layout does not match the region";
+        return false;
+    }
+
+    LayoutResult res;
+    res.states.reserve(states.size());
+    for (int i = 0; i < states.size(); ++i) {
+        const QRectF rect = rectFromJson(states.at(i).toArray());
+        res.states.append(LayoutResult::StateGeometry { region.states.at(i).state, rect.topLeft(), rect.width(), rect.height() });
+    }
+    res.transitions.reserve(transitions.size());
+    for (int i = 0; i < transitions.size(); ++i) {
+        const QJsonObject geometry = transitions.at(i).toObject();
+        QPainterPath shape;
+        QDataStream ds(QByteArray::fromBase64(geometry.value(u"shape").toString().toLatin1()));
+        ds >> shape;
+        res.transitions.append(LayoutResult::TransitionGeometry { region.transitions.at(i).transition,
+                                                                  QPointF(geometry.value(u"x").toDouble(), geometry.value(u"y").toDouble()),
+                                                                  shape, rectFromJson(geometry.value(u"labelBoundingRect").toArray()) });
+    }
+    res.boundingRect = rectFromJson(data.value(u"boundingRect").toArray());
+    *result = res;
+    return true;
+}
@@ -0,0 +1,158 @@
+/*
+  This file is part of the KDAB State Machine Editor Library.
+
+  SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company <info@kdab.com>
+
+  SPDX-License-Identifier: LGPL-2.1-only OR LicenseRef-KDAB-KDStateMachineEditor
+
+  Licensees holding valid commercial KDAB State Machine Editor Library
+  licenses may use this file in accordance with the KDAB State Machine Editor
+  Library License Agreement provided with the Software.
+
+  Contact info@kdab.com if any conditions of this licensing are not clear to you.
+*/
+
+#ifndef KDSME_LAYOUT_REMOTELAYOUTER_H
+#define KDSME_LAYOUT_REMOTELAYOUTER_H
+
+#include "kdsme_core_export.h"
+
+#include "layouter.h"
+
+#include <QByteArray>
+
+QT_BEGIN_NAMESPACE
+class QRectF;
+QT_END_NAMESPACE
+
+namespace KDSME {
+
+class LayoutProperties;
+struct LayoutRegion;
+struct LayoutResult;
+class State;
+
+/**
+ * @brief Layouter running another layouter in a helper process
+ *
+ * Requests are sent to a pool of kdsme_layoutworker processes shared by all instances,
+ * so several large state machines can be laid out in parallel, and a layouter crashing or
+ * hanging on pathological input does not take the editor down with it.
+ *
+ * In case no worker is available, it crashed or it did not answer in time, the state is laid
+ * out in-process by fallbackLayouterName() instead, with a warning.
+ *
+ * The worker processes are stopped on QCoreApplication::aboutToQuit(), see stopWorkers().
+ *
+ * @note Blocks the calling thread until the layout is done, StateMachineScene therefore always
+ * lays out in the background when using a RemoteLayouter, see mayBlock()
+ */
+class KDSME_CORE_EXPORT RemoteLayouter : public Layouter
+{
+    Q_OBJECT
+    Q_PROPERTY(QByteArray layouterName READ layouterName WRITE setLayouterName NOTIFY layouterNameChanged FINAL)
+    Q_PROPERTY(int timeout READ timeout WRITE setTimeout NOTIFY timeoutChanged FINAL)
+    Q_PROPERTY(QByteArray fallbackLayouterName READ fallbackLayouterName WRITE setFallbackLayouterName NOTIFY fallbackLayouterNameChanged FINAL)
+
+public:
+    Q_INVOKABLE explicit RemoteLayouter(QObject *parent = nullptr);
+    ~RemoteLayouter();
+
+    /**
+     * Class name of the layouter run by the worker, e.g. "KDSME::GraphvizLayouter"
+     *
+     * @note Default is "KDSME::LayerwiseLayouter"
+     */
+    QByteArray layouterName() const;
+    void setLayouterName(const QByteArray &name);
+
+    /**
+     * Time in milliseconds after which a worker gets killed, -1 for no timeout
+     *
+     * @note Default is 30000
+     */
+    int timeout() const;
+    void setTimeout(int timeout);
+
+    /**
+     * Class name of the layouter run in-process in case the worker fails, empty for none
+     *
+     * Without a fallback, the geometry is left as it is and layout() returns an invalid rect.
+     *
+     * @note Default is "KDSME::SugiyamaLayouter", which does not depend on Graphviz
+     */
+    QByteArray fallbackLayouterName() const;
+    void setFallbackLayouterName(const QByteArray &name);
+
+    QRectF layout(State *state, const LayoutProperties *properties) override;
+    /// @return True, layout() waits for a worker process
+    bool mayBlock() const override;
+
+    /**
+     * Path of the worker executable
+     *
+     * @note Default is the KDSME_LAYOUT_WORKER environment variable, if set, otherwise
+     * kdsme_layoutworker in QCoreApplication::applicationDirPath()
+     */
+    static QString workerProgram();
+    static void setWorkerProgram(const QString &program);
+
+    /**
+     * Maximum number of worker processes running at the same time
+     *
+     * @note Default is QThread::idealThreadCount()
+     */
+    static int maximumWorkerCount();
+    static void setMaximumWorkerCount(int count);
+
+    /**
+     * Stop all worker processes, pending and later requests fail
+     *
+     * Done on QCoreApplication::aboutToQuit() already, call it before destroying the application
+     * object in case the event loop never ran.
+     */
+    static void stopWorkers();
+
+    /**
+     * Serialize everything @p layouterName needs for laying out @p state
+     *
+     * @sa processRequest()
+     */
+    static QByteArray encodeRequest(const State *state, const LayoutProperties *properties, const QByteArray &layouterName);
+    /**
+     * Lay out the state machine described by @p request, as done by the worker processes
+     *
+     * @return The reply to be passed to applyReply()
+     */
+    static QByteArray processRequest(const QByteArray &request);
+    /**
+     * Apply the layout from @p reply to @p state and its descendants
+     *
+     * @p boundingRect is set to the bounding rect the remote layouter returned.
+     * @return False in case @p reply is an error, or does not match @p state
+     */
+    static bool applyReply(const QByteArray &reply, State *state, QRectF *boundingRect = nullptr);
+
+    /**
+     * Lay out a single region with the built-in layer layouter in a worker process
+     *
+     * May be called from any thread, LayerwiseLayouter sends sibling regions to several
+     * workers at once this way. The geometry is written to @p result, not to the elements.
+     *
+     * @return False in case no worker answered within @p timeout milliseconds, or it failed
+     */
+    static bool layoutRegion(const LayoutRegion &region, const LayoutProperties *properties, int timeout, LayoutResult *result);
+
+Q_SIGNALS:
+    void layouterNameChanged(const QByteArray &name);
+    void timeoutChanged(int timeout);
+    void fallbackLayouterNameChanged(const QByteArray &name);
+
+private:
+    struct Private;
+    QScopedPointer<Private> d;
+};
+
+}
+
+#endif // KDSME_LAYOUT_REMOTELAYOUTER_H
@@ -0,0 +1,615 @@
+/*
+  This file is part of the KDAB State Machine Editor Library.
+
+  SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company <info@kdab.com>
+
+  SPDX-License-Identifier: LGPL-2.1-only OR LicenseRef-KDAB-KDStateMachineEditor
+
+  Licensees holding valid commercial KDAB State Machine Editor Library
+  licenses may use this file in accordance with the KDAB State Machine Editor
+  Library License Agreement provided with the Software.
+
+  Contact info@kdab.com if any conditions of this licensing are not clear to you.
+*/
+
+#include "sugiyamalayouter.h"
+
+#include "elementwalker.h"
+#include "layerwiselayouter.h"
+#include "layoutproperties.h"
+#include "layoutresult.h"
+#include "layoututils.h"
+#include "state.h"
+#include "transition.h"
+
+#include <QFontMetricsF>
+#include <QGuiApplication>
+#include <QHash>
+#include <QPainterPath>
+#include <QRectF>
+#include <QVector>
+
+#include <algorithm>
+
+using namespace KDSME;
+
+namespace {
+
+// Mimic the settings we use for dot, see GraphvizLayouterBackend
+const qreal DISPLAY_DPI = 96.0;
+const qreal NODE_SEPARATION = 0.2 * DISPLAY_DPI;
+const qreal RANK_SEPARATION = 0.5 * DISPLAY_DPI;
+const qreal MINIMUM_NODE_WIDTH = 0.75 * DISPLAY_DPI;
+const qreal MINIMUM_NODE_HEIGHT = 0.5 * DISPLAY_DPI;
+const qreal LABEL_MARGIN = 0.11 * DISPLAY_DPI;
+
+/// Horizontal space reserved for an edge passing through a layer
+const qreal DUMMY_NODE_WIDTH = 10.0;
+/// Horizontal distance between edges connecting the same two nodes
+const qreal PARALLEL_EDGE_DISTANCE = 12.0;
+const qreal SELF_LOOP_SIZE = 30.0;
+const qreal EDGE_LABEL_DISTANCE = 4.0;
+
+const int CROSSING_REDUCTION_SWEEPS = 12;
+const int COORDINATE_ASSIGNMENT_PASSES = 8;
+
+QSizeF sizeForState(const LayoutRegion::StateInput &state, const QFontMetricsF &fm)
+{
+    if (state.isInitialState) {
+        return QSizeF(0.2 * DISPLAY_DPI, 0.2 * DISPLAY_DPI);
+    }
+    if (state.type == Element::FinalStateType) {
+        return QSizeF(0.15 * DISPLAY_DPI, 0.15 * DISPLAY_DPI);
+    }
+
+    if (!qIsNull(state.width) && !qIsNull(state.height)) {
+        return QSizeF(state.width, state.height);
+    }
+
+    if (state.type == Element::HistoryStateType) {
+        return QSizeF(MINIMUM_NODE_HEIGHT, MINIMUM_NODE_HEIGHT);
+    }
+
+    const qreal width = fm.horizontalAdvance(state.label) + 2 * LABEL_MARGIN;
+    const qreal height = fm.height() + LABEL_MARGIN;
+    return QSizeF(qMax(MINIMUM_NODE_WIDTH, width), qMax(MINIMUM_NODE_HEIGHT, height));
+}
+
+struct Edge
+{
+    Transition *transition;
+    QString label;
+    int source;
+    int target;
+    /// Whether the edge got reversed to break a cycle, i.e. points upwards
+    bool reversed;
+    /// Nodes the edge passes through, from the upper to the lower layer
+    QVector<int> chain;
+};
+
+/**
+ * The graph of a single region
+ *
+ * Nodes [0, m_states.size()) represent the child states, all further nodes are dummy nodes
+ * of edges spanning more than one layer. Per-node data is kept in flat arrays indexed by node.
+ */
+class LayeredGraph
+{
+public:
+    LayeredGraph(const LayoutRegion &region, const LayoutProperties *properties);
+
+    LayoutResult result() const;
+
+private:
+    int addNode(qreal width, qreal height, int layer);
+
+    void removeCycles();
+    void assignLayers();
+    void insertDummyNodes();
+    void reduceCrossings();
+    void assignCoordinates();
+
+    void orderByBarycenter(int layer, const QVector<QVector<int>> &neighbors);
+    qint64 countCrossings() const;
+    void placeLayer(int layer, const QVector<QVector<int>> &neighbors);
+    qreal minimumDistance(int left, int right) const;
+
+    QRectF rectForNode(int node) const;
+    QPainterPath pathForEdge(const Edge &edge, qreal offset) const;
+
+    const LayoutProperties *m_properties;
+    const QFontMetricsF m_fontMetrics;
+
+    QVector<State *> m_states;
+    QVector<Edge> m_edges;
+
+    QVector<qreal> m_width;
+    QVector<qreal> m_height;
+    QVector<int> m_layer;
+    /// Index of the node within its layer
+    QVector<int> m_position;
+    /// Center coordinates
+    QVector<qreal> m_x;
+    QVector<qreal> m_y;
+    /// Neighbors in the layer above resp. below
+    QVector<QVector<int>> m_upper;
+    QVector<QVector<int>> m_lower;
+
+    QVector<QVector<int>> m_layers;
+};
+
+LayeredGraph::LayeredGraph(const LayoutRegion &region, const LayoutProperties *properties)
+    : m_properties(properties)
+    , m_fontMetrics(QGuiApplication::font())
+{
+    for (const LayoutRegion::StateInput &state : region.states) {
+        m_states.append(state.state);
+        const QSizeF size = sizeForState(state, m_fontMetrics);
+        addNode(size.width(), size.height(), 0);
+    }
+
+    // transitions leaving the region are not part of the input, as for GraphvizLayerLayouter
+    for (const LayoutRegion::TransitionInput &transition : region.transitions) {
+        m_edges.append(Edge { transition.transition, transition.label, transition.source, transition.target, false, {} });
+    }
+
+    removeCycles();
+    assignLayers();
+    insertDummyNodes();
+    reduceCrossings();
+    assignCoordinates();
+}
+
+int LayeredGraph::addNode(qreal width, qreal height, int layer)
+{
+    m_width.append(width);
+    m_height.append(height);
+    m_layer.append(layer);
+    m_position.append(0);
+    m_x.append(0);
+    m_y.append(0);
+    m_upper.append(QVector<int>());
+    m_lower.append(QVector<int>());
+    return m_width.size() - 1;
+}
+
+void LayeredGraph::removeCycles()
+{
+    const int nodeCount = m_states.size();
+    QVector<QVector<int>> outEdges(nodeCount);
+    for (int i = 0; i < m_edges.size(); ++i) {
+        if (m_edges.at(i).source != m_edges.at(i).target) {
+            outEdges[m_edges.at(i).source].append(i);
+        }
+    }
+
+    // iterative depth-first search, edges pointing back onto the stack close a cycle
+    enum VisitState : char
+    {
+        Unvisited,
+        OnStack,
+        Finished
+    };
+    QVector<char> visitState(nodeCount, Unvisited);
+    QVector<QPair<int, int>> stack; // node, index of the next edge to follow
+    for (int root = 0; root < nodeCount; ++root) {
+        if (visitState.at(root) != Unvisited) {
+            continue;
+        }
+
+        visitState[root] = OnStack;
+        stack.append(qMakePair(root, 0));
+        while (!stack.isEmpty()) {
+            const int node = stack.last().first;
+            const int next = stack.last().second;
+            if (next == outEdges.at(node).size()) {
+                visitState[node] = Finished;
+                stack.removeLast();
+                continue;
+            }
+
+            ++stack.last().second;
+            Edge &edge = m_edges[outEdges.at(node).at(next)];
+            if (visitState.at(edge.target) == OnStack) {
+                edge.reversed = true;
+            } else if (visitState.at(edge.target) == Unvisited) {
+                visitState[edge.target] = OnStack;
+                stack.append(qMakePair(edge.target, 0));
+            }
+        }
+    }
+}
+
+void LayeredGraph::assignLayers()
+{
+    // longest path layering, processing the nodes in topological order
+    const int nodeCount = m_states.size();
+    QVector<QVector<int>> successors(nodeCount);
+    QVector<int> inDegree(nodeCount, 0);
+    for (const Edge &edge : std::as_const(m_edges)) {
+        if (edge.source == edge.target) {
+            continue;
+        }
+        const int upper = edge.reversed ? edge.target : edge.source;
+        const int lower = edge.reversed ? edge.source : edge.target;
+        successors[upper].append(lower);
+        ++inDegree[lower];
+    }
+
+    QVector<int> queue;
+    queue.reserve(nodeCount);
+    for (int node = 0; node < nodeCount; ++node) {
+        if (inDegree.at(node) == 0) {
+            queue.append(node);
+        }
+    }
+    for (int i = 0; i < queue.size(); ++i) {
+        const int node = queue.at(i);
+        for (int successor : successors.at(node)) {
+            m_layer[successor] = qMax(m_layer.at(successor), m_layer.at(node) + 1);
+            if (--inDegree[successor] == 0) {
+                queue.append(successor);
+            }
+        }
+    }
+    Q_ASSERT(queue.size() == nodeCount);
+}
+
+void LayeredGraph::insertDummyNodes()
+{
+    for (Edge &edge : m_edges) {
+        if (edge.source == edge.target) {
+            edge.chain = { edge.source };
+            continue;
+        }
+
+        const int upper = edge.reversed ? edge.target : edge.source;
+        const int lower = edge.reversed ? edge.source : edge.target;
+        edge.chain.append(upper);
+        for (int layer = m_layer.at(upper) + 1; layer < m_layer.at(lower); ++layer) {
+            edge.chain.append(addNode(DUMMY_NODE_WIDTH, 0, layer));
+        }
+        edge.chain.append(lower);
+
+        for (int i = 0; i + 1 < edge.chain.size(); ++i) {
+            m_lower[edge.chain.at(i)].append(edge.chain.at(i + 1));
+            m_upper[edge.chain.at(i + 1)].append(edge.chain.at(i));
+        }
+    }
+
+    const int layerCount = m_layer.isEmpty() ? 0 : *std::max_element(m_layer.constBegin(), m_layer.constEnd()) + 1;
+    m_layers.resize(layerCount);
+    for (int node = 0; node < m_layer.size(); ++node) {
+        QVector<int> &layer = m_layers[m_layer.at(node)];
+        m_position[node] = layer.size();
+        layer.append(node);
+    }
+}
+
+void LayeredGraph::orderByBarycenter(int layer, const QVector<QVector<int>> &neighbors)
+{
+    QVector<int> &nodes = m_layers[layer];
+    QVector<QPair<qreal, int>> barycenters;
+    barycenters.reserve(nodes.size());
+    for (int node : std::as_const(nodes)) {
+        const QVector<int> &adjacent = neighbors.at(node);
+        qreal barycenter = m_position.at(node); // nodes without neighbors keep their place
+        if (!adjacent.isEmpty()) {
+            barycenter = 0;
+            for (int neighbor : adjacent) {
+                barycenter += m_position.at(neighbor);
+            }
+            barycenter /= adjacent.size();
+        }
+        barycenters.append(qMakePair(barycenter, node));
+    }
+
+    std::stable_sort(barycenters.begin(), barycenters.end(),
+                     [](const QPair<qreal, int> &lhs, const QPair<qreal, int> &rhs) { return lhs.first < rhs.first; });
+    for (int i = 0; i < barycenters.size(); ++i) {
+        nodes[i] = barycenters.at(i).second;
+        m_position[nodes.at(i)] = i;
+    }
+}
+
+qint64 LayeredGraph::countCrossings() const
+{
+    qint64 crossings = 0;
+    QVector<QPair<int, int>> edges;
+    QVector<int> tree;
+    for (int layer = 0; layer + 1 < m_layers.size(); ++layer) {
+        edges.clear();
+        for (int node : m_layers.at(layer)) {
+            for (int lower : m_lower.at(node)) {
+                edges.append(qMakePair(m_position.at(node), m_position.at(lower)));
+            }
+        }
+        std::sort(edges.begin(), edges.end());
+
+        // count the inversions of the lower end points with a Fenwick tree
+        tree.fill(0, m_layers.at(layer + 1).size() + 1);
+        for (int i = 0; i < edges.size(); ++i) {
+            int notGreater = 0;
+            for (int index = edges.at(i).second + 1; index > 0; index -= index & -index) {
+                notGreater += tree.at(index);
+            }
+            crossings += i - notGreater;
+            for (int index = edges.at(i).second + 1; index < tree.size(); index += index & -index) {
+                ++tree[index];
+            }
+        }
+    }
+    return crossings;
+}
+
+void LayeredGraph::reduceCrossings()
+{
+    QVector<QVector<int>> bestLayers = m_layers;
+    qint64 bestCrossings = countCrossings();
+    for (int sweep = 0; sweep < CROSSING_REDUCTION_SWEEPS && bestCrossings > 0; ++sweep) {
+        if (sweep % 2 == 0) {
+            for (int layer = 1; layer < m_layers.size(); ++layer) {
+                orderByBarycenter(layer, m_upper);
+            }
+        } else {
+            for (int layer = m_layers.size() - 2; layer >= 0; --layer) {
+                orderByBarycenter(layer, m_lower);
+            }
+        }
+
+        const qint64 crossings = countCrossings();
+        if (crossings < bestCrossings) {
+            bestCrossings = crossings;
+            bestLayers = m_layers;
+        }
+    }
+
+    m_layers = bestLayers;
+    for (const QVector<int> &layer : std::as_const(m_layers)) {
+        for (int i = 0; i < layer.size(); ++i) {
+            m_position[layer.at(i)] = i;
+        }
+    }
+}
+
+qreal LayeredGraph::minimumDistance(int left, int right) const
+{
+    const bool isDummy = left >= m_states.size() || right >= m_states.size();
+    return (m_width.at(left) + m_width.at(right)) / 2 + (isDummy ? NODE_SEPARATION / 2 : NODE_SEPARATION);
+}
+
+void LayeredGraph::placeLayer(int layer, const QVector<QVector<int>> &neighbors)
+{
+    const QVector<int> &nodes = m_layers.at(layer);
+    const int count = nodes.size();
+
+    // pull each node towards the mean of its neighbors, without changing the order
+    QVector<qreal> left(count);
+    QVector<qreal> right(count);
+    for (int i = 0; i < count; ++i) {
+        const QVector<int> &adjacent = neighbors.at(nodes.at(i));
+        qreal desired = m_x.at(nodes.at(i));
+        if (!adjacent.isEmpty()) {
+            desired = 0;
+            for (int neighbor : adjacent) {
+                desired += m_x.at(neighbor);
+            }
+            desired /= adjacent.size();
+        }
+        left[i] = right[i] = desired;
+    }
+    for (int i = 1; i < count; ++i) {
+        left[i] = qMax(left.at(i), left.at(i - 1) + minimumDistance(nodes.at(i - 1), nodes.at(i)));
+    }
+    for (int i = count - 2; i >= 0; --i) {
+        right[i] = qMin(right.at(i), right.at(i + 1) - minimumDistance(nodes.at(i), nodes.at(i + 1)));
+    }
+    for (int i = 0; i < count; ++i) {
+        qreal x = (left.at(i) + right.at(i)) / 2;
+        if (i > 0) {
+            x = qMax(x, m_x.at(nodes.at(i - 1)) + minimumDistance(nodes.at(i - 1), nodes.at(i)));
+        }
+        m_x[nodes.at(i)] = x;
+    }
+}
+
+void LayeredGraph::assignCoordinates()
+{
+    qreal top = 0;
+    for (const QVector<int> &layer : std::as_const(m_layers)) {
+        qreal height = 0;
+        for (int node : layer) {
+            height = qMax(height, m_height.at(node));
+        }
+        qreal x = 0;
+        for (int node : layer) {
+            m_y[node] = top + height / 2;
+            m_x[node] = x + m_width.at(node) / 2;
+            x += m_width.at(node) + NODE_SEPARATION;
+        }
+        top += height + RANK_SEPARATION;
+    }
+
+    for (int pass = 0; pass < COORDINATE_ASSIGNMENT_PASSES; ++pass) {
+        if (pass % 2 == 0) {
+            for (int layer = 1; layer < m_layers.size(); ++layer) {
+                placeLayer(layer, m_upper);
+            }
+        } else {
+            for (int layer = m_layers.size() - 2; layer >= 0; --layer) {
+                placeLayer(layer, m_lower);
+            }
+        }
+    }
+}
+
+QRectF LayeredGraph::rectForNode(int node) const
+{
+    return QRectF(m_x.at(node) - m_width.at(node) / 2, m_y.at(node) - m_height.at(node) / 2,
+                  m_width.at(node), m_height.at(node));
+}
+
+QPainterPath LayeredGraph::pathForEdge(const Edge &edge, qreal offset) const
+{
+    QPainterPath path;
+    if (edge.source == edge.target) {
+        const QRectF rect = rectForNode(edge.source);
+        path.moveTo(rect.right(), rect.center().y() - rect.height() / 4);
+        path.cubicTo(QPointF(rect.right() + SELF_LOOP_SIZE, rect.top() - rect.height() / 4),
+                     QPointF(rect.right() + SELF_LOOP_SIZE, rect.bottom() + rect.height() / 4),
+                     QPointF(rect.right(), rect.center().y() + rect.height() / 4));
+        return path;
+    }
+
+    QVector<QPointF> points;
+    points.reserve(edge.chain.size());
+    for (int node : edge.chain) {
+        points.append(QPointF(m_x.at(node), m_y.at(node)));
+    }
+    // end on the borders of the connected states
+    points.first().ry() += m_height.at(edge.chain.first()) / 2;
+    points.last().ry() -= m_height.at(edge.chain.last()) / 2;
+    if (edge.reversed) {
+        std::reverse(points.begin(), points.end());
+    }
+
+    path.moveTo(points.first());
+    for (int i = 0; i + 1 < points.size(); ++i) {
+        const QPointF &from = points.at(i);
+        const QPointF &to = points.at(i + 1);
+        const qreal middle = (from.y() + to.y()) / 2;
+        path.cubicTo(QPointF(from.x() + offset, middle), QPointF(to.x() + offset, middle), to);
+    }
+    return path;
+}
+
+LayoutResult LayeredGraph::result() const
+{
+    // spread edges connecting the same two states
+    QHash<QPair<int, int>, int> edgeCounts;
+    for (const Edge &edge : m_edges) {
+        ++edgeCounts[qMakePair(qMin(edge.source, edge.target), qMax(edge.source, edge.target))];
+    }
+    QHash<QPair<int, int>, int> edgeIndices;
+
+    QVector<QPainterPath> paths;
+    QVector<QRectF> labelRects;
+    paths.reserve(m_edges.size());
+    labelRects.reserve(m_edges.size());
+    QRectF boundingRect;
+    for (const Edge &edge : m_edges) {
+        const auto key = qMakePair(qMin(edge.source, edge.target), qMax(edge.source, edge.target));
+        const int index = edgeIndices[key]++;
+        const qreal offset = (index - (edgeCounts.value(key) - 1) / 2.0) * PARALLEL_EDGE_DISTANCE;
+        const QPainterPath path = pathForEdge(edge, offset);
+
+        QRectF labelRect;
+        const QString &label = edge.label;
+        if (!label.isEmpty() && m_properties->showTransitionLabels()) {
+            const QPointF center = path.pointAtPercent(0.5);
+            const qreal height = m_fontMetrics.height();
+            labelRect = QRectF(center.x() + EDGE_LABEL_DISTANCE, center.y() - height / 2,
+                               m_fontMetrics.horizontalAdvance(label), height);
+        }
+
+        paths.append(path);
+        labelRects.append(labelRect);
+        boundingRect = boundingRect.united(path.boundingRect()).united(labelRect);
+    }
+    for (int node = 0; node < m_states.size(); ++node) {
+        boundingRect = boundingRect.united(rectForNode(node));
+    }
+
+    // move everything such that the bounding rect starts at the origin
+    const QPointF origin = boundingRect.topLeft();
+
+    LayoutResult result;
+    result.boundingRect = QRectF(QPointF(), boundingRect.size());
+    result.states.reserve(m_states.size());
+    for (int node = 0; node < m_states.size(); ++node) {
+        const QRectF rect = rectForNode(node).translated(-origin);
+        result.states.append(LayoutResult::StateGeometry { m_states.at(node), rect.topLeft(), rect.width(), rect.height() });
+    }
+
+    result.transitions.reserve(m_edges.size());
+    for (int i = 0; i < m_edges.size(); ++i) {
+        const Edge &edge = m_edges.at(i);
+        const QPainterPath path = paths.at(i).translated(-origin);
+        const QRectF labelRect = labelRects.at(i).isNull() ? QRectF() : labelRects.at(i).translated(-origin);
+
+        // transitions are positioned relative to their source state
+        const QPointF absolutePos = labelRect.united(path.boundingRect()).topLeft();
+        const QPointF pos = absolutePos - result.states.at(edge.source).pos;
+        result.transitions.append(LayoutResult::TransitionGeometry { edge.transition, pos, path.translated(-absolutePos),
+                                                                     labelRect.isNull() ? QRectF() : labelRect.translated(-absolutePos) });
+    }
+    return result;
+}
+
+}
+
+SugiyamaLayouter::SugiyamaLayouter(QObject *parent)
+    : Layouter(parent)
+    , m_regionLayouter(new RegionLayouter(this))
+    , m_properties(nullptr)
+{
+}
+
+QRectF SugiyamaLayouter::layout(State *state, const LayoutProperties *properties)
+{
+    Q_ASSERT(state);
+    m_properties = properties;
+
+    beginLayout(state, properties);
+
+    ElementWalker walker(ElementWalker::PostOrderTraversal);
+    walker.walkItems(state, [&](Element *element) {
+        if (auto *region = qobject_cast<State *>(element)) {
+            layoutRegion(region);
+        }
+        return ElementWalker::RecursiveWalk;
+    });
+
+    endLayout();
+
+    return QRectF(QPointF(), QSizeF(state->width(), state->height()));
+}
+
+LayoutResult SugiyamaLayouter::computeLayout(const State *state, const LayoutProperties *properties)
+{
+    Q_ASSERT(state);
+    return computeLayout(LayoutRegion::fromState(state), properties);
+}
+
+LayoutResult SugiyamaLayouter::computeLayout(const LayoutRegion &region, const LayoutProperties *properties)
+{
+    Q_ASSERT(properties);
+
+    const LayeredGraph graph(region, properties);
+    return graph.result();
+}
+
+void SugiyamaLayouter::layoutRegion(State *state)
+{
+    if (state->childStates().isEmpty()) {
+        return;
+    }
+
+    // in incremental mode, regions which did not change keep their previous layout
+    QByteArray cacheKey;
+    if (!isDirty(state) || restoreFromCache(state, m_properties, &cacheKey)) {
+        return;
+    }
+
+    QRectF boundingRect;
+    if (state->isExpanded()) {
+        const LayoutResult result = computeLayout(state, m_properties);
+        result.apply();
+        boundingRect = result.boundingRect;
+    } else {
+        boundingRect = LayoutUtils::boundingRectForCollapsedRegion(state, m_properties);
+    }
+
+    m_regionLayouter->layoutRegion(state, boundingRect, m_properties);
+    storeInCache(state, cacheKey, boundingRect);
+}
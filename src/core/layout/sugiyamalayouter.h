@@ -0,0 +1,71 @@
+/*
+  This file is part of the KDAB State Machine Editor Library.
+
+  SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company <info@kdab.com>
+
+  SPDX-License-Identifier: LGPL-2.1-only OR LicenseRef-KDAB-KDStateMachineEditor
+
+  Licensees holding valid commercial KDAB State Machine Editor Library
+  licenses may use this file in accordance with the KDAB State Machine Editor
+  Library License Agreement provided with the Software.
+
+  Contact info@kdab.com if any conditions of this licensing are not clear to you.
+*/
+
+#ifndef KDSME_LAYOUT_SUGIYAMALAYOUTER_H
+#define KDSME_LAYOUT_SUGIYAMALAYOUTER_H
+
+#include "kdsme_core_export.h"
+
+#include "layouter.h"
+
+namespace KDSME {
+
+class LayoutProperties;
+class RegionLayouter;
+struct LayoutRegion;
+struct LayoutResult;
+
+/**
+ * @brief Layered (Sugiyama-style) layouter which does not depend on Graphviz
+ *
+ * Lays out each region on its own, innermost regions first, like LayerwiseLayouter does.
+ * Within a region, the child states are assigned to layers (longest path, after reversing
+ * the edges closing cycles), edges spanning several layers are split using dummy nodes,
+ * crossings are reduced with the barycenter heuristic and coordinates are assigned by
+ * iteratively pulling nodes towards their neighbors.
+ *
+ * All of this happens on flat arrays built from a LayoutRegion copied from the State/Transition tree.
+ */
+class KDSME_CORE_EXPORT SugiyamaLayouter : public Layouter
+{
+    Q_OBJECT
+
+public:
+    Q_INVOKABLE explicit SugiyamaLayouter(QObject *parent = nullptr);
+
+    QRectF layout(State *state, const LayoutProperties *properties) override;
+
+    /**
+     * Compute the layout of the direct children of @p state, without touching any element
+     *
+     * Only transitions between these children are taken into account.
+     */
+    static LayoutResult computeLayout(const State *state, const LayoutProperties *properties);
+    /**
+     * Compute the layout of the states of @p region
+     *
+     * @note May be called from a worker thread, only the copied inputs are read
+     */
+    static LayoutResult computeLayout(const LayoutRegion &region, const LayoutProperties *properties);
+
+private:
+    void layoutRegion(State *state);
+
+    RegionLayouter *m_regionLayouter;
+    const LayoutProperties *m_properties;
+};
+
+}
+
+#endif // KDSME_LAYOUT_SUGIYAMALAYOUTER_H
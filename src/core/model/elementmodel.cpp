@@ -17,6 +17,7 @@
 
 #include "objecthelper.h"
 #include "kdsmeconstants.h"
+#include "runtimecontroller.h"
 #include "state.h"
 #include "transition.h"
 
@@ -44,16 +45,67 @@ Qt::ItemFlags toItemFlags(Element::Flags flags)
 
 struct StateModel::Private
 {
-    Private();
+    explicit Private(StateModel *qq);
+
+    void setMachine(StateMachine *machine);
+    void setRuntimeController(RuntimeController *controller);
+    void statisticsChanged(const QList<Element *> &elements);
+
+    StateModel *q;
+    QPointer<StateMachine> m_machine;
+    QPointer<RuntimeController> m_runtimeController;
 };
 
-StateModel::Private::Private()
+StateModel::Private::Private(StateModel *qq)
+    : q(qq)
+{
+}
+
+void StateModel::Private::setMachine(StateMachine *machine)
+{
+    if (m_machine == machine)
+        return;
+
+    if (m_machine) {
+        QObject::disconnect(m_machine, &StateMachine::runtimeControllerChanged, q, nullptr);
+    }
+    m_machine = machine;
+    if (m_machine) {
+        QObject::connect(m_machine, &StateMachine::runtimeControllerChanged, q,
+                         [this](RuntimeController *controller) { setRuntimeController(controller); });
+    }
+    setRuntimeController(m_machine ? m_machine->runtimeController() : nullptr);
+}
+
+void StateModel::Private::setRuntimeController(RuntimeController *controller)
+{
+    if (m_runtimeController == controller)
+        return;
+
+    if (m_runtimeController) {
+        QObject::disconnect(m_runtimeController, &RuntimeController::statisticsChanged, q, nullptr);
+    }
+    m_runtimeController = controller;
+    if (m_runtimeController) {
+        QObject::connect(m_runtimeController, &RuntimeController::statisticsChanged, q,
+                         [this](const QList<Element *> &elements) { statisticsChanged(elements); });
+    }
+}
+
+void StateModel::Private::statisticsChanged(const QList<Element *> &elements)
 {
+    static const QList<int> roles = { VisitCountRole, DwellTimeRole, LastEnteredRole, FireCountRole };
+    for (Element *element : elements) {
+        const QModelIndex index = q->indexForObject(element);
+        if (index.isValid()) {
+            Q_EMIT q->dataChanged(index, index, roles);
+        }
+    }
 }
 
 StateModel::StateModel(QObject *parent)
     : ObjectTreeModel(parent)
-    , d(new Private)
+    , d(new Private(this))
 {
 }
 
@@ -69,6 +121,7 @@ State *StateModel::state() const
 void StateModel::setState(State *state)
 {
     setRootObject(state);
+    d->setMachine(state ? state->machine() : nullptr);
     Q_EMIT stateChanged();
 }
 
@@ -88,6 +141,26 @@ QVariant StateModel::data(const QModelIndex &index, int role) const
         return element->internalId();
     case Qt::EditRole:
         return element->label();
+    case VisitCountRole:
+    case DwellTimeRole:
+    case LastEnteredRole: {
+        auto *state = qobject_cast<State *>(element);
+        if (!state || !d->m_runtimeController) {
+            return QVariant();
+        }
+        const auto statistics = d->m_runtimeController->statisticsForState(state);
+        if (role == VisitCountRole) {
+            return statistics.visitCount;
+        }
+        return role == DwellTimeRole ? statistics.dwellTime : statistics.lastEntered;
+    }
+    case FireCountRole: {
+        auto *transition = qobject_cast<Transition *>(element);
+        if (!transition || !d->m_runtimeController) {
+            return QVariant();
+        }
+        return d->m_runtimeController->fireCountForTransition(transition);
+    }
     }
 
     return ObjectTreeModel::data(index, role);
@@ -117,6 +190,18 @@ Qt::ItemFlags StateModel::flags(const QModelIndex &index) const
     return toItemFlags(element->flags()) | Qt::ItemIsEnabled;
 }
 
+QHash<int, QByteArray> StateModel::roleNames() const
+{
+    QHash<int, QByteArray> roleNames = ObjectTreeModel::roleNames();
+    roleNames.insert(ElementRole, "element");
+    roleNames.insert(InternalIdRole, "internalId");
+    roleNames.insert(VisitCountRole, "visitCount");
+    roleNames.insert(DwellTimeRole, "dwellTime");
+    roleNames.insert(LastEnteredRole, "lastEntered");
+    roleNames.insert(FireCountRole, "fireCount");
+    return roleNames;
+}
+
 struct TransitionModel::Private
 {
 };
@@ -29,6 +29,7 @@ namespace KDSME {
 
 class StateModel;
 class State;
+class RuntimeController;
 
 class KDSME_CORE_EXPORT TransitionModel : public QSortFilterProxyModel
 {
@@ -96,6 +97,10 @@ public:
     {
         ElementRole = ObjectTreeModel::UserRole + 1, ///< return Element*
         InternalIdRole, ///< return quint64
+        VisitCountRole, ///< return quint64, for states, see RuntimeController::statisticsForState()
+        DwellTimeRole, ///< return qint64 in milliseconds, for states
+        LastEnteredRole, ///< return qint64 in RuntimeController::statisticsTime(), for states
+        FireCountRole, ///< return quint64, for transitions
     };
 
     explicit StateModel(QObject *parent = nullptr);
@@ -107,6 +112,7 @@ public:
     QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
     QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
     Qt::ItemFlags flags(const QModelIndex &index) const override;
+    QHash<int, QByteArray> roleNames() const override;
 
 Q_SIGNALS:
     void stateChanged();
@@ -17,18 +17,19 @@
 
 #include "ringbuffer.h"
 
-using namespace KDSME;
-
-namespace {
-
-template<typename ContainerType, typename ItemType>
-inline qreal relativePosition(const ContainerType &list, const ItemType &t)
-{
-    const int index = list.indexOf(t);
-    return (index + 1.0) / list.size();
-}
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMetaMethod>
+#include <QPointer>
+#include <QTimer>
+#include <QtAlgorithms>
+#include <QVarLengthArray>
+#include <QVector>
+
+#include <array>
+#include <utility>
 
-}
+using namespace KDSME;
 
 struct RuntimeController::Private
 {
@@ -37,37 +38,488 @@ struct RuntimeController::Private
         , m_lastConfigurations(5)
         , m_lastTransitions(5)
         , m_isRunning(false)
+        , m_pendingTransitions(5)
     {
+        m_updateTimer.setSingleShot(true);
+        m_updateTimer.setInterval(16);
+        m_updateTimer.setTimerType(Qt::PreciseTimer);
+        m_statisticsClock.start();
     }
 
-    void updateActiveRegion();
+    void publishConfiguration(QBitArray bits);
+    void publishTransition(Transition *transition);
+    void publishStatistics();
+
+    /**
+     * Update the statistics of the states entered and exited when switching to @p configuration
+     *
+     * @return False in case @p configuration equals the previous one
+     */
+    bool updateStateStatistics(const QBitArray &configuration);
+    void updateTransitionStatistics(Transition *transition);
+
+    /**
+     * Update the active region for switching from @p previous to @p configuration
+     *
+     * Entered states extend the region, exited ones only cause a recomputation from the
+     * cached rects of the active states in case they touch its border.
+     */
+    void updateActiveRegion(const QBitArray &previous, const QBitArray &configuration);
+    /// Recompute the active region from the rects of all active states, re-reading them if invalidated
+    void recomputeActiveRegion();
+    void setActiveRegion(const QRectF &region);
+    /// Called when the geometry of any active state or of one of its ancestors changed
+    void invalidateGeometry();
+    void watchGeometry(int index, State *state);
+    void unwatchGeometry(int index);
+    /**
+     * Recompute the activeness of all states in the history and notify the ones which changed
+     *
+     * Needs to be called whenever the history changed.
+     */
+    void updateActiveness();
+    /// Activeness of a state last active in configuration number @p lastActive
+    float activenessFor(quint64 lastActive) const;
+
+    /// Index of @p state, assigns the next free index to states seen for the first time
+    int indexFor(State *state);
+    QBitArray toBits(const Configuration &configuration);
+    Configuration fromBits(const QBitArray &bits) const;
+    /// Bit arrays created before further states got an index are shorter, missing bits are unset
+    static bool equalBits(const QBitArray &a, const QBitArray &b);
 
     RuntimeController *q;
 
-    RingBuffer<Configuration> m_lastConfigurations;
+    /// Dense indices of all states seen so far, and the other way round
+    QHash<State *, int> m_stateIndices;
+    QVector<QPointer<State>> m_states;
+
+    RingBuffer<QBitArray> m_lastConfigurations;
+    /// Set view of the newest configuration, built on demand
+    mutable Configuration m_activeConfiguration;
+    mutable bool m_activeConfigurationValid = true;
     RingBuffer<Transition *> m_lastTransitions;
     bool m_isRunning;
     QRectF m_activeRegion;
+
+    struct ActiveStateGeometry
+    {
+        QPointer<State> state;
+        /// In scene coordinates
+        QRectF rect;
+        /// The state and its ancestors, their geometry determines the rect
+        QVector<Element *> dependencies;
+    };
+    struct GeometryDependency
+    {
+        int refCount = 0;
+        std::array<QMetaObject::Connection, 4> connections;
+    };
+    /// Geometry of all states in the active configuration, by state index
+    QHash<int, ActiveStateGeometry> m_activeGeometry;
+    QHash<Element *, GeometryDependency> m_geometryDependencies;
+    bool m_geometryInvalid = false;
+    bool m_geometryUpdateScheduled = false;
+
+    struct ActivenessEntry
+    {
+        QPointer<State> state;
+        /// Number of the newest configuration containing the state
+        quint64 lastActive = 0;
+        float activeness = 0;
+    };
+    /// Number of configurations added so far, the active configuration has this number
+    quint64 m_configurationCount = 0;
+    /// Only states with an activeness > 0 are tracked
+    QHash<State *, ActivenessEntry> m_activeness;
+
+    bool m_coalesceUpdates = false;
+    QTimer m_updateTimer;
+    bool m_hasPendingConfiguration = false;
+    QBitArray m_pendingConfiguration;
+    /// Only the newest ones end up in the history anyway, hence same capacity
+    RingBuffer<Transition *> m_pendingTransitions;
+    quint64 m_pendingTransitionCount = 0;
+    quint64 m_transitionCount = 0;
+    quint64 m_skippedTransitionCount = 0;
+    quint64 m_skippedConfigurationCount = 0;
+
+    struct StateStatisticsEntry
+    {
+        QPointer<State> state;
+        StateStatistics statistics;
+        /// Time of entering the state, -1 unless it is active
+        qint64 enteredAt = -1;
+    };
+    struct TransitionStatisticsEntry
+    {
+        QPointer<Transition> transition;
+        quint64 fireCount = 0;
+    };
+    QElapsedTimer m_statisticsClock;
+    /// Newest configuration set, no matter whether it got published already
+    QBitArray m_receivedConfiguration;
+    QHash<State *, StateStatisticsEntry> m_stateStatistics;
+    QHash<Transition *, TransitionStatisticsEntry> m_transitionStatistics;
+    /// Elements whose statistics changed since the last statisticsChanged()
+    QSet<State *> m_changedStates;
+    QSet<Transition *> m_changedTransitions;
 };
 
-void RuntimeController::Private::updateActiveRegion()
+namespace {
+
+QRectF absoluteRect(const State *state)
+{
+    return QRectF(state->absolutePos(), QSizeF(state->width(), state->height()));
+}
+
+bool touchesBorder(const QRectF &rect, const QRectF &region)
+{
+    return rect.left() <= region.left() || rect.top() <= region.top()
+        || rect.right() >= region.right() || rect.bottom() >= region.bottom();
+}
+
+/// Call @p function with the index of each set bit of @p bits, skipping unset bytes at once
+template<typename Function>
+void forEachSetBit(const QBitArray &bits, Function function)
 {
-    const Configuration configuration = q->activeConfiguration();
+    const auto *data = reinterpret_cast<const uchar *>(bits.bits());
+    const qsizetype byteCount = (bits.size() + 7) / 8;
+    for (qsizetype byte = 0; byte < byteCount; ++byte) {
+        for (uint value = data[byte]; value; value &= value - 1) {
+            const qsizetype index = byte * 8 + qCountTrailingZeroBits(value);
+            if (index >= bits.size())
+                return;
+            function(static_cast<int>(index));
+        }
+    }
+}
+
+/// The bits differing between @p a and @p b, missing bits of the shorter one count as unset
+QBitArray changedBits(QBitArray a, QBitArray b)
+{
+    const qsizetype size = qMax(a.size(), b.size());
+    a.resize(size);
+    b.resize(size);
+    return a ^ b;
+}
 
-    // Calculate the bounding rect of all states in that are currently active
+bool testBit(const QBitArray &bits, int index)
+{
+    return index < bits.size() && bits.testBit(index);
+}
+
+}
+
+void RuntimeController::Private::updateActiveRegion(const QBitArray &previous, const QBitArray &configuration)
+{
+    bool shrinks = false;
+    QRectF activeRegion = m_activeRegion;
+    forEachSetBit(changedBits(previous, configuration), [&](int index) {
+        if (testBit(configuration, index)) {
+            State *state = m_states.at(index);
+            if (!state || m_activeGeometry.contains(index))
+                return;
+
+            watchGeometry(index, state);
+            activeRegion = activeRegion.united(m_activeGeometry.value(index).rect);
+        } else {
+            const auto it = m_activeGeometry.constFind(index);
+            if (it == m_activeGeometry.constEnd())
+                return;
+
+            shrinks = shrinks || touchesBorder(it->rect, m_activeRegion);
+            unwatchGeometry(index);
+        }
+    });
+
+    if (shrinks || m_geometryInvalid) {
+        recomputeActiveRegion();
+    } else {
+        setActiveRegion(activeRegion);
+    }
+}
+
+void RuntimeController::Private::recomputeActiveRegion()
+{
     QRectF activeRegion;
-    for (const State *state : configuration) {
-        activeRegion = activeRegion.united(state->boundingRect());
+    for (auto &geometry : m_activeGeometry) {
+        if (!geometry.state)
+            continue;
+
+        if (m_geometryInvalid) {
+            geometry.rect = absoluteRect(geometry.state);
+        }
+        activeRegion = activeRegion.united(geometry.rect);
     }
-    m_activeRegion = activeRegion;
+    m_geometryInvalid = false;
+    setActiveRegion(activeRegion);
+}
+
+void RuntimeController::Private::setActiveRegion(const QRectF &region)
+{
+    if (m_activeRegion == region)
+        return;
+
+    m_activeRegion = region;
     Q_EMIT q->activeRegionChanged(m_activeRegion);
 }
 
+void RuntimeController::Private::invalidateGeometry()
+{
+    m_geometryInvalid = true;
+    if (m_geometryUpdateScheduled)
+        return;
+
+    // a relayout changes lots of elements at once, recompute only once afterwards
+    m_geometryUpdateScheduled = true;
+    QMetaObject::invokeMethod(
+        q, [this]() {
+            m_geometryUpdateScheduled = false;
+            if (m_geometryInvalid) {
+                recomputeActiveRegion();
+            }
+        },
+        Qt::QueuedConnection);
+}
+
+void RuntimeController::Private::watchGeometry(int index, State *state)
+{
+    ActiveStateGeometry geometry;
+    geometry.state = state;
+    geometry.rect = absoluteRect(state);
+    for (Element *element = state; element; element = element->parentElement()) {
+        geometry.dependencies.append(element);
+
+        auto &dependency = m_geometryDependencies[element];
+        if (dependency.refCount++ > 0)
+            continue;
+
+        const auto invalidate = [this]() { invalidateGeometry(); };
+        dependency.connections = {
+            QObject::connect(element, &Element::posChanged, q, invalidate),
+            QObject::connect(element, &Element::widthChanged, q, invalidate),
+            QObject::connect(element, &Element::heightChanged, q, invalidate),
+            QObject::connect(element, &Element::parentChanged, q, invalidate),
+        };
+    }
+    m_activeGeometry.insert(index, geometry);
+}
+
+void RuntimeController::Private::unwatchGeometry(int index)
+{
+    // the elements may be gone already, only use them as keys
+    const ActiveStateGeometry geometry = m_activeGeometry.take(index);
+    for (Element *element : geometry.dependencies) {
+        auto it = m_geometryDependencies.find(element);
+        if (it == m_geometryDependencies.end() || --it->refCount > 0)
+            continue;
+
+        for (const auto &connection : it->connections) {
+            QObject::disconnect(connection);
+        }
+        m_geometryDependencies.erase(it);
+    }
+}
+
+void RuntimeController::Private::updateActiveness()
+{
+    for (auto it = m_activeness.begin(); it != m_activeness.end();) {
+        ActivenessEntry &entry = it.value();
+        const float activeness = activenessFor(entry.lastActive);
+        if (entry.state && !qFuzzyCompare(entry.activeness, activeness)) {
+            entry.activeness = activeness;
+            entry.state->setActiveness(activeness);
+        }
+
+        if (!entry.state || qFuzzyIsNull(activeness)) {
+            it = m_activeness.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+float RuntimeController::Private::activenessFor(quint64 lastActive) const
+{
+    const quint64 count = m_lastConfigurations.size();
+    const quint64 age = m_configurationCount - lastActive;
+    if (age >= count) {
+        return 0.;
+    }
+    return static_cast<float>(static_cast<qreal>(count - age) / count);
+}
+
+int RuntimeController::Private::indexFor(State *state)
+{
+    auto it = m_stateIndices.find(state);
+    if (it != m_stateIndices.end() && m_states.at(*it) == state) {
+        return *it;
+    }
+
+    // new state, or a new one allocated at the address of a deleted one
+    const int index = m_states.size();
+    m_states.append(state);
+    m_stateIndices.insert(state, index);
+    return index;
+}
+
+QBitArray RuntimeController::Private::toBits(const Configuration &configuration)
+{
+    QVarLengthArray<int, 32> indices;
+    for (State *state : configuration) {
+        indices.append(indexFor(state));
+    }
+
+    QBitArray bits(m_states.size());
+    for (int index : std::as_const(indices)) {
+        bits.setBit(index);
+    }
+    return bits;
+}
+
+RuntimeController::Configuration RuntimeController::Private::fromBits(const QBitArray &bits) const
+{
+    Configuration configuration;
+    for (int i = 0; i < bits.size(); ++i) {
+        if (bits.testBit(i)) {
+            if (State *state = m_states.at(i)) {
+                configuration.insert(state);
+            }
+        }
+    }
+    return configuration;
+}
+
+bool RuntimeController::Private::equalBits(const QBitArray &a, const QBitArray &b)
+{
+    if (a.size() == b.size()) {
+        return a == b;
+    }
+
+    const bool aIsShorter = a.size() < b.size();
+    QBitArray shorter = aIsShorter ? a : b;
+    const QBitArray &longer = aIsShorter ? b : a;
+    shorter.resize(longer.size());
+    return shorter == longer;
+}
+
+void RuntimeController::Private::publishStatistics()
+{
+    if (m_changedStates.isEmpty() && m_changedTransitions.isEmpty())
+        return;
+
+    // entries of deleted elements are left alone, their keys must not be dereferenced
+    QList<Element *> elements;
+    elements.reserve(m_changedStates.size() + m_changedTransitions.size());
+    for (State *state : std::as_const(m_changedStates)) {
+        if (m_stateStatistics.value(state).state) {
+            elements.append(state);
+        }
+    }
+    for (Transition *transition : std::as_const(m_changedTransitions)) {
+        if (m_transitionStatistics.value(transition).transition) {
+            elements.append(transition);
+        }
+    }
+    m_changedStates.clear();
+    m_changedTransitions.clear();
+
+    if (!elements.isEmpty()) {
+        Q_EMIT q->statisticsChanged(elements);
+    }
+}
+
+bool RuntimeController::Private::updateStateStatistics(const QBitArray &configuration)
+{
+    const qint64 now = m_statisticsClock.elapsed();
+    bool changed = false;
+
+    forEachSetBit(changedBits(m_receivedConfiguration, configuration), [&](int index) {
+        changed = true;
+        State *state = m_states.at(index);
+        if (!state)
+            return;
+
+        if (!testBit(configuration, index)) {
+            auto it = m_stateStatistics.find(state);
+            if (it == m_stateStatistics.end() || it->state != state || it->enteredAt < 0)
+                return;
+
+            it->statistics.dwellTime += now - it->enteredAt;
+            it->enteredAt = -1;
+            m_changedStates.insert(state);
+            return;
+        }
+
+        auto &entry = m_stateStatistics[state];
+        if (entry.state != state) {
+            // new state, or a new one allocated at the address of a deleted one
+            entry = StateStatisticsEntry();
+            entry.state = state;
+        }
+        ++entry.statistics.visitCount;
+        entry.statistics.lastEntered = now;
+        entry.enteredAt = now;
+        m_changedStates.insert(state);
+    });
+
+    m_receivedConfiguration = configuration;
+    return changed;
+}
+
+void RuntimeController::Private::updateTransitionStatistics(Transition *transition)
+{
+    auto &entry = m_transitionStatistics[transition];
+    if (entry.transition != transition) {
+        entry = TransitionStatisticsEntry();
+        entry.transition = transition;
+    }
+    ++entry.fireCount;
+    m_changedTransitions.insert(transition);
+}
+
+void RuntimeController::Private::publishConfiguration(QBitArray bits)
+{
+    const QBitArray previous = m_lastConfigurations.size() > 0 ? m_lastConfigurations.last() : QBitArray();
+    if (m_lastConfigurations.size() > 0 && equalBits(previous, bits))
+        return;
+
+    m_lastConfigurations.enqueue(bits);
+    m_activeConfigurationValid = false;
+    ++m_configurationCount;
+    forEachSetBit(bits, [this](int index) {
+        State *state = m_states.at(index);
+        if (!state)
+            return;
+
+        auto &entry = m_activeness[state];
+        if (!entry.state) {
+            entry.state = state;
+        }
+        entry.lastActive = m_configurationCount;
+    });
+    updateActiveness();
+
+    // the set view is only built for actual receivers
+    if (q->isSignalConnected(QMetaMethod::fromSignal(&RuntimeController::activeConfigurationChanged))) {
+        Q_EMIT q->activeConfigurationChanged(q->activeConfiguration());
+    }
+    updateActiveRegion(previous, bits);
+}
+
+void RuntimeController::Private::publishTransition(Transition *transition)
+{
+    m_lastTransitions.enqueue(transition);
+    Q_EMIT q->lastTransitionChanged(transition);
+}
+
 RuntimeController::RuntimeController(QObject *parent)
     : QObject(parent)
     , d(new Private(this))
 {
     qRegisterMetaType<QSet<State *>>();
+    connect(&d->m_updateTimer, &QTimer::timeout, this, &RuntimeController::flushUpdates);
 }
 
 RuntimeController::~RuntimeController()
@@ -83,6 +535,8 @@ void RuntimeController::setHistorySize(int size)
 {
     d->m_lastConfigurations.setCapacity(size);
     d->m_lastTransitions.setCapacity(size);
+    d->m_pendingTransitions.setCapacity(size);
+    d->updateActiveness();
 }
 
 QRectF RuntimeController::activeRegion() const
@@ -94,26 +548,238 @@ void RuntimeController::clear()
 {
     d->m_lastConfigurations.clear();
     d->m_lastTransitions.clear();
+    d->m_activeConfiguration.clear();
+    d->m_activeConfigurationValid = true;
+    const auto activeStates = d->m_activeGeometry.keys();
+    for (int index : activeStates) {
+        d->unwatchGeometry(index);
+    }
+    d->m_geometryInvalid = false;
+    d->setActiveRegion(QRectF());
+    d->m_stateIndices.clear();
+    d->m_states.clear();
+    d->updateActiveness();
+
+    d->m_updateTimer.stop();
+    d->m_hasPendingConfiguration = false;
+    d->m_pendingConfiguration.clear();
+    d->m_pendingTransitions.clear();
+    d->m_pendingTransitionCount = 0;
+    d->m_transitionCount = 0;
+    d->m_skippedTransitionCount = 0;
+    d->m_skippedConfigurationCount = 0;
+
+    d->m_receivedConfiguration.clear();
+    resetStatistics();
+}
+
+RuntimeController::StateStatistics RuntimeController::statisticsForState(State *state) const
+{
+    const auto it = d->m_stateStatistics.constFind(state);
+    if (it == d->m_stateStatistics.constEnd() || it->state != state) {
+        return StateStatistics();
+    }
+
+    StateStatistics statistics = it->statistics;
+    if (it->enteredAt >= 0) {
+        statistics.dwellTime += d->m_statisticsClock.elapsed() - it->enteredAt;
+    }
+    return statistics;
+}
+
+quint64 RuntimeController::fireCountForTransition(Transition *transition) const
+{
+    const auto it = d->m_transitionStatistics.constFind(transition);
+    return (it != d->m_transitionStatistics.constEnd() && it->transition == transition) ? it->fireCount : 0;
+}
+
+qint64 RuntimeController::statisticsTime() const
+{
+    return d->m_statisticsClock.elapsed();
+}
+
+void RuntimeController::setEnteredTime(State *state, qint64 time)
+{
+    const int index = indexOfState(state);
+    if (index < 0 || !testBit(d->m_receivedConfiguration, index))
+        return;
+
+    const auto it = d->m_stateStatistics.find(state);
+    if (it == d->m_stateStatistics.end() || it->state != state || it->enteredAt < 0 || it->enteredAt == time)
+        return;
+
+    // the visit got counted when the state got received, only its start changes
+    time = qMin(time, d->m_statisticsClock.elapsed());
+    it->statistics.lastEntered = time;
+    it->enteredAt = time;
+    d->m_changedStates.insert(state);
+
+    if (!d->m_coalesceUpdates) {
+        d->publishStatistics();
+    } else if (!d->m_updateTimer.isActive()) {
+        d->m_updateTimer.start();
+    }
+}
+
+void RuntimeController::resetStatistics()
+{
+    // everything which had statistics before changed
+    QList<Element *> elements;
+    for (const auto &entry : std::as_const(d->m_stateStatistics)) {
+        if (entry.state) {
+            elements.append(entry.state);
+        }
+    }
+    for (const auto &entry : std::as_const(d->m_transitionStatistics)) {
+        if (entry.transition) {
+            elements.append(entry.transition);
+        }
+    }
+
+    d->m_stateStatistics.clear();
+    d->m_transitionStatistics.clear();
+    d->m_changedStates.clear();
+    d->m_changedTransitions.clear();
+
+    // states active right now are still being visited
+    const qint64 now = d->m_statisticsClock.elapsed();
+    forEachSetBit(d->m_receivedConfiguration, [this, now](int index) {
+        State *state = d->m_states.at(index);
+        if (!state)
+            return;
+
+        auto &entry = d->m_stateStatistics[state];
+        entry.state = state;
+        entry.statistics.visitCount = 1;
+        entry.statistics.lastEntered = now;
+        entry.enteredAt = now;
+    });
+
+    if (!elements.isEmpty()) {
+        Q_EMIT statisticsChanged(elements);
+    }
+}
+
+bool RuntimeController::coalesceUpdates() const
+{
+    return d->m_coalesceUpdates;
+}
+
+void RuntimeController::setCoalesceUpdates(bool coalesce)
+{
+    if (d->m_coalesceUpdates == coalesce)
+        return;
+
+    if (!coalesce) {
+        flushUpdates();
+    }
+    d->m_coalesceUpdates = coalesce;
+    Q_EMIT coalesceUpdatesChanged(coalesce);
+}
+
+int RuntimeController::updateInterval() const
+{
+    return d->m_updateTimer.interval();
+}
+
+void RuntimeController::setUpdateInterval(int msecs)
+{
+    if (d->m_updateTimer.interval() == msecs)
+        return;
+
+    d->m_updateTimer.setInterval(msecs);
+    Q_EMIT updateIntervalChanged(msecs);
+}
+
+quint64 RuntimeController::transitionCount() const
+{
+    return d->m_transitionCount;
+}
+
+quint64 RuntimeController::skippedTransitionCount() const
+{
+    return d->m_skippedTransitionCount;
+}
+
+quint64 RuntimeController::skippedConfigurationCount() const
+{
+    return d->m_skippedConfigurationCount;
+}
+
+void RuntimeController::flushUpdates()
+{
+    d->m_updateTimer.stop();
+
+    // transitions first, so bindings re-evaluated on the configuration change see them already
+    if (d->m_pendingTransitionCount > 0) {
+        for (Transition *transition : std::as_const(d->m_pendingTransitions)) {
+            d->m_lastTransitions.enqueue(transition);
+        }
+        d->m_skippedTransitionCount += d->m_pendingTransitionCount - 1;
+        d->m_pendingTransitions.clear();
+        d->m_pendingTransitionCount = 0;
+        Q_EMIT lastTransitionChanged(lastTransition());
+    }
+
+    if (d->m_hasPendingConfiguration) {
+        d->m_hasPendingConfiguration = false;
+        d->publishConfiguration(std::exchange(d->m_pendingConfiguration, QBitArray()));
+    }
+    d->publishStatistics();
 }
 
 RuntimeController::Configuration RuntimeController::activeConfiguration() const
 {
-    return (d->m_lastConfigurations.size() > 0 ? d->m_lastConfigurations.last() : Configuration());
+    if (!d->m_activeConfigurationValid) {
+        d->m_activeConfiguration = d->fromBits(activeConfigurationBits());
+        d->m_activeConfigurationValid = true;
+    }
+    return d->m_activeConfiguration;
+}
+
+QBitArray RuntimeController::activeConfigurationBits() const
+{
+    return (d->m_lastConfigurations.size() > 0 ? d->m_lastConfigurations.last() : QBitArray());
 }
 
 QList<RuntimeController::Configuration> RuntimeController::lastConfigurations() const
 {
-    return d->m_lastConfigurations.entries();
+    QList<Configuration> configurations;
+    configurations.reserve(d->m_lastConfigurations.size());
+    for (const QBitArray &bits : d->m_lastConfigurations) {
+        configurations.append(d->fromBits(bits));
+    }
+    return configurations;
 }
 
 void RuntimeController::setActiveConfiguration(const RuntimeController::Configuration &configuration)
 {
-    if (d->m_lastConfigurations.size() > 0 && d->m_lastConfigurations.last() == configuration)
+    // the only lookup of the states, everything else works on the bits
+    QBitArray bits = d->toBits(configuration);
+    if (d->updateStateStatistics(bits)) {
+        Q_EMIT configurationReceived(configuration);
+    }
+
+    if (!d->m_coalesceUpdates) {
+        d->publishConfiguration(std::move(bits));
+        d->publishStatistics();
         return;
+    }
 
-    d->m_lastConfigurations.enqueue(configuration);
-    Q_EMIT activeConfigurationChanged(configuration);
-    d->updateActiveRegion();
+    if (d->m_hasPendingConfiguration) {
+        ++d->m_skippedConfigurationCount;
+    }
+    d->m_pendingConfiguration = std::move(bits);
+    d->m_hasPendingConfiguration = true;
+    if (!d->m_updateTimer.isActive()) {
+        d->m_updateTimer.start();
+    }
+}
+
+void RuntimeController::showConfiguration(const Configuration &configuration)
+{
+    flushUpdates();
+    d->publishConfiguration(d->toBits(configuration));
 }
 
 QList<Transition *> RuntimeController::lastTransitions() const
@@ -131,7 +797,48 @@ void RuntimeController::setLastTransition(Transition *transition)
     if (!transition)
         return;
 
-    d->m_lastTransitions.enqueue(transition);
+    ++d->m_transitionCount;
+    d->updateTransitionStatistics(transition);
+    Q_EMIT transitionReceived(transition);
+
+    if (!d->m_coalesceUpdates) {
+        d->publishTransition(transition);
+        d->publishStatistics();
+        return;
+    }
+
+    d->m_pendingTransitions.enqueue(transition);
+    ++d->m_pendingTransitionCount;
+    if (!d->m_updateTimer.isActive()) {
+        d->m_updateTimer.start();
+    }
+}
+
+void RuntimeController::showTransition(Transition *transition)
+{
+    if (!transition)
+        return;
+
+    flushUpdates();
+    d->publishTransition(transition);
+}
+
+int RuntimeController::indexOfState(State *state) const
+{
+    const auto it = d->m_stateIndices.constFind(state);
+    return (it != d->m_stateIndices.constEnd() && d->m_states.at(*it) == state) ? *it : -1;
+}
+
+State *RuntimeController::stateAt(int index) const
+{
+    return (index >= 0 && index < d->m_states.size()) ? d->m_states.at(index).data() : nullptr;
+}
+
+bool RuntimeController::isActive(State *state) const
+{
+    const int index = indexOfState(state);
+    const QBitArray bits = activeConfigurationBits();
+    return index >= 0 && index < bits.size() && bits.testBit(index);
 }
 
 bool RuntimeController::isRunning() const
@@ -150,16 +857,12 @@ void RuntimeController::setIsRunning(bool isRunning)
 
 float RuntimeController::activenessForState(State *state) const
 {
-    const int count = d->m_lastConfigurations.size();
-    for (int i = d->m_lastConfigurations.size() - 1; i >= 0; --i) {
-        if (d->m_lastConfigurations.at(i).contains(state)) {
-            return static_cast<float>((i + 1.) / count);
-        }
-    }
-    return 0.;
+    const auto it = d->m_activeness.constFind(state);
+    return it != d->m_activeness.constEnd() ? it->activeness : 0.f;
 }
 
 float RuntimeController::activenessForTransition(Transition *transition)
 {
-    return static_cast<float>(relativePosition<QList<Transition *>>(d->m_lastTransitions.entries(), transition));
+    const int index = d->m_lastTransitions.indexOf(transition);
+    return static_cast<float>((index + 1.) / d->m_lastTransitions.size());
 }
@@ -21,6 +21,7 @@
 #include "state.h"
 #include "transition.h"
 
+#include <QBitArray>
 #include <QObject>
 #include <QRectF>
 #include <QSet>
@@ -34,20 +35,80 @@ class KDSME_CORE_EXPORT RuntimeController : public QObject
     Q_PROPERTY(KDSME::Transition *lastTransition READ lastTransition NOTIFY lastTransitionChanged)
     Q_PROPERTY(bool isRunning READ isRunning NOTIFY isRunningChanged)
     Q_PROPERTY(QRectF activeRegion READ activeRegion NOTIFY activeRegionChanged)
+    Q_PROPERTY(bool coalesceUpdates READ coalesceUpdates WRITE setCoalesceUpdates NOTIFY coalesceUpdatesChanged FINAL)
+    Q_PROPERTY(int updateInterval READ updateInterval WRITE setUpdateInterval NOTIFY updateIntervalChanged FINAL)
 
 public:
+    /**
+     * Set of active states
+     *
+     * Internally, configurations are stored as bit arrays over dense per-controller state indices,
+     * the sets are a convenience view on these.
+     *
+     * @sa activeConfigurationBits(), indexOfState()
+     */
     typedef QSet<State *> Configuration;
 
+    /**
+     * Statistics accumulated for a state since the last resetStatistics()
+     *
+     * Times are in milliseconds, timestamps refer to statisticsTime().
+     */
+    struct StateStatistics
+    {
+        /// Number of times the state got entered
+        quint64 visitCount = 0;
+        /// Time spent in the state, including the current visit in case it is active
+        qint64 dwellTime = 0;
+        /**
+         * Time the state got entered the last time, meaningless if visitCount is 0
+         *
+         * Negative for visits which started before the statistics clock, see setEnteredTime().
+         */
+        qint64 lastEntered = -1;
+    };
+
     explicit RuntimeController(QObject *parent = nullptr);
     ~RuntimeController();
 
     Configuration activeConfiguration() const;
     QList<Configuration> lastConfigurations() const;
     void setActiveConfiguration(const Configuration &configuration);
+    /**
+     * Show @p configuration without it being a runtime event, e.g. when looking at the past
+     *
+     * The history, the activeness and the active region follow @p configuration just as for
+     * setActiveConfiguration(), but the statistics are left alone and configurationReceived()
+     * is not emitted. Pending coalesced updates are published first.
+     */
+    void showConfiguration(const Configuration &configuration);
+
+    /**
+     * The active configuration as bit array, bit @c i being set if stateAt(i) is active
+     *
+     * @note May be shorter than the number of states known, missing bits are unset
+     */
+    QBitArray activeConfigurationBits() const;
+    /**
+     * @return The index of @p state in configuration bit arrays, or -1 in case @p state
+     * was not part of any configuration since the last clear()
+     */
+    int indexOfState(State *state) const;
+    State *stateAt(int index) const;
+    /// @return True in case @p state is part of the active configuration
+    bool isActive(State *state) const;
 
     QList<Transition *> lastTransitions() const;
     Transition *lastTransition() const;
     void setLastTransition(Transition *transition);
+    /**
+     * Show @p transition as triggered without it being a runtime event, e.g. when catching up on
+     * what happened before connecting to a running machine
+     *
+     * Counterpart of showConfiguration(): the history and the activeness follow, but the statistics
+     * are left alone and transitionReceived() is not emitted.
+     */
+    void showTransition(Transition *transition);
 
     bool isRunning() const;
     void setIsRunning(bool isRunning);
@@ -58,15 +119,104 @@ public:
     int historySize() const;
     void setHistorySize(int size);
 
+    /**
+     * Bounding rect of all states in the active configuration, in scene coordinates
+     *
+     * Follows geometry changes of the active states and their ancestors, with a delay of one
+     * event loop iteration.
+     */
     QRectF activeRegion() const;
 
+    /**
+     * Whether configuration changes and triggered transitions are published at most once per updateInterval()
+     *
+     * Meant for machines transitioning faster than the view can render. Events are accumulated,
+     * and only the newest configuration is published, together with all transitions triggered
+     * in the meantime. Until then, the getters return the state of the last update.
+     *
+     * @note Default is false, every event is published right away
+     * @sa flushUpdates(), skippedTransitionCount()
+     */
+    bool coalesceUpdates() const;
+    void setCoalesceUpdates(bool coalesce);
+
+    /**
+     * Minimum time in milliseconds between two coalesced updates
+     *
+     * @note Default is 16, i.e. one update per frame at 60 Hz
+     */
+    int updateInterval() const;
+    void setUpdateInterval(int msecs);
+
+    /// Number of transitions triggered since the last clear(), including the ones not published yet
+    quint64 transitionCount() const;
+    /**
+     * Number of transitions which did not get an update of their own, because they were published
+     * together with later transitions
+     */
+    quint64 skippedTransitionCount() const;
+    /// Number of configurations replaced by newer ones before getting published
+    quint64 skippedConfigurationCount() const;
+
+    /**
+     * Statistics of @p state
+     *
+     * Statistics are updated for every configuration change, also when coalesceUpdates() is
+     * enabled. The entered and exited states are taken from the difference of the configuration
+     * bits, which costs one pass over the bit arrays plus constant time per entered and exited state.
+     *
+     * @sa statisticsChanged()
+     */
+    StateStatistics statisticsForState(State *state) const;
+    /// Number of times @p transition got triggered since the last resetStatistics()
+    quint64 fireCountForTransition(Transition *transition) const;
+    /// Milliseconds elapsed on the monotonic clock used for the statistics
+    qint64 statisticsTime() const;
+    /**
+     * Set the time the current visit of @p state started to @p time, on the statisticsTime() clock
+     *
+     * Meant for states entered before this controller learned about them, e.g. when connecting
+     * to a running machine. Does nothing unless @p state is part of the newest configuration set.
+     * The visit count is left alone, @p time may be negative.
+     */
+    void setEnteredTime(State *state, qint64 time);
+    /// Drop all statistics, done by clear() as well, and emit statisticsChanged() for the affected elements
+    void resetStatistics();
+
     void clear();
 
+public Q_SLOTS:
+    /**
+     * Publish accumulated events right away, e.g. before rendering a frame
+     *
+     * Does nothing unless coalesceUpdates() is enabled.
+     */
+    void flushUpdates();
+
 Q_SIGNALS:
     void activeConfigurationChanged(const QSet<KDSME::State *> &configuration);
     void lastTransitionChanged(KDSME::Transition *transition);
     void isRunningChanged(bool isRunning);
     void activeRegionChanged(const QRectF &region);
+    void coalesceUpdatesChanged(bool coalesce);
+    void updateIntervalChanged(int msecs);
+    /**
+     * Emitted along with each update, for the states and transitions whose statistics changed
+     * since the previous one
+     *
+     * @note The dwell time of active states grows continuously without notification
+     */
+    void statisticsChanged(const QList<KDSME::Element *> &elements);
+
+    /**
+     * Emitted for every configuration change as soon as it is set, also in case
+     * coalesceUpdates() is enabled
+     *
+     * Meant for recording the full runtime history, views should use activeConfigurationChanged().
+     */
+    void configurationReceived(const QSet<KDSME::State *> &configuration);
+    /// Emitted for every triggered transition as soon as it is set, see configurationReceived()
+    void transitionReceived(KDSME::Transition *transition);
 
 private:
     struct Private;
@@ -0,0 +1,572 @@
+/*
+  This file is part of the KDAB State Machine Editor Library.
+
+  SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company <info@kdab.com>
+
+  SPDX-License-Identifier: LGPL-2.1-only OR LicenseRef-KDAB-KDStateMachineEditor
+
+  Licensees holding valid commercial KDAB State Machine Editor Library
+  licenses may use this file in accordance with the KDAB State Machine Editor
+  Library License Agreement provided with the Software.
+
+  Contact info@kdab.com if any conditions of this licensing are not clear to you.
+*/
+
+#include "runtimehistory.h"
+
+#include "state.h"
+#include "transition.h"
+#include "varint_p.h"
+
+#include "debug.h"
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QPointer>
+#include <QSet>
+#include <QTemporaryFile>
+#include <QVarLengthArray>
+#include <QVector>
+
+#include <algorithm>
+#include <memory>
+
+using namespace KDSME;
+
+/*
+  Each segment holds a checkpoint, i.e. the configuration before its first event as
+  state count followed by the state indices, and then its events:
+
+    quint8  event type
+    varint  time delta to the previous event in the segment, in nanoseconds
+    varint  ConfigurationEvent: number of states entered or exited, followed by their indices
+            TransitionEvent: transition index
+
+  Numbers are encoded as in Varint, indices are assigned in order of first appearance.
+*/
+
+namespace {
+
+const int DEFAULT_CHECKPOINT_INTERVAL = 256;
+const qint64 DEFAULT_MEMORY_LIMIT = 64 * 1024 * 1024;
+
+struct Segment
+{
+    quint64 firstEvent = 0;
+    qint64 firstTime = 0;
+    qint64 lastTime = 0;
+    int eventCount = 0;
+    /// Checkpoint and events, empty while spilled to disk
+    QByteArray data;
+    qint64 spillOffset = -1;
+};
+
+/// Sequential decoding of a segment
+class SegmentReader
+{
+public:
+    SegmentReader(const Segment &segment, const QByteArray &data)
+        : m_data(reinterpret_cast<const uchar *>(data.constData()))
+        , m_size(data.size())
+        , time(segment.firstTime)
+    {
+        quint64 count = 0;
+        if (!readVarint(&count)) {
+            return;
+        }
+        for (quint64 i = 0; i < count; ++i) {
+            quint64 index;
+            if (!readVarint(&index)) {
+                return;
+            }
+            configuration.insert(static_cast<int>(index));
+        }
+    }
+
+    /// Read the next event, updating the members below
+    bool next()
+    {
+        if (m_offset >= m_size) {
+            return false;
+        }
+        type = static_cast<RuntimeHistory::Event::Type>(m_data[m_offset++]);
+
+        quint64 delta;
+        if (!readVarint(&delta)) {
+            return false;
+        }
+        time += static_cast<qint64>(delta);
+
+        if (type == RuntimeHistory::Event::TransitionEvent) {
+            quint64 index;
+            if (!readVarint(&index)) {
+                return false;
+            }
+            transition = static_cast<int>(index);
+            return true;
+        }
+
+        transition = -1;
+        quint64 count;
+        if (!readVarint(&count)) {
+            return false;
+        }
+        for (quint64 i = 0; i < count; ++i) {
+            quint64 index;
+            if (!readVarint(&index)) {
+                return false;
+            }
+            if (!configuration.remove(static_cast<int>(index))) {
+                configuration.insert(static_cast<int>(index));
+            }
+        }
+        return true;
+    }
+
+private:
+    bool readVarint(quint64 *value) { return Varint::read(m_data, m_size, &m_offset, value); }
+
+    const uchar *m_data;
+    qint64 m_size;
+    qint64 m_offset = 0;
+
+public:
+    RuntimeHistory::Event::Type type = RuntimeHistory::Event::ConfigurationEvent;
+    qint64 time;
+    QSet<int> configuration;
+    int transition = -1;
+};
+
+}
+
+struct RuntimeHistory::Private
+{
+    Private(RuntimeHistory *qq, RuntimeController *controller);
+
+    int stateIndex(State *state);
+    int transitionIndex(Transition *transition);
+
+    /// Start a new event of @p type, opening a new segment first if needed
+    QByteArray &beginEvent(Event::Type type);
+    void endEvent();
+    void logConfiguration(const RuntimeController::Configuration &configuration);
+    void logTransition(Transition *transition);
+
+    /// Move the oldest segments to disk until the memory limit is met
+    void spill();
+    /// @return The contents of the segment at @p index, read back from disk if spilled
+    QByteArray segmentData(int index) const;
+    /// @return The index of the segment containing event @p index
+    int segmentOf(quint64 index) const;
+
+    RuntimeController::Configuration toConfiguration(const QSet<int> &indices) const;
+    void apply(const RuntimeController::Configuration &configuration);
+    void setPosition(qint64 position);
+
+    RuntimeHistory *q;
+    QPointer<RuntimeController> m_controller;
+
+    QElapsedTimer m_clock;
+    QVector<Segment> m_segments;
+    quint64 m_eventCount = 0;
+    /// Indices of the states in the newest configuration
+    QSet<int> m_configuration;
+
+    QHash<State *, int> m_stateIndices;
+    QVector<QPointer<State>> m_states;
+    QHash<Transition *, int> m_transitionIndices;
+    QVector<QPointer<Transition>> m_transitions;
+
+    int m_checkpointInterval = DEFAULT_CHECKPOINT_INTERVAL;
+    qint64 m_memoryLimit = DEFAULT_MEMORY_LIMIT;
+    /// Size of the completed segments still in memory
+    qint64 m_memoryUsage = 0;
+    /// Index of the oldest segment not spilled yet
+    int m_firstInMemory = 0;
+    std::unique_ptr<QTemporaryFile> m_spillFile;
+    qint64 m_spilledSize = 0;
+    bool m_spillFailed = false;
+    /// The last segment read back from disk
+    mutable int m_cachedSegment = -1;
+    mutable QByteArray m_cachedData;
+
+    qint64 m_position = -1;
+};
+
+RuntimeHistory::Private::Private(RuntimeHistory *qq, RuntimeController *controller)
+    : q(qq)
+    , m_controller(controller)
+{
+    m_clock.start();
+}
+
+int RuntimeHistory::Private::stateIndex(State *state)
+{
+    const auto it = m_stateIndices.constFind(state);
+    if (it != m_stateIndices.constEnd() && m_states.at(*it) == state) {
+        return *it;
+    }
+
+    const int index = m_states.size();
+    m_states.append(state);
+    m_stateIndices.insert(state, index);
+    return index;
+}
+
+int RuntimeHistory::Private::transitionIndex(Transition *transition)
+{
+    const auto it = m_transitionIndices.constFind(transition);
+    if (it != m_transitionIndices.constEnd() && m_transitions.at(*it) == transition) {
+        return *it;
+    }
+
+    const int index = m_transitions.size();
+    m_transitions.append(transition);
+    m_transitionIndices.insert(transition, index);
+    return index;
+}
+
+QByteArray &RuntimeHistory::Private::beginEvent(Event::Type type)
+{
+    const qint64 now = m_clock.nsecsElapsed();
+    if (m_segments.isEmpty() || m_segments.last().eventCount >= m_checkpointInterval) {
+        if (!m_segments.isEmpty()) {
+            Segment &completed = m_segments.last();
+            completed.data.squeeze();
+            m_memoryUsage += completed.data.size();
+            spill();
+        }
+
+        Segment segment;
+        segment.firstEvent = m_eventCount;
+        segment.firstTime = now;
+        segment.lastTime = now;
+        Varint::append(segment.data, m_configuration.size());
+        for (int index : std::as_const(m_configuration)) {
+            Varint::append(segment.data, index);
+        }
+        m_segments.append(segment);
+    }
+
+    Segment &segment = m_segments.last();
+    segment.data.append(static_cast<char>(type));
+    Varint::append(segment.data, now - segment.lastTime);
+    segment.lastTime = now;
+    ++segment.eventCount;
+    return segment.data;
+}
+
+void RuntimeHistory::Private::endEvent()
+{
+    ++m_eventCount;
+    Q_EMIT q->eventCountChanged(m_eventCount);
+
+    // whoever feeds the controller moved it on, we are live again
+    setPosition(-1);
+}
+
+void RuntimeHistory::Private::logConfiguration(const RuntimeController::Configuration &configuration)
+{
+    QSet<int> indices;
+    indices.reserve(configuration.size());
+    for (State *state : configuration) {
+        indices.insert(stateIndex(state));
+    }
+
+    QVarLengthArray<int, 32> toggled;
+    for (int index : std::as_const(indices)) {
+        if (!m_configuration.contains(index)) {
+            toggled.append(index);
+        }
+    }
+    for (int index : std::as_const(m_configuration)) {
+        if (!indices.contains(index)) {
+            toggled.append(index);
+        }
+    }
+
+    QByteArray &data = beginEvent(Event::ConfigurationEvent);
+    Varint::append(data, toggled.size());
+    for (int index : std::as_const(toggled)) {
+        Varint::append(data, index);
+    }
+    m_configuration = indices;
+    endEvent();
+}
+
+void RuntimeHistory::Private::logTransition(Transition *transition)
+{
+    const int index = transitionIndex(transition);
+    QByteArray &data = beginEvent(Event::TransitionEvent);
+    Varint::append(data, index);
+    endEvent();
+}
+
+void RuntimeHistory::Private::spill()
+{
+    // the newest segment is still being written
+    while (m_memoryUsage > m_memoryLimit && m_firstInMemory < m_segments.size() - 1 && !m_spillFailed) {
+        if (!m_spillFile) {
+            m_spillFile.reset(new QTemporaryFile);
+            if (!m_spillFile->open()) {
+                qCWarning(KDSME_CORE) << "Failed to create spill file for the runtime history:" << m_spillFile->errorString();
+                m_spillFailed = true;
+                return;
+            }
+        }
+
+        Segment &segment = m_segments[m_firstInMemory];
+        if (!m_spillFile->seek(m_spilledSize) || m_spillFile->write(segment.data) != segment.data.size()) {
+            qCWarning(KDSME_CORE) << "Failed to spill the runtime history:" << m_spillFile->errorString();
+            m_spillFailed = true;
+            return;
+        }
+
+        segment.spillOffset = m_spilledSize;
+        m_spilledSize += segment.data.size();
+        m_memoryUsage -= segment.data.size();
+        segment.data = QByteArray();
+        ++m_firstInMemory;
+    }
+}
+
+QByteArray RuntimeHistory::Private::segmentData(int index) const
+{
+    const Segment &segment = m_segments.at(index);
+    if (segment.spillOffset < 0) {
+        return segment.data;
+    }
+    if (m_cachedSegment == index) {
+        return m_cachedData;
+    }
+
+    const qint64 end = (index + 1 < m_segments.size() && m_segments.at(index + 1).spillOffset >= 0)
+        ? m_segments.at(index + 1).spillOffset
+        : m_spilledSize;
+    if (!m_spillFile->seek(segment.spillOffset)) {
+        return QByteArray();
+    }
+    m_cachedData = m_spillFile->read(end - segment.spillOffset);
+    m_cachedSegment = index;
+    return m_cachedData;
+}
+
+int RuntimeHistory::Private::segmentOf(quint64 index) const
+{
+    const auto it = std::upper_bound(m_segments.cbegin(), m_segments.cend(), index,
+                                     [](quint64 index, const Segment &segment) { return index < segment.firstEvent; });
+    return static_cast<int>(it - m_segments.cbegin()) - 1;
+}
+
+RuntimeController::Configuration RuntimeHistory::Private::toConfiguration(const QSet<int> &indices) const
+{
+    RuntimeController::Configuration configuration;
+    configuration.reserve(indices.size());
+    for (int index : indices) {
+        if (State *state = m_states.value(index)) {
+            configuration.insert(state);
+        }
+    }
+    return configuration;
+}
+
+void RuntimeHistory::Private::apply(const RuntimeController::Configuration &configuration)
+{
+    if (!m_controller) {
+        return;
+    }
+
+    // neither counts in the statistics nor gets recorded, see RuntimeController::configurationReceived()
+    m_controller->showConfiguration(configuration);
+}
+
+void RuntimeHistory::Private::setPosition(qint64 position)
+{
+    if (m_position == position) {
+        return;
+    }
+
+    m_position = position;
+    Q_EMIT q->positionChanged(position);
+}
+
+RuntimeHistory::RuntimeHistory(RuntimeController *controller, QObject *parent)
+    : QObject(parent)
+    , d(new Private(this, controller))
+{
+    if (!controller) {
+        return;
+    }
+
+    connect(controller, &RuntimeController::configurationReceived, this,
+            [this](const RuntimeController::Configuration &configuration) { d->logConfiguration(configuration); });
+    connect(controller, &RuntimeController::transitionReceived, this,
+            [this](Transition *transition) { d->logTransition(transition); });
+
+    const auto configuration = controller->activeConfiguration();
+    if (!configuration.isEmpty()) {
+        d->logConfiguration(configuration);
+    }
+}
+
+RuntimeHistory::~RuntimeHistory()
+{
+}
+
+RuntimeController *RuntimeHistory::controller() const
+{
+    return d->m_controller;
+}
+
+quint64 RuntimeHistory::eventCount() const
+{
+    return d->m_eventCount;
+}
+
+qint64 RuntimeHistory::duration() const
+{
+    return d->m_segments.isEmpty() ? 0 : d->m_segments.last().lastTime;
+}
+
+RuntimeHistory::Event RuntimeHistory::event(quint64 index) const
+{
+    Event event;
+    if (index >= d->m_eventCount) {
+        return event;
+    }
+
+    const int segmentIndex = d->segmentOf(index);
+    const Segment &segment = d->m_segments.at(segmentIndex);
+    SegmentReader reader(segment, d->segmentData(segmentIndex));
+    for (quint64 i = segment.firstEvent; i <= index; ++i) {
+        if (!reader.next()) {
+            qCWarning(KDSME_CORE) << "Runtime history corrupt at event" << i;
+            break;
+        }
+    }
+
+    event.type = reader.type;
+    event.time = reader.time;
+    event.configuration = d->toConfiguration(reader.configuration);
+    if (reader.transition >= 0) {
+        event.transition = d->m_transitions.value(reader.transition);
+    }
+    return event;
+}
+
+RuntimeController::Configuration RuntimeHistory::configurationAt(quint64 index) const
+{
+    return event(index).configuration;
+}
+
+qint64 RuntimeHistory::eventAt(qint64 time) const
+{
+    const auto it = std::upper_bound(d->m_segments.cbegin(), d->m_segments.cend(), time,
+                                     [](qint64 time, const Segment &segment) { return time < segment.firstTime; });
+    if (it == d->m_segments.cbegin()) {
+        return -1;
+    }
+
+    const int segmentIndex = static_cast<int>(it - d->m_segments.cbegin()) - 1;
+    const Segment &segment = d->m_segments.at(segmentIndex);
+    if (time >= segment.lastTime) {
+        return static_cast<qint64>(segment.firstEvent) + segment.eventCount - 1;
+    }
+
+    SegmentReader reader(segment, d->segmentData(segmentIndex));
+    qint64 index = static_cast<qint64>(segment.firstEvent) - 1;
+    while (reader.next() && reader.time <= time) {
+        ++index;
+    }
+    return index;
+}
+
+qint64 RuntimeHistory::position() const
+{
+    return d->m_position;
+}
+
+int RuntimeHistory::checkpointInterval() const
+{
+    return d->m_checkpointInterval;
+}
+
+void RuntimeHistory::setCheckpointInterval(int interval)
+{
+    interval = qMax(interval, 1);
+    if (d->m_checkpointInterval == interval) {
+        return;
+    }
+
+    d->m_checkpointInterval = interval;
+    Q_EMIT checkpointIntervalChanged(interval);
+}
+
+qint64 RuntimeHistory::memoryLimit() const
+{
+    return d->m_memoryLimit;
+}
+
+void RuntimeHistory::setMemoryLimit(qint64 bytes)
+{
+    if (d->m_memoryLimit == bytes) {
+        return;
+    }
+
+    d->m_memoryLimit = bytes;
+    d->spill();
+    Q_EMIT memoryLimitChanged(bytes);
+}
+
+qint64 RuntimeHistory::memoryUsage() const
+{
+    return d->m_memoryUsage + (d->m_segments.isEmpty() ? 0 : d->m_segments.last().data.size());
+}
+
+qint64 RuntimeHistory::spilledSize() const
+{
+    return d->m_spilledSize;
+}
+
+void RuntimeHistory::seek(quint64 index)
+{
+    if (index >= d->m_eventCount) {
+        return;
+    }
+
+    d->apply(configurationAt(index));
+    d->setPosition(static_cast<qint64>(index));
+}
+
+void RuntimeHistory::seekToLive()
+{
+    if (d->m_position < 0) {
+        return;
+    }
+
+    d->apply(d->toConfiguration(d->m_configuration));
+    d->setPosition(-1);
+}
+
+void RuntimeHistory::clear()
+{
+    d->m_segments.clear();
+    d->m_eventCount = 0;
+    d->m_configuration.clear();
+    d->m_stateIndices.clear();
+    d->m_states.clear();
+    d->m_transitionIndices.clear();
+    d->m_transitions.clear();
+    d->m_memoryUsage = 0;
+    d->m_firstInMemory = 0;
+    d->m_spillFile.reset();
+    d->m_spilledSize = 0;
+    d->m_spillFailed = false;
+    d->m_cachedSegment = -1;
+    d->m_cachedData.clear();
+    d->m_clock.restart();
+    d->setPosition(-1);
+    Q_EMIT eventCountChanged(0);
+}
+
+#include "moc_runtimehistory.cpp"
@@ -0,0 +1,134 @@
+/*
+  This file is part of the KDAB State Machine Editor Library.
+
+  SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company <info@kdab.com>
+
+  SPDX-License-Identifier: LGPL-2.1-only OR LicenseRef-KDAB-KDStateMachineEditor
+
+  Licensees holding valid commercial KDAB State Machine Editor Library
+  licenses may use this file in accordance with the KDAB State Machine Editor
+  Library License Agreement provided with the Software.
+
+  Contact info@kdab.com if any conditions of this licensing are not clear to you.
+*/
+
+#ifndef KDSME_MODEL_RUNTIMEHISTORY_H
+#define KDSME_MODEL_RUNTIMEHISTORY_H
+
+#include "kdsme_core_export.h"
+
+#include "runtimecontroller.h"
+
+#include <QObject>
+#include <QScopedPointer>
+
+namespace KDSME {
+
+/**
+ * @brief Full event log of a RuntimeController, for jumping to any past event
+ *
+ * Unlike the history of RuntimeController, which only keeps the last few configurations, every
+ * configuration change and triggered transition is logged. Events are stored in segments of
+ * checkpointInterval() events, each starting with a checkpoint of the full configuration and
+ * followed by the changes to it. Looking up an event is a binary search over the segments plus
+ * decoding at most checkpointInterval() events.
+ *
+ * Once the segments kept in memory exceed memoryLimit(), the oldest ones get spilled to a
+ * temporary file and are read back on demand.
+ */
+class KDSME_CORE_EXPORT RuntimeHistory : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(quint64 eventCount READ eventCount NOTIFY eventCountChanged FINAL)
+    Q_PROPERTY(qint64 position READ position NOTIFY positionChanged FINAL)
+    Q_PROPERTY(int checkpointInterval READ checkpointInterval WRITE setCheckpointInterval NOTIFY checkpointIntervalChanged FINAL)
+    Q_PROPERTY(qint64 memoryLimit READ memoryLimit WRITE setMemoryLimit NOTIFY memoryLimitChanged FINAL)
+
+public:
+    struct Event
+    {
+        enum Type
+        {
+            ConfigurationEvent,
+            TransitionEvent
+        };
+
+        Type type = ConfigurationEvent;
+        /// In nanoseconds since the start of the history
+        qint64 time = 0;
+        /// Active configuration after the event
+        RuntimeController::Configuration configuration;
+        /// The triggered transition, in case of a TransitionEvent
+        Transition *transition = nullptr;
+    };
+
+    explicit RuntimeHistory(RuntimeController *controller, QObject *parent = nullptr);
+    ~RuntimeHistory();
+
+    RuntimeController *controller() const;
+
+    quint64 eventCount() const;
+    /// Time of the newest event, in nanoseconds since the start of the history
+    qint64 duration() const;
+
+    /**
+     * @return The event with the given @p index, an event with a null configuration in case
+     * @p index is out of range
+     */
+    Event event(quint64 index) const;
+    /// The active configuration after event @p index
+    RuntimeController::Configuration configurationAt(quint64 index) const;
+    /// @return The index of the newest event at or before @p time, -1 if there is none
+    qint64 eventAt(qint64 time) const;
+
+    /**
+     * Index of the event seek() moved to, -1 while following the controller live
+     *
+     * @note Events keep getting logged meanwhile
+     */
+    qint64 position() const;
+
+    /**
+     * Number of events between two checkpoints, applies from the next checkpoint on
+     *
+     * Smaller intervals make lookups faster, larger ones use less memory.
+     *
+     * @note Default is 256
+     */
+    int checkpointInterval() const;
+    void setCheckpointInterval(int interval);
+
+    /**
+     * Number of bytes of the log to keep in memory, older parts are spilled to a temporary file
+     *
+     * @note Default is 64 MiB
+     */
+    qint64 memoryLimit() const;
+    void setMemoryLimit(qint64 bytes);
+
+    /// Number of bytes of the log currently kept in memory
+    qint64 memoryUsage() const;
+    /// Number of bytes of the log spilled to disk
+    qint64 spilledSize() const;
+
+public Q_SLOTS:
+    /// Show the configuration after event @p index in the controller
+    void seek(quint64 index);
+    /// Show the newest configuration in the controller again
+    void seekToLive();
+    void clear();
+
+Q_SIGNALS:
+    void eventCountChanged(quint64 eventCount);
+    void positionChanged(qint64 position);
+    void checkpointIntervalChanged(int interval);
+    void memoryLimitChanged(qint64 bytes);
+
+private:
+    struct Private;
+    QScopedPointer<Private> d;
+};
+
+}
+
+#endif // KDSME_MODEL_RUNTIMEHISTORY_H
@@ -0,0 +1,811 @@
+/*
+  This file is part of the KDAB State Machine Editor Library.
+
+  SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company <info@kdab.com>
+
+  SPDX-License-Identifier: LGPL-2.1-only OR LicenseRef-KDAB-KDStateMachineEditor
+
+  Licensees holding valid commercial KDAB State Machine Editor Library
+  licenses may use this file in accordance with the KDAB State Machine Editor
+  Library License Agreement provided with the Software.
+
+  Contact info@kdab.com if any conditions of this licensing are not clear to you.
+*/
+
+#include "runtimetrace.h"
+
+#include "runtimecontroller.h"
+#include "state.h"
+#include "transition.h"
+#include "varint_p.h"
+
+#include "debug.h"
+
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QPointer>
+#include <QThread>
+#include <QTimer>
+#include <QVarLengthArray>
+#include <QVector>
+#include <QtEndian>
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <utility>
+
+using namespace KDSME;
+
+/*
+  Trace file format
+
+  Header:
+    "KDSMETRC"  magic
+    quint8      format version
+    qint64      wall clock time the recording started at, in ms since the epoch, little endian
+
+  Followed by records, each starting with a quint8 record type:
+    StateRecord          index, parent index + 1 (0 for the root), position among the parent's child states, label
+    TransitionRecord     index, source state index, position among the source's transitions, label
+    ConfigurationRecord  time delta, state count, state indices
+    TriggeredRecord      time delta, transition index
+
+  Numbers are unsigned LEB128 varints, labels are UTF-8 prefixed by their size in bytes. Time
+  deltas are in nanoseconds, relative to the previous event, resp. the start of the recording.
+  States and transitions get defined before their first use, indices are assigned in order.
+*/
+
+namespace {
+
+const char TRACE_MAGIC[] = "KDSMETRC";
+const int TRACE_MAGIC_SIZE = 8;
+const quint8 TRACE_VERSION = 1;
+const int TRACE_HEADER_SIZE = TRACE_MAGIC_SIZE + 1 + sizeof(qint64);
+
+/// Size of the buffers handed over to the writer thread
+const int CHUNK_SIZE = 64 * 1024;
+/// Maximum time in milliseconds events stay buffered before being written
+const int FLUSH_INTERVAL = 250;
+/// Maximum time in milliseconds spent replaying in one go, before returning to the event loop
+const int REPLAY_TIME_SLICE = 10;
+
+enum RecordType : quint8
+{
+    StateRecord = 1,
+    TransitionRecord,
+    ConfigurationRecord,
+    TriggeredRecord
+};
+
+void putString(QByteArray &buffer, const QString &string)
+{
+    const QByteArray utf8 = string.toUtf8();
+    Varint::append(buffer, utf8.size());
+    buffer.append(utf8);
+}
+
+/// @return The element at @p position in case its label matches, otherwise the first one with that label
+template<typename T>
+T *findElement(const QList<T *> &candidates, quint64 position, const QString &label)
+{
+    if (position < quint64(candidates.size()) && candidates.at(position)->label() == label) {
+        return candidates.at(position);
+    }
+    for (T *candidate : candidates) {
+        if (candidate->label() == label) {
+            return candidate;
+        }
+    }
+    return nullptr;
+}
+
+}
+
+struct RuntimeTraceRecorder::Private
+{
+    Private(RuntimeTraceRecorder *qq, RuntimeController *controller);
+
+    /// @return The index of @p state, defining it and its ancestors first if needed
+    int stateIndex(State *state);
+    int transitionIndex(Transition *transition);
+    void putEventTime();
+    void recordConfiguration(const RuntimeController::Configuration &configuration);
+    void recordTransition(Transition *transition);
+    /// Hand the buffered events over to the writer thread
+    void flush();
+
+    RuntimeTraceRecorder *q;
+    QPointer<RuntimeController> m_controller;
+
+    QThread *m_writerThread = nullptr;
+    /// Owned by the writer thread while recording
+    QFile *m_file = nullptr;
+    QByteArray m_buffer;
+    QTimer m_flushTimer;
+    QElapsedTimer m_clock;
+    qint64 m_lastEventTime = 0;
+    quint64 m_eventCount = 0;
+
+    QHash<State *, int> m_stateIndices;
+    QVector<QPointer<State>> m_states;
+    QHash<Transition *, int> m_transitionIndices;
+    QVector<QPointer<Transition>> m_transitions;
+
+    /// Written by the writer thread as well
+    QString m_errorString;
+    mutable QMutex m_errorMutex;
+};
+
+RuntimeTraceRecorder::Private::Private(RuntimeTraceRecorder *qq, RuntimeController *controller)
+    : q(qq)
+    , m_controller(controller)
+{
+    m_flushTimer.setInterval(FLUSH_INTERVAL);
+}
+
+int RuntimeTraceRecorder::Private::stateIndex(State *state)
+{
+    const auto it = m_stateIndices.constFind(state);
+    if (it != m_stateIndices.constEnd() && m_states.at(*it) == state) {
+        return *it;
+    }
+
+    State *parent = state->parentState();
+    const int parentIndex = parent ? stateIndex(parent) : -1;
+    const int index = m_states.size();
+    m_states.append(state);
+    m_stateIndices.insert(state, index);
+
+    m_buffer.append(static_cast<char>(StateRecord));
+    Varint::append(m_buffer, index);
+    Varint::append(m_buffer, parentIndex + 1);
+    Varint::append(m_buffer, parent ? qMax<qsizetype>(parent->childStates().indexOf(state), 0) : 0);
+    putString(m_buffer, state->label());
+    return index;
+}
+
+int RuntimeTraceRecorder::Private::transitionIndex(Transition *transition)
+{
+    const auto it = m_transitionIndices.constFind(transition);
+    if (it != m_transitionIndices.constEnd() && m_transitions.at(*it) == transition) {
+        return *it;
+    }
+
+    State *source = transition->sourceState();
+    if (!source) {
+        return -1;
+    }
+    const int sourceIndex = stateIndex(source);
+    const int index = m_transitions.size();
+    m_transitions.append(transition);
+    m_transitionIndices.insert(transition, index);
+
+    m_buffer.append(static_cast<char>(TransitionRecord));
+    Varint::append(m_buffer, index);
+    Varint::append(m_buffer, sourceIndex);
+    Varint::append(m_buffer, qMax<qsizetype>(source->transitions().indexOf(transition), 0));
+    putString(m_buffer, transition->label());
+    return index;
+}
+
+void RuntimeTraceRecorder::Private::putEventTime()
+{
+    const qint64 now = m_clock.nsecsElapsed();
+    Varint::append(m_buffer, now - m_lastEventTime);
+    m_lastEventTime = now;
+}
+
+void RuntimeTraceRecorder::Private::recordConfiguration(const RuntimeController::Configuration &configuration)
+{
+    // definitions go before the event referring to them
+    QVarLengthArray<int, 32> indices;
+    for (State *state : configuration) {
+        indices.append(stateIndex(state));
+    }
+
+    m_buffer.append(static_cast<char>(ConfigurationRecord));
+    putEventTime();
+    Varint::append(m_buffer, indices.size());
+    for (int index : std::as_const(indices)) {
+        Varint::append(m_buffer, index);
+    }
+
+    ++m_eventCount;
+    if (m_buffer.size() >= CHUNK_SIZE) {
+        flush();
+    }
+}
+
+void RuntimeTraceRecorder::Private::recordTransition(Transition *transition)
+{
+    const int index = transitionIndex(transition);
+    if (index < 0) {
+        return;
+    }
+
+    m_buffer.append(static_cast<char>(TriggeredRecord));
+    putEventTime();
+    Varint::append(m_buffer, index);
+
+    ++m_eventCount;
+    if (m_buffer.size() >= CHUNK_SIZE) {
+        flush();
+    }
+}
+
+void RuntimeTraceRecorder::Private::flush()
+{
+    if (m_buffer.isEmpty() || !m_file) {
+        return;
+    }
+
+    const QByteArray chunk = std::exchange(m_buffer, QByteArray());
+    m_buffer.reserve(CHUNK_SIZE);
+
+    QFile *file = m_file;
+    QMetaObject::invokeMethod(
+        file, [this, file, chunk]() {
+            if (file->write(chunk) == chunk.size()) {
+                return;
+            }
+            const QMutexLocker lock(&m_errorMutex);
+            if (m_errorString.isEmpty()) {
+                m_errorString = file->errorString();
+                qCWarning(KDSME_CORE) << "Failed to write runtime trace:" << m_errorString;
+            }
+        },
+        Qt::QueuedConnection);
+}
+
+RuntimeTraceRecorder::RuntimeTraceRecorder(RuntimeController *controller, QObject *parent)
+    : QObject(parent)
+    , d(new Private(this, controller))
+{
+    connect(&d->m_flushTimer, &QTimer::timeout, this, [this]() { d->flush(); });
+}
+
+RuntimeTraceRecorder::~RuntimeTraceRecorder()
+{
+    stop();
+}
+
+RuntimeController *RuntimeTraceRecorder::controller() const
+{
+    return d->m_controller;
+}
+
+bool RuntimeTraceRecorder::start(const QString &fileName)
+{
+    stop();
+
+    if (!d->m_controller) {
+        d->m_errorString = tr("No runtime controller to record");
+        return false;
+    }
+
+    auto file = std::make_unique<QFile>(fileName);
+    if (!file->open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        d->m_errorString = file->errorString();
+        return false;
+    }
+
+    d->m_errorString.clear();
+    d->m_eventCount = 0;
+    d->m_stateIndices.clear();
+    d->m_states.clear();
+    d->m_transitionIndices.clear();
+    d->m_transitions.clear();
+
+    d->m_buffer.clear();
+    d->m_buffer.reserve(CHUNK_SIZE);
+    d->m_buffer.append(TRACE_MAGIC, TRACE_MAGIC_SIZE);
+    d->m_buffer.append(static_cast<char>(TRACE_VERSION));
+    char startTime[sizeof(qint64)];
+    qToLittleEndian<qint64>(QDateTime::currentMSecsSinceEpoch(), startTime);
+    d->m_buffer.append(startTime, sizeof(startTime));
+
+    d->m_writerThread = new QThread;
+    d->m_writerThread->setObjectName(QStringLiteral("KDSME::RuntimeTraceRecorder"));
+    d->m_file = file.release();
+    d->m_file->moveToThread(d->m_writerThread);
+    d->m_writerThread->start();
+
+    d->m_clock.start();
+    d->m_lastEventTime = 0;
+    connect(d->m_controller, &RuntimeController::configurationReceived, this,
+            [this](const RuntimeController::Configuration &configuration) { d->recordConfiguration(configuration); });
+    connect(d->m_controller, &RuntimeController::transitionReceived, this,
+            [this](Transition *transition) { d->recordTransition(transition); });
+    d->m_flushTimer.start();
+
+    const auto configuration = d->m_controller->activeConfiguration();
+    if (!configuration.isEmpty()) {
+        d->recordConfiguration(configuration);
+    }
+
+    Q_EMIT isRecordingChanged(true);
+    return true;
+}
+
+void RuntimeTraceRecorder::stop()
+{
+    if (!isRecording()) {
+        return;
+    }
+
+    if (d->m_controller) {
+        disconnect(d->m_controller, nullptr, this, nullptr);
+    }
+    d->m_flushTimer.stop();
+    d->flush();
+
+    // queued after all pending writes
+    QFile *file = d->m_file;
+    QMetaObject::invokeMethod(
+        file, [file]() {
+            file->close();
+            QThread::currentThread()->quit();
+        },
+        Qt::QueuedConnection);
+    d->m_writerThread->wait();
+
+    delete d->m_file;
+    d->m_file = nullptr;
+    delete d->m_writerThread;
+    d->m_writerThread = nullptr;
+
+    Q_EMIT isRecordingChanged(false);
+}
+
+bool RuntimeTraceRecorder::isRecording() const
+{
+    return d->m_writerThread != nullptr;
+}
+
+quint64 RuntimeTraceRecorder::eventCount() const
+{
+    return d->m_eventCount;
+}
+
+QString RuntimeTraceRecorder::errorString() const
+{
+    const QMutexLocker lock(&d->m_errorMutex);
+    return d->m_errorString;
+}
+
+struct RuntimeTracePlayer::Private
+{
+    struct Event
+    {
+        RecordType type = ConfigurationRecord;
+        qint64 time = 0;
+        /// State indices, resp. the transition index
+        QVarLengthArray<quint64, 32> indices;
+    };
+
+    explicit Private(RuntimeTracePlayer *qq);
+
+    RuntimeController *controller() const;
+
+    bool readByte(quint8 *value);
+    bool readVarint(quint64 *value);
+    bool readString(QString *string);
+    bool readDefinition(RecordType type);
+    /**
+     * Read the records up to the next event into m_nextEvent
+     *
+     * @return False at the end of the trace, or in case it is corrupt
+     */
+    bool readNextEvent();
+    void applyEvent(const Event &event);
+
+    void rewind();
+    /// Replay all events which are due, and schedule the next call
+    void replay();
+    /// Recording time which is due according to the playback clock
+    qint64 dueTime() const;
+    void setPlaying(bool playing);
+    void setError(const QString &errorString);
+
+    RuntimeTracePlayer *q;
+    QPointer<StateMachine> m_machine;
+
+    QFile m_file;
+    /// Only used in case the file cannot be mapped
+    QByteArray m_contents;
+    const uchar *m_data = nullptr;
+    qint64 m_size = 0;
+    qint64 m_offset = 0;
+    QString m_errorString;
+
+    QVector<QPointer<State>> m_states;
+    QVector<QPointer<Transition>> m_transitions;
+    bool m_hasNextEvent = false;
+    Event m_nextEvent;
+    /// Time of the last event read, resp. applied
+    qint64 m_readTime = 0;
+    qint64 m_time = 0;
+    quint64 m_position = 0;
+
+    qreal m_speed = 1;
+    bool m_isPlaying = false;
+    QTimer m_timer;
+    QElapsedTimer m_playClock;
+    /// Recording time at the start of m_playClock
+    qint64 m_playStartTime = 0;
+};
+
+RuntimeTracePlayer::Private::Private(RuntimeTracePlayer *qq)
+    : q(qq)
+{
+    m_timer.setSingleShot(true);
+    m_timer.setTimerType(Qt::PreciseTimer);
+}
+
+RuntimeController *RuntimeTracePlayer::Private::controller() const
+{
+    return m_machine ? m_machine->runtimeController() : nullptr;
+}
+
+bool RuntimeTracePlayer::Private::readByte(quint8 *value)
+{
+    if (m_offset >= m_size) {
+        return false;
+    }
+    *value = m_data[m_offset++];
+    return true;
+}
+
+bool RuntimeTracePlayer::Private::readVarint(quint64 *value)
+{
+    return Varint::read(m_data, m_size, &m_offset, value);
+}
+
+bool RuntimeTracePlayer::Private::readString(QString *string)
+{
+    quint64 size;
+    if (!readVarint(&size) || size > quint64(m_size - m_offset)) {
+        return false;
+    }
+    *string = QString::fromUtf8(reinterpret_cast<const char *>(m_data + m_offset), static_cast<qsizetype>(size));
+    m_offset += static_cast<qint64>(size);
+    return true;
+}
+
+bool RuntimeTracePlayer::Private::readDefinition(RecordType type)
+{
+    quint64 index;
+    quint64 reference;
+    quint64 position;
+    QString label;
+    if (!readVarint(&index) || !readVarint(&reference) || !readVarint(&position) || !readString(&label)) {
+        return false;
+    }
+
+    if (type == StateRecord) {
+        if (index != quint64(m_states.size()) || reference > quint64(m_states.size())) {
+            return false;
+        }
+
+        State *state = nullptr;
+        if (reference == 0) {
+            state = m_machine;
+        } else if (State *parent = m_states.at(reference - 1)) {
+            state = findElement(parent->childStates(), position, label);
+        }
+        if (!state) {
+            qCWarning(KDSME_CORE) << "Traced state not found in the machine:" << label;
+        }
+        m_states.append(state);
+    } else {
+        if (index != quint64(m_transitions.size()) || reference >= quint64(m_states.size())) {
+            return false;
+        }
+
+        Transition *transition = nullptr;
+        if (State *source = m_states.at(reference)) {
+            transition = findElement(source->transitions(), position, label);
+        }
+        m_transitions.append(transition);
+    }
+    return true;
+}
+
+bool RuntimeTracePlayer::Private::readNextEvent()
+{
+    while (m_offset < m_size) {
+        const qint64 recordOffset = m_offset;
+        quint8 type = 0;
+        readByte(&type);
+
+        bool ok = false;
+        switch (type) {
+        case StateRecord:
+        case TransitionRecord:
+            if (readDefinition(static_cast<RecordType>(type))) {
+                continue;
+            }
+            break;
+        case ConfigurationRecord:
+        case TriggeredRecord: {
+            quint64 delta;
+            quint64 count = 1;
+            if (!readVarint(&delta) || (type == ConfigurationRecord && !readVarint(&count))) {
+                break;
+            }
+
+            m_nextEvent.type = static_cast<RecordType>(type);
+            m_readTime += static_cast<qint64>(delta);
+            m_nextEvent.time = m_readTime;
+            m_nextEvent.indices.clear();
+            ok = true;
+            for (quint64 i = 0; ok && i < count; ++i) {
+                quint64 index;
+                ok = readVarint(&index);
+                m_nextEvent.indices.append(index);
+            }
+            if (ok) {
+                return true;
+            }
+            break;
+        }
+        default:
+            break;
+        }
+
+        setError(RuntimeTracePlayer::tr("Corrupt trace at offset %1").arg(recordOffset));
+        return false;
+    }
+    return false;
+}
+
+void RuntimeTracePlayer::Private::applyEvent(const Event &event)
+{
+    m_time = event.time;
+    ++m_position;
+
+    RuntimeController *controller = this->controller();
+    if (!controller) {
+        return;
+    }
+
+    if (event.type == ConfigurationRecord) {
+        RuntimeController::Configuration configuration;
+        configuration.reserve(event.indices.size());
+        for (quint64 index : event.indices) {
+            if (State *state = m_states.value(static_cast<qsizetype>(index))) {
+                configuration.insert(state);
+            }
+        }
+        controller->setActiveConfiguration(configuration);
+    } else {
+        controller->setLastTransition(m_transitions.value(static_cast<qsizetype>(event.indices.value(0))));
+    }
+}
+
+void RuntimeTracePlayer::Private::rewind()
+{
+    m_offset = m_data ? TRACE_HEADER_SIZE : 0;
+    m_states.clear();
+    m_transitions.clear();
+    m_readTime = 0;
+    m_time = 0;
+    m_position = 0;
+    m_hasNextEvent = readNextEvent();
+}
+
+void RuntimeTracePlayer::Private::replay()
+{
+    QElapsedTimer slice;
+    slice.start();
+    while (m_hasNextEvent) {
+        if (m_speed > 0) {
+            const qint64 remaining = m_nextEvent.time - dueTime();
+            if (remaining > 0) {
+                const qreal msecs = std::ceil(remaining / m_speed / 1000000.);
+                m_timer.start(static_cast<int>(qMin<qreal>(msecs, std::numeric_limits<int>::max())));
+                return;
+            }
+        }
+        // also when replaying in real time, a backlog of due events must not block rendering
+        if (slice.elapsed() >= REPLAY_TIME_SLICE) {
+            m_timer.start(0);
+            return;
+        }
+
+        applyEvent(m_nextEvent);
+        m_hasNextEvent = readNextEvent();
+        if (!m_isPlaying) {
+            // paused by a slot connected to the controller
+            return;
+        }
+    }
+
+    setPlaying(false);
+    Q_EMIT q->finished();
+}
+
+qint64 RuntimeTracePlayer::Private::dueTime() const
+{
+    return m_playStartTime + static_cast<qint64>(m_playClock.nsecsElapsed() * m_speed);
+}
+
+void RuntimeTracePlayer::Private::setPlaying(bool playing)
+{
+    if (m_isPlaying == playing) {
+        return;
+    }
+
+    m_isPlaying = playing;
+    if (!playing) {
+        m_timer.stop();
+    }
+    Q_EMIT q->isPlayingChanged(playing);
+}
+
+void RuntimeTracePlayer::Private::setError(const QString &errorString)
+{
+    m_errorString = errorString;
+    qCWarning(KDSME_CORE) << "Failed to replay runtime trace:" << errorString;
+    setPlaying(false);
+}
+
+RuntimeTracePlayer::RuntimeTracePlayer(QObject *parent)
+    : QObject(parent)
+    , d(new Private(this))
+{
+    connect(&d->m_timer, &QTimer::timeout, this, [this]() { d->replay(); });
+}
+
+RuntimeTracePlayer::~RuntimeTracePlayer()
+{
+}
+
+StateMachine *RuntimeTracePlayer::machine() const
+{
+    return d->m_machine;
+}
+
+void RuntimeTracePlayer::setMachine(StateMachine *machine)
+{
+    if (d->m_machine == machine) {
+        return;
+    }
+
+    d->m_machine = machine;
+    if (isOpen()) {
+        // states and transitions need to be resolved again
+        pause();
+        d->rewind();
+    }
+    Q_EMIT machineChanged(machine);
+}
+
+bool RuntimeTracePlayer::open(const QString &fileName)
+{
+    close();
+
+    d->m_file.setFileName(fileName);
+    if (!d->m_file.open(QIODevice::ReadOnly)) {
+        d->m_errorString = d->m_file.errorString();
+        return false;
+    }
+
+    d->m_size = d->m_file.size();
+    d->m_data = d->m_file.map(0, d->m_size);
+    if (!d->m_data) {
+        d->m_contents = d->m_file.readAll();
+        d->m_data = reinterpret_cast<const uchar *>(d->m_contents.constData());
+        d->m_size = d->m_contents.size();
+    }
+
+    if (d->m_size < TRACE_HEADER_SIZE || std::memcmp(d->m_data, TRACE_MAGIC, TRACE_MAGIC_SIZE) != 0) {
+        close();
+        d->m_errorString = tr("Not a runtime trace");
+        return false;
+    }
+    if (d->m_data[TRACE_MAGIC_SIZE] != TRACE_VERSION) {
+        close();
+        d->m_errorString = tr("Unsupported runtime trace version %1").arg(d->m_data[TRACE_MAGIC_SIZE]);
+        return false;
+    }
+
+    d->m_errorString.clear();
+    d->rewind();
+    return true;
+}
+
+void RuntimeTracePlayer::close()
+{
+    pause();
+    d->m_file.close();
+    d->m_contents.clear();
+    d->m_data = nullptr;
+    d->m_size = 0;
+    d->rewind();
+}
+
+bool RuntimeTracePlayer::isOpen() const
+{
+    return d->m_data != nullptr;
+}
+
+QString RuntimeTracePlayer::errorString() const
+{
+    return d->m_errorString;
+}
+
+qreal RuntimeTracePlayer::speed() const
+{
+    return d->m_speed;
+}
+
+void RuntimeTracePlayer::setSpeed(qreal speed)
+{
+    speed = qMax<qreal>(speed, 0);
+    if (qFuzzyCompare(d->m_speed, speed)) {
+        return;
+    }
+
+    if (d->m_isPlaying) {
+        // continue from where we are with the new pace
+        d->m_playStartTime = d->m_speed > 0 ? d->dueTime() : d->m_time;
+        d->m_playClock.start();
+        d->m_timer.start(0);
+    }
+    d->m_speed = speed;
+    Q_EMIT speedChanged(speed);
+}
+
+bool RuntimeTracePlayer::isPlaying() const
+{
+    return d->m_isPlaying;
+}
+
+quint64 RuntimeTracePlayer::position() const
+{
+    return d->m_position;
+}
+
+qint64 RuntimeTracePlayer::time() const
+{
+    return d->m_time;
+}
+
+bool RuntimeTracePlayer::atEnd() const
+{
+    return !d->m_hasNextEvent;
+}
+
+void RuntimeTracePlayer::play()
+{
+    if (d->m_isPlaying || !d->m_hasNextEvent) {
+        return;
+    }
+
+    d->m_playStartTime = d->m_time;
+    d->m_playClock.start();
+    d->setPlaying(true);
+    d->m_timer.start(0);
+}
+
+void RuntimeTracePlayer::pause()
+{
+    d->setPlaying(false);
+}
+
+void RuntimeTracePlayer::stop()
+{
+    pause();
+    d->rewind();
+    if (RuntimeController *controller = d->controller()) {
+        controller->clear();
+    }
+}
+
+#include "moc_runtimetrace.cpp"
@@ -0,0 +1,140 @@
+/*
+  This file is part of the KDAB State Machine Editor Library.
+
+  SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company <info@kdab.com>
+
+  SPDX-License-Identifier: LGPL-2.1-only OR LicenseRef-KDAB-KDStateMachineEditor
+
+  Licensees holding valid commercial KDAB State Machine Editor Library
+  licenses may use this file in accordance with the KDAB State Machine Editor
+  Library License Agreement provided with the Software.
+
+  Contact info@kdab.com if any conditions of this licensing are not clear to you.
+*/
+
+#ifndef KDSME_MODEL_RUNTIMETRACE_H
+#define KDSME_MODEL_RUNTIMETRACE_H
+
+#include "kdsme_core_export.h"
+
+#include <QObject>
+#include <QScopedPointer>
+
+namespace KDSME {
+
+class RuntimeController;
+class StateMachine;
+
+/**
+ * @brief Records the events of a RuntimeController into a binary trace file
+ *
+ * Every configuration change and triggered transition is recorded with a monotonic timestamp,
+ * also in case the controller coalesces its updates. Events are encoded into a memory buffer on
+ * the calling thread, writing to disk happens in a separate thread.
+ *
+ * States and transitions are identified by their position and label in the state machine, so
+ * traces can be replayed on another instance of the same machine.
+ *
+ * @sa RuntimeTracePlayer
+ */
+class KDSME_CORE_EXPORT RuntimeTraceRecorder : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(bool isRecording READ isRecording NOTIFY isRecordingChanged FINAL)
+
+public:
+    explicit RuntimeTraceRecorder(RuntimeController *controller, QObject *parent = nullptr);
+    ~RuntimeTraceRecorder();
+
+    RuntimeController *controller() const;
+
+    /**
+     * Start recording into @p fileName, replacing its contents
+     *
+     * @return False in case the file could not be opened, see errorString()
+     */
+    bool start(const QString &fileName);
+    /// Stop recording, returns once everything recorded so far is written
+    void stop();
+    bool isRecording() const;
+
+    /// Number of events recorded since start()
+    quint64 eventCount() const;
+    QString errorString() const;
+
+Q_SIGNALS:
+    void isRecordingChanged(bool isRecording);
+
+private:
+    struct Private;
+    QScopedPointer<Private> d;
+};
+
+/**
+ * @brief Replays a trace recorded by RuntimeTraceRecorder
+ *
+ * Events are applied to the runtime controller of machine(), either at the pace they got
+ * recorded, scaled by speed(), or as fast as possible. The event loop keeps running while
+ * replaying in any case.
+ */
+class KDSME_CORE_EXPORT RuntimeTracePlayer : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(KDSME::StateMachine *machine READ machine WRITE setMachine NOTIFY machineChanged FINAL)
+    Q_PROPERTY(qreal speed READ speed WRITE setSpeed NOTIFY speedChanged FINAL)
+    Q_PROPERTY(bool isPlaying READ isPlaying NOTIFY isPlayingChanged FINAL)
+
+public:
+    explicit RuntimeTracePlayer(QObject *parent = nullptr);
+    ~RuntimeTracePlayer();
+
+    /// Machine the states and transitions of the trace are looked up in
+    StateMachine *machine() const;
+    void setMachine(StateMachine *machine);
+
+    /**
+     * Open the trace in @p fileName, the previous one gets closed
+     *
+     * @return False in case the file could not be opened or is not a trace, see errorString()
+     */
+    bool open(const QString &fileName);
+    void close();
+    bool isOpen() const;
+    QString errorString() const;
+
+    /**
+     * Factor the recorded pace is scaled by, 0 to replay as fast as possible
+     *
+     * @note Default is 1, i.e. real time
+     */
+    qreal speed() const;
+    void setSpeed(qreal speed);
+
+    bool isPlaying() const;
+    /// Number of events replayed so far
+    quint64 position() const;
+    /// Recording time of the last event replayed, in nanoseconds since the start of the recording
+    qint64 time() const;
+    bool atEnd() const;
+
+public Q_SLOTS:
+    void play();
+    void pause();
+    /// Pause, rewind to the start of the trace and clear the runtime controller
+    void stop();
+
+Q_SIGNALS:
+    void machineChanged(KDSME::StateMachine *machine);
+    void speedChanged(qreal speed);
+    void isPlayingChanged(bool isPlaying);
+    /// Emitted when the end of the trace got reached while playing
+    void finished();
+
+private:
+    struct Private;
+    QScopedPointer<Private> d;
+};
+
+}
+
+#endif // KDSME_MODEL_RUNTIMETRACE_H
@@ -58,6 +58,9 @@ struct State::Private
     ChildMode m_childMode;
     bool m_isComposite;
     bool m_isExpanded;
+    float m_activeness = 0;
+    /// Maintained by Transition::setTargetState()
+    QList<Transition *> m_incomingTransitions;
 };
 
 State::State(State *parent)
@@ -68,6 +71,9 @@ State::State(State *parent)
 
 State::~State()
 {
+    for (Transition *transition : std::as_const(d->m_incomingTransitions)) {
+        transition->clearTargetState();
+    }
 }
 
 Element::Type State::type() const
@@ -100,6 +106,21 @@ QList<Transition *> State::transitions() const
     return ObjectHelper::copy_if_type<Transition *>(children());
 }
 
+QList<Transition *> State::incomingTransitions() const
+{
+    return d->m_incomingTransitions;
+}
+
+void State::addIncomingTransition(Transition *transition)
+{
+    d->m_incomingTransitions.append(transition);
+}
+
+void State::removeIncomingTransition(Transition *transition)
+{
+    d->m_incomingTransitions.removeOne(transition);
+}
+
 void State::addTransition(Transition *transition)
 {
     transition->setParent(this);
@@ -192,6 +213,20 @@ void State::setExpanded(bool expanded)
     Q_EMIT expandedChanged(d->m_isExpanded);
 }
 
+float State::activeness() const
+{
+    return d->m_activeness;
+}
+
+void State::setActiveness(float activeness)
+{
+    if (qFuzzyCompare(d->m_activeness, activeness))
+        return;
+
+    d->m_activeness = activeness;
+    Q_EMIT activenessChanged(d->m_activeness);
+}
+
 StateMachine *State::machine() const
 {
     StateMachine *m = ElementUtil::findStateMachine(this);
@@ -33,6 +33,7 @@ class KDSME_CORE_EXPORT State : public Element
     Q_PROPERTY(ChildMode childMode READ childMode WRITE setChildMode NOTIFY childModeChanged FINAL)
     Q_PROPERTY(bool isComposite READ isComposite NOTIFY isCompositeChanged FINAL)
     Q_PROPERTY(bool expanded READ isExpanded WRITE setExpanded NOTIFY expandedChanged FINAL)
+    Q_PROPERTY(float activeness READ activeness NOTIFY activenessChanged FINAL)
 
 public:
     enum ChildMode
@@ -55,6 +56,10 @@ public:
     QList<State *> childStates() const;
 
     QList<Transition *> transitions() const;
+    /**
+     * @return The transitions targeting this state, in the order they got connected
+     */
+    QList<Transition *> incomingTransitions() const;
     void addTransition(Transition *transition);
     SignalTransition *addSignalTransition(State *target, const QString &silgnal = QString());
     TimeoutTransition *addTimeoutTransition(State *target, int timeout);
@@ -82,6 +87,16 @@ public:
     bool isExpanded() const;
     void setExpanded(bool expanded);
 
+    /**
+     * How recently this state was active, as tracked by a RuntimeController
+     *
+     * 1 in case the state is part of the active configuration, decreasing for configurations
+     * further back in the history, 0 in case it is not part of the history at all.
+     *
+     * @sa RuntimeController::activenessForState()
+     */
+    float activeness() const;
+
     Q_INVOKABLE KDSME::StateMachine *machine() const;
 
 protected:
@@ -93,8 +108,16 @@ Q_SIGNALS:
     void childModeChanged(KDSME::State::ChildMode childMode);
     void isCompositeChanged(bool isComposite);
     void expandedChanged(bool expanded);
+    void activenessChanged(float activeness);
 
 private:
+    friend class RuntimeController;
+    void setActiveness(float activeness);
+
+    friend class Transition;
+    void addIncomingTransition(Transition *transition);
+    void removeIncomingTransition(Transition *transition);
+
     struct Private;
     QScopedPointer<Private> d;
 };
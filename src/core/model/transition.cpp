@@ -45,6 +45,9 @@ Transition::Transition(State *sourceState)
 
 Transition::~Transition()
 {
+    if (d->m_targetState) {
+        d->m_targetState->removeIncomingTransition(this);
+    }
 }
 
 StateMachine *Transition::machine() const
@@ -79,10 +82,21 @@ void Transition::setTargetState(State *targetState)
     if (d->m_targetState == targetState)
         return;
 
+    if (d->m_targetState) {
+        d->m_targetState->removeIncomingTransition(this);
+    }
     d->m_targetState = targetState;
+    if (d->m_targetState) {
+        d->m_targetState->addIncomingTransition(this);
+    }
     Q_EMIT targetStateChanged(targetState);
 }
 
+void Transition::clearTargetState()
+{
+    d->m_targetState = nullptr;
+}
+
 Element::Type Transition::type() const
 {
     return TransitionType;
@@ -66,6 +66,10 @@ Q_SIGNALS:
     void labelBoundingRectChanged(const QRectF &rect);
 
 private:
+    friend class State;
+    /// Called by the target state when it gets deleted
+    void clearTargetState();
+
     struct Private;
     QScopedPointer<Private> d;
 };
@@ -0,0 +1,439 @@
+/*
+  This file is part of the KDAB State Machine Editor Library.
+
+  SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company <info@kdab.com>
+
+  SPDX-License-Identifier: LGPL-2.1-only OR LicenseRef-KDAB-KDStateMachineEditor
+
+  Licensees holding valid commercial KDAB State Machine Editor Library
+  licenses may use this file in accordance with the KDAB State Machine Editor
+  Library License Agreement provided with the Software.
+
+  Contact info@kdab.com if any conditions of this licensing are not clear to you.
+*/
+
+/*
+  Layout benchmarks on synthetic state machines
+
+  Not part of the test suite, run the executable by hand. Results are reported
+  through QTestLib, hence any of its output formats can be used to track them
+  over releases, e.g.:
+
+    bench_layouter -o results.csv,csv
+    bench_layouter -o results.xml,xml benchGraphvizLayout
+
+  benchGraphvizAttributes compares setting node attributes by name (converting
+  every name and value from QString) with setting them through cached symbols.
+  benchGraphvizBuildImported does the same for GraphvizLayouterBackend building
+  the graphs of the SCXML files shipped in data/scxml.
+
+  Environment variables:
+    KDSME_BENCH_SIZES       comma-separated list of machine sizes (default: 10,50,100)
+    KDSME_BENCH_ITERATIONS  number of runs averaged for the per-phase benchmarks (default: 5)
+*/
+
+#include <config-test.h>
+
+#include "util.h"
+
+#include "graphvizlayout/graphvizlayouter.h"
+#include "graphvizlayout/graphvizlayouterbackend_p.h"
+#include "layerwiselayouter.h"
+#include "layoutproperties.h"
+#include "state.h"
+#include "sugiyamalayouter.h"
+#include "transition.h"
+
+#include <QElapsedTimer>
+#include <QTest>
+
+#include <graphviz/cgraph.h>
+
+#include <memory>
+
+using namespace KDSME;
+
+namespace {
+
+enum Shape
+{
+    ChainShape, ///< (I) -> (S0) -> (S1) -> ... -> (Final)
+    WideShape, ///< one composite state with many children, all entered from its initial state
+    ParallelShape, ///< one parallel state with many regions, each holding a short chain
+    MeshShape ///< every state has transitions to its next few siblings, including back edges
+};
+
+enum Phase
+{
+    BuildPhase,
+    LayoutPhase,
+    ImportPhase
+};
+
+const qreal STATE_WIDTH = 128;
+const qreal STATE_HEIGHT = 48;
+const int MESH_DEGREE = 4;
+const int ATTRIBUTE_BENCHMARK_NODES = 10000;
+
+QList<int> benchmarkSizes()
+{
+    QList<int> sizes;
+    const auto values = qgetenv("KDSME_BENCH_SIZES").split(',');
+    for (const QByteArray &value : values) {
+        bool ok = false;
+        const int size = value.trimmed().toInt(&ok);
+        if (ok && size > 0) {
+            sizes << size;
+        }
+    }
+    if (sizes.isEmpty()) {
+        sizes = { 10, 50, 100 };
+    }
+    return sizes;
+}
+
+int benchmarkIterations()
+{
+    bool ok = false;
+    const int iterations = qEnvironmentVariableIntValue("KDSME_BENCH_ITERATIONS", &ok);
+    return ok && iterations > 0 ? iterations : 5;
+}
+
+State *addState(State *parent, const QString &label)
+{
+    auto *state = new State(parent);
+    state->setLabel(label);
+    state->setWidth(STATE_WIDTH);
+    state->setHeight(STATE_HEIGHT);
+    return state;
+}
+
+Transition *addTransition(State *source, State *target)
+{
+    auto *transition = new Transition(source);
+    transition->setTargetState(target);
+    return transition;
+}
+
+/// Adds a chain of @p length states to @p parent, entered from a new initial state
+void addChain(State *parent, int length, const QString &prefix)
+{
+    State *previous = new PseudoState(PseudoState::InitialState, parent);
+    for (int i = 0; i < length; ++i) {
+        State *state = addState(parent, prefix + QString::number(i));
+        addTransition(previous, state);
+        previous = state;
+    }
+}
+
+std::unique_ptr<StateMachine> createMachine(Shape shape, int size)
+{
+    std::unique_ptr<StateMachine> machine(new StateMachine);
+    machine->setLabel(QStringLiteral("Benchmark"));
+
+    switch (shape) {
+    case ChainShape: {
+        addChain(machine.get(), size, QStringLiteral("S"));
+        const auto states = machine->childStates();
+        addTransition(states.last(), new FinalState(machine.get()));
+        break;
+    }
+    case WideShape: {
+        State *wide = addState(machine.get(), QStringLiteral("Wide"));
+        auto *initial = new PseudoState(PseudoState::InitialState, wide);
+        for (int i = 0; i < size; ++i) {
+            addTransition(initial, addState(wide, u"S" + QString::number(i)));
+        }
+        break;
+    }
+    case ParallelShape: {
+        State *parallel = addState(machine.get(), QStringLiteral("Parallel"));
+        parallel->setChildMode(State::ParallelStates);
+        for (int i = 0; i < size; ++i) {
+            const QString label = u"R" + QString::number(i);
+            addChain(addState(parallel, label), 3, label + u"S");
+        }
+        break;
+    }
+    case MeshShape: {
+        QList<State *> states;
+        for (int i = 0; i < size; ++i) {
+            states << addState(machine.get(), u"S" + QString::number(i));
+        }
+        const int degree = qMin(MESH_DEGREE, size - 1);
+        for (int i = 0; i < size; ++i) {
+            for (int j = 1; j <= degree; ++j) {
+                addTransition(states.at(i), states.at((i + j) % size));
+            }
+        }
+        break;
+    }
+    }
+    return machine;
+}
+
+/// @return The time spent in @p phase, in nanoseconds per run
+qreal timeGraphvizPhase(Phase phase, StateMachine *machine, const LayoutProperties *properties)
+{
+    const int iterations = benchmarkIterations();
+    QElapsedTimer timer;
+    qint64 elapsed = 0;
+    for (int i = 0; i < iterations; ++i) {
+        GraphvizLayouterBackend backend;
+        backend.openLayout(machine, properties);
+
+        timer.start();
+        backend.buildState(machine);
+        backend.buildTransitions(machine);
+        if (phase == BuildPhase) {
+            elapsed += timer.nsecsElapsed();
+        }
+
+        timer.start();
+        backend.layout();
+        if (phase == LayoutPhase) {
+            elapsed += timer.nsecsElapsed();
+        }
+
+        timer.start();
+        backend.import();
+        if (phase == ImportPhase) {
+            elapsed += timer.nsecsElapsed();
+        }
+
+        backend.closeLayout();
+    }
+    return qreal(elapsed) / iterations;
+}
+
+/// @return The time spent building the graph of @p machine, in nanoseconds per run
+qreal timeGraphvizBuild(StateMachine *machine, const LayoutProperties *properties, GraphvizLayouterBackend::AttributeMode mode)
+{
+    const int iterations = benchmarkIterations();
+    QElapsedTimer timer;
+    qint64 elapsed = 0;
+    for (int i = 0; i < iterations; ++i) {
+        GraphvizLayouterBackend backend;
+        backend.setAttributeMode(mode);
+        backend.openLayout(machine, properties);
+
+        timer.start();
+        backend.buildState(machine);
+        backend.buildTransitions(machine);
+        elapsed += timer.nsecsElapsed();
+
+        backend.closeLayout();
+    }
+    return qreal(elapsed) / iterations;
+}
+
+}
+
+Q_DECLARE_METATYPE(Shape)
+Q_DECLARE_METATYPE(GraphvizLayouterBackend::AttributeMode)
+
+class LayouterBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void benchGraphvizAttributes_data();
+    void benchGraphvizAttributes();
+    void benchGraphvizBuildImported_data();
+    void benchGraphvizBuildImported();
+    void benchGraphvizBuild_data();
+    void benchGraphvizBuild();
+    void benchGraphvizLayout_data();
+    void benchGraphvizLayout();
+    void benchGraphvizImport_data();
+    void benchGraphvizImport();
+    void benchGraphvizLayouter_data();
+    void benchGraphvizLayouter();
+    void benchLayerwiseLayouter_data();
+    void benchLayerwiseLayouter();
+    void benchSugiyamaLayouter_data();
+    void benchSugiyamaLayouter();
+
+private:
+    static void populateMachines();
+    static void benchGraphvizPhase(Phase phase);
+
+    template<typename LayouterType>
+    static void benchLayouter();
+};
+
+void LayouterBenchmark::populateMachines()
+{
+    QTest::addColumn<Shape>("shape");
+    QTest::addColumn<int>("size");
+
+    const auto sizes = benchmarkSizes();
+    for (int size : sizes) {
+        QTest::addRow("chain/%d", size) << ChainShape << size;
+        QTest::addRow("wide/%d", size) << WideShape << size;
+        QTest::addRow("parallel/%d", size) << ParallelShape << size;
+        QTest::addRow("mesh/%d", size) << MeshShape << size;
+    }
+}
+
+void LayouterBenchmark::benchGraphvizPhase(Phase phase)
+{
+    QFETCH(Shape, shape);
+    QFETCH(int, size);
+
+    const auto machine = createMachine(shape, size);
+    const LayoutProperties properties;
+    QTest::setBenchmarkResult(timeGraphvizPhase(phase, machine.get(), &properties), QTest::WalltimeNanoseconds);
+}
+
+template<typename LayouterType>
+void LayouterBenchmark::benchLayouter()
+{
+    QFETCH(Shape, shape);
+    QFETCH(int, size);
+
+    const auto machine = createMachine(shape, size);
+    const LayoutProperties properties;
+    QBENCHMARK {
+        // fresh instance per run, so nothing gets reused from a previous layout
+        LayouterType layouter;
+        layouter.layout(machine.get(), &properties);
+    }
+}
+
+void LayouterBenchmark::benchGraphvizAttributes_data()
+{
+    QTest::addColumn<bool>("useSymbols");
+
+    // how GraphvizLayouterBackend used to set attributes, resp. how it does now
+    QTest::addRow("by name") << false;
+    QTest::addRow("by symbol") << true;
+}
+
+void LayouterBenchmark::benchGraphvizAttributes()
+{
+    QFETCH(bool, useSymbols);
+
+    Agraph_t *graph = agopen(const_cast<char *>("benchmark"), Agdirected, nullptr);
+    QList<Agnode_t *> nodes;
+    nodes.reserve(ATTRIBUTE_BENCHMARK_NODES);
+    for (int i = 0; i < ATTRIBUTE_BENCHMARK_NODES; ++i) {
+        nodes << agnode(graph, QByteArray::number(i).data(), 1);
+    }
+
+    const QString label = QStringLiteral("State");
+    const qreal width = STATE_WIDTH / 96.0;
+    QBENCHMARK {
+        if (useSymbols) {
+            Agsym_t *shapeSymbol = agattr(graph, AGNODE, const_cast<char *>("shape"), "");
+            Agsym_t *labelSymbol = agattr(graph, AGNODE, const_cast<char *>("label"), "");
+            Agsym_t *widthSymbol = agattr(graph, AGNODE, const_cast<char *>("width"), "");
+            for (Agnode_t *node : std::as_const(nodes)) {
+                agxset(node, shapeSymbol, "rectangle");
+                agxset(node, labelSymbol, label.toUtf8().constData());
+                agxset(node, widthSymbol, QByteArray::number(width).constData());
+            }
+        } else {
+            for (Agnode_t *node : std::as_const(nodes)) {
+                agsafeset(node, QStringLiteral("shape").toLocal8Bit().data(), QStringLiteral("rectangle").toLocal8Bit().data(), "");
+                agsafeset(node, QStringLiteral("label").toLocal8Bit().data(), label.toLocal8Bit().data(), "");
+                agsafeset(node, QStringLiteral("width").toLocal8Bit().data(), QString::number(width).toLocal8Bit().data(), "");
+            }
+        }
+    }
+
+    agclose(graph);
+}
+
+void LayouterBenchmark::benchGraphvizBuildImported_data()
+{
+    QTest::addColumn<QString>("fileName");
+    QTest::addColumn<GraphvizLayouterBackend::AttributeMode>("mode");
+
+    const QStringList fileNames = {
+        QStringLiteral("calculator.scxml"),
+        QStringLiteral("microwave.scxml"),
+        QStringLiteral("pinball.scxml"),
+        QStringLiteral("trafficreport.scxml"),
+    };
+    for (const QString &fileName : fileNames) {
+        const QString path = QStringLiteral(TEST_DATA_DIR "/scxml/") + fileName;
+        QTest::addRow("%s/by name", qPrintable(fileName)) << path << GraphvizLayouterBackend::NameAttributes;
+        QTest::addRow("%s/by symbol", qPrintable(fileName)) << path << GraphvizLayouterBackend::SymbolAttributes;
+    }
+}
+
+void LayouterBenchmark::benchGraphvizBuildImported()
+{
+    QFETCH(QString, fileName);
+    QFETCH(GraphvizLayouterBackend::AttributeMode, mode);
+
+    const std::unique_ptr<StateMachine> machine(TestUtil::importMachine(fileName));
+    QVERIFY(machine);
+    const LayoutProperties properties;
+    QTest::setBenchmarkResult(timeGraphvizBuild(machine.get(), &properties, mode), QTest::WalltimeNanoseconds);
+}
+
+void LayouterBenchmark::benchGraphvizBuild_data()
+{
+    populateMachines();
+}
+
+void LayouterBenchmark::benchGraphvizBuild()
+{
+    benchGraphvizPhase(BuildPhase);
+}
+
+void LayouterBenchmark::benchGraphvizLayout_data()
+{
+    populateMachines();
+}
+
+void LayouterBenchmark::benchGraphvizLayout()
+{
+    benchGraphvizPhase(LayoutPhase);
+}
+
+void LayouterBenchmark::benchGraphvizImport_data()
+{
+    populateMachines();
+}
+
+void LayouterBenchmark::benchGraphvizImport()
+{
+    benchGraphvizPhase(ImportPhase);
+}
+
+void LayouterBenchmark::benchGraphvizLayouter_data()
+{
+    populateMachines();
+}
+
+void LayouterBenchmark::benchGraphvizLayouter()
+{
+    benchLayouter<GraphvizLayouter>();
+}
+
+void LayouterBenchmark::benchLayerwiseLayouter_data()
+{
+    populateMachines();
+}
+
+void LayouterBenchmark::benchLayerwiseLayouter()
+{
+    benchLayouter<LayerwiseLayouter>();
+}
+
+void LayouterBenchmark::benchSugiyamaLayouter_data()
+{
+    populateMachines();
+}
+
+void LayouterBenchmark::benchSugiyamaLayouter()
+{
+    benchLayouter<SugiyamaLayouter>();
+}
+
+QTEST_MAIN(LayouterBenchmark)
+
+#include "bench_layouter.moc"
@@ -0,0 +1,131 @@
+/*
+  This file is part of the KDAB State Machine Editor Library.
+
+  SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company <info@kdab.com>
+
+  SPDX-License-Identifier: LGPL-2.1-only OR LicenseRef-KDAB-KDStateMachineEditor
+
+  Licensees holding valid commercial KDAB State Machine Editor Library
+  licenses may use this file in accordance with the KDAB State Machine Editor
+  Library License Agreement provided with the Software.
+
+  Contact info@kdab.com if any conditions of this licensing are not clear to you.
+*/
+
+/*
+  RingBuffer benchmarks
+
+  Not part of the test suite, run the executable by hand, see bench_layouter.cpp.
+
+  Each run feeds one second worth of events at 100k events/s into a buffer and, like
+  RuntimeController does for every update, looks up the relative position of an item.
+  QueueRingBuffer is the former QQueue-based implementation, kept for comparison.
+*/
+
+#include "ringbuffer.h"
+
+#include <QQueue>
+#include <QTest>
+
+using namespace KDSME;
+
+namespace {
+
+const int EVENTS_PER_RUN = 100000;
+
+template<class T>
+class QueueRingBuffer
+{
+public:
+    explicit QueueRingBuffer(int capacity)
+        : m_capacity(capacity)
+    {
+    }
+
+    void enqueue(T t)
+    {
+        m_entries.enqueue(t);
+        while (m_entries.size() > m_capacity) {
+            m_entries.dequeue();
+        }
+    }
+
+    QList<T> entries() const
+    {
+        return m_entries;
+    }
+
+private:
+    QQueue<T> m_entries;
+    int m_capacity;
+};
+
+}
+
+class RingBufferBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void benchQueueRingBuffer_data();
+    void benchQueueRingBuffer();
+    void benchRingBuffer_data();
+    void benchRingBuffer();
+
+private:
+    static void populateCapacities();
+};
+
+void RingBufferBenchmark::populateCapacities()
+{
+    QTest::addColumn<int>("capacity");
+
+    QTest::addRow("5") << 5;
+    QTest::addRow("100") << 100;
+    QTest::addRow("1000") << 1000;
+}
+
+void RingBufferBenchmark::benchQueueRingBuffer_data()
+{
+    populateCapacities();
+}
+
+void RingBufferBenchmark::benchQueueRingBuffer()
+{
+    QFETCH(int, capacity);
+
+    QueueRingBuffer<quintptr> buffer(capacity);
+    qreal position = 0;
+    QBENCHMARK {
+        for (int i = 0; i < EVENTS_PER_RUN; ++i) {
+            buffer.enqueue(quintptr(i));
+            const QList<quintptr> entries = buffer.entries();
+            position += (entries.indexOf(quintptr(i / 2)) + 1.0) / entries.size();
+        }
+    }
+    QVERIFY(position >= 0);
+}
+
+void RingBufferBenchmark::benchRingBuffer_data()
+{
+    populateCapacities();
+}
+
+void RingBufferBenchmark::benchRingBuffer()
+{
+    QFETCH(int, capacity);
+
+    RingBuffer<quintptr> buffer(capacity);
+    qreal position = 0;
+    QBENCHMARK {
+        for (int i = 0; i < EVENTS_PER_RUN; ++i) {
+            buffer.enqueue(quintptr(i));
+            position += (buffer.indexOf(quintptr(i / 2)) + 1.0) / buffer.size();
+        }
+    }
+    QVERIFY(position >= 0);
+}
+
+QTEST_MAIN(RingBufferBenchmark)
+
+#include "bench_ringbuffer.moc"
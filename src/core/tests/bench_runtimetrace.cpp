@@ -0,0 +1,124 @@
+/*
+  This file is part of the KDAB State Machine Editor Library.
+
+  SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company <info@kdab.com>
+
+  SPDX-License-Identifier: LGPL-2.1-only OR LicenseRef-KDAB-KDStateMachineEditor
+
+  Licensees holding valid commercial KDAB State Machine Editor Library
+  licenses may use this file in accordance with the KDAB State Machine Editor
+  Library License Agreement provided with the Software.
+
+  Contact info@kdab.com if any conditions of this licensing are not clear to you.
+*/
+
+/*
+  RuntimeTraceRecorder benchmarks
+
+  Not part of the test suite, run the executable by hand, see bench_layouter.cpp.
+
+  Each run feeds one second worth of runtime events at 100k events/s into the runtime
+  controller of an imported machine, alternating triggered transitions and configurations,
+  and processes the pending events of the thread every millisecond as a GUI would. The
+  reported result is the time the thread spent per event, waiting for the next one left out.
+*/
+
+#include <config-test.h>
+
+#include "runtimecontroller.h"
+#include "runtimetrace.h"
+#include "state.h"
+#include "transition.h"
+#include "util.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+#include <QTest>
+
+using namespace KDSME;
+
+namespace {
+
+const int EVENTS_PER_SECOND = 100000;
+const int EVENTS_PER_RUN = EVENTS_PER_SECOND;
+/// Events between two calls to QCoreApplication::processEvents(), i.e. one millisecond
+const int EVENTS_PER_EVENT_LOOP_ITERATION = EVENTS_PER_SECOND / 1000;
+
+}
+
+class RuntimeTraceBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void benchRecording_data();
+    void benchRecording();
+};
+
+void RuntimeTraceBenchmark::benchRecording_data()
+{
+    QTest::addColumn<bool>("record");
+
+    QTest::addRow("without recorder") << false;
+    QTest::addRow("with recorder") << true;
+}
+
+void RuntimeTraceBenchmark::benchRecording()
+{
+    QFETCH(bool, record);
+
+    const QTemporaryDir dir;
+    const QScopedPointer<StateMachine> machine(TestUtil::importMachine(QStringLiteral(TEST_DATA_DIR "/scxml/microwave.scxml")));
+    QVERIFY(machine);
+    const auto states = machine->findChildren<State *>();
+    const auto transitions = machine->findChildren<Transition *>();
+    QVERIFY(!states.isEmpty());
+    QVERIFY(!transitions.isEmpty());
+
+    RuntimeController *controller = machine->runtimeController();
+    // as done by DebugInterfaceClient, remote machines send way more updates than get rendered
+    controller->setCoalesceUpdates(true);
+    RuntimeTraceRecorder recorder(controller);
+    if (record) {
+        QVERIFY(recorder.start(dir.filePath(QStringLiteral("trace.kdsmetrace"))));
+    }
+
+    QElapsedTimer clock;
+    QElapsedTimer timer;
+    qint64 busy = 0;
+    clock.start();
+    for (int i = 0; i < EVENTS_PER_RUN; ++i) {
+        const qint64 deadline = qint64(i) * 1000000000 / EVENTS_PER_SECOND;
+        while (clock.nsecsElapsed() < deadline) {
+            // wait for the next event to come in
+        }
+
+        timer.start();
+        if (i % 2) {
+            controller->setActiveConfiguration({ machine.data(), states.at(i % states.size()) });
+        } else {
+            controller->setLastTransition(transitions.at(i % transitions.size()));
+        }
+        if (i % EVENTS_PER_EVENT_LOOP_ITERATION == 0) {
+            QCoreApplication::processEvents();
+        }
+        busy += timer.nsecsElapsed();
+    }
+    const qint64 elapsed = clock.nsecsElapsed();
+
+    if (record) {
+        recorder.stop();
+        QVERIFY(recorder.errorString().isEmpty());
+        QVERIFY(recorder.eventCount() > 0);
+    }
+    if (elapsed > 1100000000) {
+        qWarning() << "Could not keep up with" << EVENTS_PER_SECOND << "events/s, the run took" << elapsed / 1000000 << "ms";
+    }
+    QTest::setBenchmarkResult(qreal(busy) / EVENTS_PER_RUN, QTest::WalltimeNanoseconds);
+}
+
+QTEST_MAIN(RuntimeTraceBenchmark)
+
+#include "bench_runtimetrace.moc"
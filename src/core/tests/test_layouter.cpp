@@ -17,9 +17,13 @@
 
 #include "util.h"
 
+#include "elementutil.h"
+#include "graphvizlayout/graphvizlayouter.h"
 #include "layouter.h"
 #include "layerwiselayouter.h"
+#include "layoutcache.h"
 #include "layoutproperties.h"
+#include "layoutsnapshot.h"
 #include "objecthelper.h"
 #include "parsehelper.h"
 #include "scxmlimporter.h"
@@ -27,8 +31,19 @@
 #include "transition.h"
 
 #include <QTest>
+#include <QDateTime>
 #include <QFile>
+#include <QDir>
 #include <QFileInfo>
+#include <QTemporaryDir>
+#include <QScopeGuard>
+#include <QThread>
+
+#include <atomic>
+#include <clocale>
+#include <cstdio>
+#include <memory>
+#include <vector>
 
 #define QVERIFY_RETURN(statement, retval)                                     \
     do {                                                                      \
@@ -47,6 +62,16 @@ protected Q_SLOTS:
     void testBasicState();
     void testParallelState();
 
+private Q_SLOTS:
+    void testIncrementalLayout();
+    void testIncrementalGraphvizLayout();
+    void testParallelLayout();
+    void testConcurrentLayout();
+    void testLayouterClone();
+    void testLayoutSnapshot();
+    void testIncrementalLayoutSnapshot();
+    void testLayoutCache();
+
 private:
     static void assertStatesHorizontallyAligned(const QList<State *> &states, qreal epsilonY = 1.0)
     {
@@ -123,6 +148,308 @@ void LayouterTest::testParallelState()
     assertRegionContainsStates(machine.data(), pureStateItems);
 }
 
+void LayouterTest::testIncrementalLayout()
+{
+    /*
+        State chart:
+            P1:
+                S1: (I) -> (S11) -> (S1Final)
+                S2: (I) -> (S21) -> (S2Final)
+    */
+    ScxmlImporter importer(ParseHelper::readFile(QStringLiteral(TEST_DATA_DIR "/scxml/parallelstate.scxml")));
+    const QScopedPointer<StateMachine> machine(importer.import());
+    QVERIFY(machine);
+
+    const LayoutProperties properties;
+    LayerwiseLayouter layouter;
+    layouter.setIncremental(true);
+    layouter.layout(machine.data(), &properties);
+
+    State *s11 = ElementUtil::findState(machine.data(), QStringLiteral("S11"));
+    State *s21 = ElementUtil::findState(machine.data(), QStringLiteral("S21"));
+    QVERIFY(s11);
+    QVERIFY(s21);
+
+    // tamper with both regions, only the region of S11 gets invalidated
+    const QPointF s11Pos = s11->pos();
+    const QPointF s21Pos = s21->pos();
+    s11->setPos(s11Pos + QPointF(1000, 1000));
+    s21->setPos(s21Pos + QPointF(1000, 1000));
+    s11->setLabel(QStringLiteral("S11 renamed"));
+
+    layouter.layout(machine.data(), &properties);
+    QVERIFY(s11->pos() != s11Pos + QPointF(1000, 1000)); // re-laid out
+    QCOMPARE(s21->pos(), s21Pos + QPointF(1000, 1000)); // reused
+
+    // everything is laid out again after a full invalidation
+    layouter.invalidateAll();
+    layouter.layout(machine.data(), &properties);
+    QVERIFY(s21->pos() != s21Pos + QPointF(1000, 1000));
+}
+
+void LayouterTest::testIncrementalGraphvizLayout()
+{
+    ScxmlImporter importer(ParseHelper::readFile(QStringLiteral(TEST_DATA_DIR "/scxml/parallelstate.scxml")));
+    const QScopedPointer<StateMachine> machine(importer.import());
+    QVERIFY(machine);
+
+    const LayoutProperties properties;
+    GraphvizLayouter layouter;
+    layouter.setIncremental(true);
+    layouter.layout(machine.data(), &properties);
+
+    State *s11 = ElementUtil::findState(machine.data(), QStringLiteral("S11"));
+    State *s21 = ElementUtil::findState(machine.data(), QStringLiteral("S21"));
+    QVERIFY(s11);
+    QVERIFY(s21);
+
+    // the region of S21 is laid out as one node, keeping the layout of its contents
+    const QPointF s21Pos = s21->pos();
+    s21->setPos(s21Pos + QPointF(1000, 1000));
+    s11->setLabel(QStringLiteral("S11 renamed"));
+
+    layouter.layout(machine.data(), &properties);
+    QCOMPARE(s21->pos(), s21Pos + QPointF(1000, 1000));
+
+    layouter.invalidateAll();
+    layouter.layout(machine.data(), &properties);
+    QCOMPARE(s21->pos(), s21Pos);
+}
+
+void LayouterTest::testParallelLayout()
+{
+    const QString fileName = QStringLiteral(TEST_DATA_DIR "/scxml/parallelstate.scxml");
+
+    LayerwiseLayouter sequentialLayouter;
+    const QList<QRectF> sequentialGeometry = TestUtil::layoutGeometry(fileName, &sequentialLayouter);
+    QVERIFY(!sequentialGeometry.isEmpty());
+    LayerwiseLayouter parallelLayouter;
+    parallelLayouter.setParallel(true);
+
+    // both layouters need to come up with the very same geometry
+    QCOMPARE(TestUtil::layoutGeometry(fileName, &parallelLayouter), sequentialGeometry);
+}
+
+void LayouterTest::testConcurrentLayout()
+{
+    const QStringList fileNames = {
+        QStringLiteral(TEST_DATA_DIR "/scxml/calculator.scxml"),
+        QStringLiteral(TEST_DATA_DIR "/scxml/microwave.scxml"),
+        QStringLiteral(TEST_DATA_DIR "/scxml/parallelstate.scxml"),
+        QStringLiteral(TEST_DATA_DIR "/scxml/trafficreport.scxml"),
+    };
+    const int runsPerFile = 4;
+
+    QList<QList<QRectF>> serialGeometry;
+    for (const QString &fileName : fileNames) {
+        GraphvizLayouter layouter;
+        serialGeometry << TestUtil::layoutGeometry(fileName, &layouter);
+        QVERIFY(!serialGeometry.last().isEmpty());
+    }
+
+    // a process-wide locale with a decimal comma, Graphviz needs the "C" locale in the layout threads
+    const QByteArray oldLocale = setlocale(LC_NUMERIC, nullptr);
+    const char *commaLocales[] = { "de_DE.UTF-8", "de_DE.utf8", "de_DE", "fr_FR.UTF-8", "fr_FR.utf8", "fr_FR" };
+    bool hasCommaLocale = false;
+    for (const char *locale : commaLocales) {
+        if (setlocale(LC_NUMERIC, locale)) {
+            hasCommaLocale = true;
+            break;
+        }
+    }
+    const auto restoreLocale = qScopeGuard([&oldLocale]() { setlocale(LC_NUMERIC, oldLocale.constData()); });
+    if (!hasCommaLocale) {
+        QSKIP("No locale with a decimal comma available");
+    }
+
+    // another thread formats numbers with the process-wide locale meanwhile, which must not change
+    std::atomic<bool> layouting(true);
+    int leakedFormats = 0;
+    int formats = 0;
+    const std::unique_ptr<QThread> observer(QThread::create([&]() {
+        char buffer[16];
+        while (layouting) {
+            std::snprintf(buffer, sizeof(buffer), "%.1f", 1.5);
+            if (qstrcmp(buffer, "1,5") != 0) {
+                ++leakedFormats;
+            }
+            ++formats;
+        }
+    }));
+    observer->start();
+
+    // run all layouts at once, each with its own backend
+    QVector<QList<QRectF>> concurrentGeometry(fileNames.size() * runsPerFile);
+    std::vector<std::unique_ptr<QThread>> threads;
+    for (int i = 0; i < concurrentGeometry.size(); ++i) {
+        QList<QRectF> *geometry = &concurrentGeometry[i];
+        const QString fileName = fileNames.at(i % fileNames.size());
+        threads.emplace_back(QThread::create([geometry, fileName]() {
+            GraphvizLayouter layouter;
+            *geometry = TestUtil::layoutGeometry(fileName, &layouter);
+        }));
+        threads.back()->start();
+    }
+    for (const auto &thread : threads) {
+        QVERIFY(thread->wait());
+    }
+    layouting = false;
+    QVERIFY(observer->wait());
+
+    // the layout threads switched their own locale only
+    QVERIFY(formats > 0);
+    QCOMPARE(leakedFormats, 0);
+
+    for (int i = 0; i < concurrentGeometry.size(); ++i) {
+        QCOMPARE(concurrentGeometry.at(i), serialGeometry.at(i % fileNames.size()));
+    }
+}
+
+void LayouterTest::testLayouterClone()
+{
+    const QTemporaryDir cacheDir;
+    QVERIFY(cacheDir.isValid());
+    LayoutCache cache(cacheDir.path());
+
+    LayerwiseLayouter layouter;
+    layouter.setParallel(true);
+    layouter.setIncremental(true);
+    layouter.setCache(&cache);
+
+    const QScopedPointer<Layouter> clone(layouter.clone());
+    auto *layerwiseClone = qobject_cast<LayerwiseLayouter *>(clone.data());
+    QVERIFY(layerwiseClone);
+    QVERIFY(layerwiseClone->isParallel());
+    QVERIFY(layerwiseClone->isIncremental());
+    QCOMPARE(layerwiseClone->cache(), &cache);
+}
+
+void LayouterTest::testLayoutSnapshot()
+{
+    const QString fileName = QStringLiteral(TEST_DATA_DIR "/scxml/microwave.scxml");
+    GraphvizLayouter syncLayouter;
+    const QList<QRectF> syncGeometry = TestUtil::layoutGeometry(fileName, &syncLayouter);
+    QVERIFY(!syncGeometry.isEmpty());
+
+    const QScopedPointer<StateMachine> machine(TestUtil::importMachine(fileName));
+    QVERIFY(machine);
+    const QList<QRectF> oldGeometry = TestUtil::stateGeometry(machine.data());
+
+    const LayoutProperties properties;
+    GraphvizLayouter layouter;
+    LayoutSnapshot snapshot(machine.data(), &properties, &layouter);
+    QVERIFY(snapshot.isValid());
+
+    // the copies get laid out in another thread, just like StateMachineScene::layoutAsync() does
+    bool laidOut = false;
+    const std::unique_ptr<QThread> thread(QThread::create([&snapshot, &laidOut]() { laidOut = snapshot.layout(); }));
+    thread->start();
+    QVERIFY(thread->wait());
+    QVERIFY(laidOut);
+    QCOMPARE(TestUtil::stateGeometry(machine.data()), oldGeometry); // originals stay untouched until applied
+
+    snapshot.apply();
+    QCOMPARE(TestUtil::stateGeometry(machine.data()), syncGeometry);
+
+    LayoutSnapshot cancelledSnapshot(machine.data(), &properties, &layouter);
+    cancelledSnapshot.cancel();
+    QVERIFY(!cancelledSnapshot.layout());
+}
+
+void LayouterTest::testIncrementalLayoutSnapshot()
+{
+    const QScopedPointer<StateMachine> machine(TestUtil::importMachine(QStringLiteral(TEST_DATA_DIR "/scxml/parallelstate.scxml")));
+    QVERIFY(machine);
+
+    const LayoutProperties properties;
+    GraphvizLayouter layouter;
+    layouter.setIncremental(true);
+    layouter.layout(machine.data(), &properties);
+
+    State *s11 = ElementUtil::findState(machine.data(), QStringLiteral("S11"));
+    State *s21 = ElementUtil::findState(machine.data(), QStringLiteral("S21"));
+    QVERIFY(s11);
+    QVERIFY(s21);
+
+    // the copy of the layouter knows only the region of S11 changed
+    const QPointF s21Pos = s21->pos();
+    s21->setPos(s21Pos + QPointF(1000, 1000));
+    s11->setLabel(QStringLiteral("S11 renamed"));
+
+    LayoutSnapshot snapshot(machine.data(), &properties, &layouter);
+    QVERIFY(snapshot.layout());
+    snapshot.apply();
+    QCOMPARE(s21->pos(), s21Pos + QPointF(1000, 1000));
+
+    // changes made while the snapshot was laid out stay pending
+    LayoutSnapshot pendingSnapshot(machine.data(), &properties, &layouter);
+    s11->setLabel(QStringLiteral("S11 renamed again"));
+    QVERIFY(pendingSnapshot.layout());
+    pendingSnapshot.apply();
+    const QPointF s11Pos = s11->pos();
+    s11->setPos(s11Pos + QPointF(1000, 1000));
+    layouter.layout(machine.data(), &properties);
+    QVERIFY(s11->pos() != s11Pos + QPointF(1000, 1000));
+}
+
+void LayouterTest::testLayoutCache()
+{
+    const QTemporaryDir cacheDir;
+    QVERIFY(cacheDir.isValid());
+    LayoutCache cache(cacheDir.path());
+
+    const QString fileName = QStringLiteral(TEST_DATA_DIR "/scxml/microwave.scxml");
+    const LayoutProperties properties;
+
+    const QScopedPointer<StateMachine> firstMachine(TestUtil::importMachine(fileName));
+    QVERIFY(firstMachine);
+    const QScopedPointer<StateMachine> secondMachine(TestUtil::importMachine(fileName));
+    QVERIFY(secondMachine);
+
+    QVERIFY(!cache.restore(secondMachine.data(), &properties, "test"));
+    QCOMPARE(LayoutCache::key(firstMachine.data(), &properties, "test"), LayoutCache::key(secondMachine.data(), &properties, "test"));
+
+    GraphvizLayouter layouter;
+    layouter.setCache(&cache);
+    const QRectF boundingRect = layouter.layout(firstMachine.data(), &properties);
+
+    // the identical machine gets restored without being laid out, although
+    // laying out the first one changed the sizes the key is computed from
+    QRectF restoredBoundingRect;
+    QVERIFY(cache.restore(secondMachine.data(), &properties, GraphvizLayouter::staticMetaObject.className(), &restoredBoundingRect));
+    QCOMPARE(restoredBoundingRect, boundingRect);
+    QCOMPARE(TestUtil::stateGeometry(secondMachine.data()), TestUtil::stateGeometry(firstMachine.data()));
+
+    // structural changes and other layout properties miss the cache
+    LayoutProperties otherProperties;
+    otherProperties.setShowTransitionLabels(false);
+    QVERIFY(LayoutCache::key(secondMachine.data(), &properties, "test") != LayoutCache::key(secondMachine.data(), &otherProperties, "test"));
+    const QByteArray key = LayoutCache::key(secondMachine.data(), &properties, "test");
+    const auto secondStates = copy_if_type<State *>(secondMachine->findChildren<Element *>());
+    secondStates.last()->setLabel(QStringLiteral("renamed"));
+    QVERIFY(LayoutCache::key(secondMachine.data(), &properties, "test") != key);
+
+    cache.clear();
+    QVERIFY(QDir(cacheDir.path()).entryList(QDir::Files).isEmpty());
+    QCOMPARE(cache.size(), qint64(0));
+
+    // the least recently used entries get evicted beyond the maximum size
+    const QDateTime past = QDateTime::currentDateTimeUtc().addSecs(-60);
+    for (int i = 0; i < 3; ++i) {
+        const QByteArray entryKey = QByteArray::number(i);
+        cache.store(secondMachine.data(), entryKey, boundingRect);
+        QFile entry(QDir(cacheDir.path()).filePath(QString::fromLatin1(entryKey) + u".json"));
+        QVERIFY(entry.open(QIODevice::ReadWrite));
+        QVERIFY(entry.setFileTime(past.addSecs(i), QFileDevice::FileModificationTime));
+    }
+    const qint64 entrySize = cache.size() / 3;
+    QVERIFY(entrySize > 0);
+    QVERIFY(cache.restore(secondMachine.data(), QByteArray("0")));
+    cache.setMaximumSize(2 * entrySize);
+    QCOMPARE(QDir(cacheDir.path()).entryList(QDir::Files, QDir::Name), QStringList({ QStringLiteral("0.json"), QStringLiteral("2.json") }));
+    QCOMPARE(cache.size(), 2 * entrySize);
+}
+
 QTEST_MAIN(LayouterTest)
 
 #include "test_layouter.moc"
@@ -13,7 +13,11 @@
   Contact info@kdab.com if any conditions of this licensing are not clear to you.
 */
 
+#include "elementmodel.h"
 #include "objecttreemodel.h"
+#include "runtimecontroller.h"
+#include "state.h"
+#include "transition.h"
 
 #include <QDebug>
 #include <QSignalSpy>
@@ -58,6 +62,7 @@ private Q_SLOTS:
     void testObjectTreeModel_ResetOperation_SingleObject();
     void testObjectTreeModel_ReparentOperation_SingleObject();
     void testObjectTreeModel_ReparentOperation_SingleObject_Invalid();
+    void testStateModel_StatisticsRoles();
 };
 
 void ModelsTest::testObjectTreeModel()
@@ -261,6 +266,42 @@ void ModelsTest::testObjectTreeModel_ReparentOperation_SingleObject_Invalid()
     }
 }
 
+void ModelsTest::testStateModel_StatisticsRoles() // NOLINT(readability-function-cognitive-complexity)
+{
+    StateMachine machine;
+    auto *s1 = new State(&machine);
+    auto *s2 = new State(&machine);
+    auto *t1 = new Transition(s1);
+    t1->setTargetState(s2);
+
+    StateModel model;
+    model.setState(&machine);
+    const QModelIndex s1Index = model.indexForObject(s1);
+    const QModelIndex t1Index = model.indexForObject(t1);
+    QVERIFY(s1Index.isValid());
+    QVERIFY(t1Index.isValid());
+    QCOMPARE(s1Index.data(StateModel::VisitCountRole).value<quint64>(), quint64(0));
+    QVERIFY(!t1Index.data(StateModel::VisitCountRole).isValid());
+
+    // clang-format off
+    QSignalSpy spy(&model, SIGNAL(dataChanged(QModelIndex,QModelIndex,QList<int>))); // clazy:exclude=old-style-connect
+    // clang-format on
+    RuntimeController *controller = machine.runtimeController();
+    controller->setActiveConfiguration({ s1 });
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.at(0).at(0).value<QModelIndex>(), s1Index);
+    QCOMPARE(s1Index.data(StateModel::VisitCountRole).value<quint64>(), quint64(1));
+    QCOMPARE(s1Index.data(StateModel::LastEnteredRole).value<qint64>(), controller->statisticsForState(s1).lastEntered);
+
+    controller->setLastTransition(t1);
+    controller->setActiveConfiguration({ s2 });
+    QCOMPARE(t1Index.data(StateModel::FireCountRole).value<quint64>(), quint64(1));
+    QVERIFY(!s1Index.data(StateModel::FireCountRole).isValid());
+    QCOMPARE(spy.count(), 4); // t1, then s1 and s2
+
+    QVERIFY(model.roleNames().contains(StateModel::DwellTimeRole));
+}
+
 QTEST_MAIN(ModelsTest)
 
 #include "test_models.moc"
@@ -35,6 +35,8 @@
 #include <QString>
 #include <QTimer>
 
+#include <algorithm>
+
 #define QVERIFY_RETURN(statement, retval)                                     \
     do {                                                                      \
         if (!QTest::qVerify((statement), #statement, "", __FILE__, __LINE__)) \
@@ -43,6 +45,8 @@
 
 using namespace KDSME;
 
+Q_DECLARE_METATYPE(KDSME::QsmDebugInterfaceSource::OverflowPolicy)
+
 struct QsmAdapter : public DebugInterfaceClient
 {
     QRemoteObjectRegistryHost registryNode;
@@ -73,6 +77,31 @@ private Q_SLOTS:
     void testEmptyInput();
     void testSimpleQSM();
     void testRunningQSM();
+    void testGraphSnapshot();
+    void testConfigurationUpdates();
+    void testEventQueueOverflow_data();
+    void testEventQueueOverflow();
+    void testMacrostep();
+    void testStepBoundaries();
+    void testStatesAddedLater();
+    void testLabelTable();
+    void testRecentEvents();
+
+private:
+    /// @return The configuration updates of the event batches in @p spy
+    static QList<DebugInterface::ConfigurationUpdate> configurationUpdates(const QSignalSpy &spy)
+    {
+        QList<DebugInterface::ConfigurationUpdate> updates;
+        for (const auto &arguments : spy) {
+            const auto batch = arguments.at(0).value<DebugInterface::EventBatch>();
+            for (const auto &event : batch.events) {
+                if (event.type == DebugInterface::Event::ConfigurationEvent) {
+                    updates << event.configuration;
+                }
+            }
+        }
+        return updates;
+    }
 };
 
 void QsmIntegrationTest::testEmptyInput()
@@ -137,7 +166,7 @@ void QsmIntegrationTest::testRunningQSM()
     const auto runtime = machine->runtimeController();
 
     QCOMPARE(runtime->isRunning(), true);
-    QCOMPARE(runtime->activeConfiguration().size(), 1);
+    QTRY_COMPARE(runtime->activeConfiguration().size(), 1);
     QCOMPARE(runtime->activeConfiguration().values()[0]->label(), QStringLiteral("initial"));
     QCOMPARE(runtime->lastTransitions().size(), 0);
 
@@ -145,9 +174,474 @@ void QsmIntegrationTest::testRunningQSM()
     QVERIFY(TestUtil::waitForSignal(runtime, SIGNAL(isRunningChanged(bool))));
 
     QCOMPARE(runtime->isRunning(), false);
+    // runtime events are sent in batches, after the status
+    QTRY_COMPARE(runtime->lastTransitions().size(), 1);
+    QTRY_COMPARE(runtime->activeConfiguration().values()[0]->label(), QStringLiteral("final"));
+    QCOMPARE(runtime->activeConfiguration().size(), 1);
+}
+
+void QsmIntegrationTest::testGraphSnapshot() // NOLINT(readability-function-cognitive-complexity)
+{
+    QStateMachine qsm;
+    qsm.setObjectName(QStringLiteral("myStateMachine"));
+    QState qsmParent(&qsm);
+    qsmParent.setObjectName(QStringLiteral("parent"));
+    qsm.setInitialState(&qsmParent);
+    QState qsmChild1(&qsmParent);
+    qsmChild1.setObjectName(QStringLiteral("child"));
+    QState qsmChild2(&qsmParent);
+    qsmChild2.setObjectName(QStringLiteral("child")); // labels are shared in the string table
+    qsmParent.setInitialState(&qsmChild1);
+    QFinalState qsmFinal(&qsm);
+    qsmFinal.setObjectName(QStringLiteral("final"));
+    auto transition1 = qsmChild1.addTransition(&qsmChild2);
+    transition1->setObjectName(QStringLiteral("next"));
+    auto transition2 = qsmParent.addTransition(&qsmFinal);
+    transition2->setObjectName(QStringLiteral("done"));
+
+    QsmAdapter adapter;
+    QSignalSpy spy(&adapter, &QsmAdapter::repopulateView);
+    QVERIFY(spy.wait(1000));
+
+    const QSignalSpy snapshotSpy(adapter.debugInterface(), &DebugInterfaceReplica::graphSnapshot);
+    const QSignalSpy stateAddedSpy(adapter.debugInterface(), &DebugInterfaceReplica::stateAdded);
+    adapter.interface.setQStateMachine(&qsm);
+    QVERIFY(spy.wait(1000));
+    QCOMPARE(snapshotSpy.count(), 1);
+    QCOMPARE(stateAddedSpy.count(), 0);
+
+    const auto snapshot = snapshotSpy.at(0).at(0).value<DebugInterface::GraphSnapshot>();
+    QVERIFY(snapshot.isValid());
+    QCOMPARE(snapshot.stateIds.size(), 5);
+    QCOMPARE(snapshot.transitionIds.size(), 2);
+    QCOMPARE(snapshot.strings.count(QStringLiteral("child")), 1);
+    QCOMPARE(snapshot.stateParents.at(0), quint64(0)); // the machine comes first
+
+    const StateMachine *machine = adapter.machine();
+    QVERIFY(machine);
+    QCOMPARE(machine->label(), QStringLiteral("myStateMachine"));
+    const auto states = machine->findChildren<State *>();
+    const auto children = std::count_if(states.cbegin(), states.cend(), [](State *state) {
+        return state->label() == QLatin1String("child") && state->parentState()->label() == QLatin1String("parent");
+    });
+    QCOMPARE(children, 2);
+
+    QStringList transitionLabels;
+    for (Transition *transition : machine->findChildren<Transition *>()) {
+        transitionLabels << transition->label();
+    }
+    QVERIFY(transitionLabels.contains(QStringLiteral("next")));
+    QVERIFY(transitionLabels.contains(QStringLiteral("done")));
+}
+
+void QsmIntegrationTest::testConfigurationUpdates() // NOLINT(readability-function-cognitive-complexity)
+{
+    QStateMachine qsm;
+    QState qsmFirst(&qsm);
+    qsmFirst.setObjectName(QStringLiteral("first"));
+    qsm.setInitialState(&qsmFirst);
+    QState qsmSecond(&qsm);
+    qsmSecond.setObjectName(QStringLiteral("second"));
+    QFinalState qsmFinal(&qsm);
+    qsmFinal.setObjectName(QStringLiteral("final"));
+
+    QTimer timer;
+    timer.setInterval(10);
+    timer.setSingleShot(true);
+    qsmFirst.addTransition(&timer, SIGNAL(timeout()), &qsmSecond);
+    qsmSecond.addTransition(&timer, SIGNAL(timeout()), &qsmFinal);
+
+    qsm.start();
+    QTRY_VERIFY(qsm.configuration().contains(&qsmFirst));
+
+    QsmAdapter adapter;
+    QSignalSpy spy(&adapter, &QsmAdapter::repopulateView);
+    QVERIFY(spy.wait(1000));
+    const QSignalSpy batchSpy(adapter.debugInterface(), &DebugInterfaceReplica::eventBatch);
+    adapter.interface.setQStateMachine(&qsm);
+    QVERIFY(spy.wait(1000));
+
+    // the current configuration is sent as keyframe after repopulating
+    QTRY_VERIFY(!configurationUpdates(batchSpy).isEmpty());
+    const auto keyframe = configurationUpdates(batchSpy).last();
+    QVERIFY(keyframe.keyframe);
+    QCOMPARE(keyframe.entered.size(), 1);
+    QVERIFY(keyframe.exited.isEmpty());
+
+    const auto runtime = adapter.machine()->runtimeController();
+    QTRY_COMPARE(runtime->activeConfiguration().size(), 1);
+    QCOMPARE(runtime->activeConfiguration().values().at(0)->label(), QStringLiteral("first"));
+
+    // further changes only carry the difference
+    const auto count = configurationUpdates(batchSpy).count();
+    timer.start();
+    QTRY_VERIFY(qsm.configuration().contains(&qsmSecond));
+    QTRY_VERIFY(configurationUpdates(batchSpy).count() > count);
+    const auto updates = configurationUpdates(batchSpy);
+    for (auto i = count; i < updates.count(); ++i) {
+        const auto &delta = updates.at(i);
+        QVERIFY(!delta.keyframe);
+        QCOMPARE(delta.sequence, keyframe.sequence + (i - count) + 1);
+        QVERIFY(!delta.entered.isEmpty() || !delta.exited.isEmpty());
+    }
+    QTRY_COMPARE(runtime->activeConfiguration().values().at(0)->label(), QStringLiteral("second"));
+
+    timer.start();
+    QVERIFY(TestUtil::waitForSignal(runtime, SIGNAL(isRunningChanged(bool))));
+    QTRY_COMPARE(runtime->activeConfiguration().values().at(0)->label(), QStringLiteral("final"));
     QCOMPARE(runtime->activeConfiguration().size(), 1);
-    QCOMPARE(runtime->activeConfiguration().values()[0]->label(), QStringLiteral("final"));
-    QCOMPARE(runtime->lastTransitions().size(), 1);
+}
+
+void QsmIntegrationTest::testEventQueueOverflow_data()
+{
+    QTest::addColumn<QsmDebugInterfaceSource::OverflowPolicy>("policy");
+
+    QTest::newRow("DropOldest") << QsmDebugInterfaceSource::DropOldest;
+    QTest::newRow("Aggregate") << QsmDebugInterfaceSource::Aggregate;
+}
+
+void QsmIntegrationTest::testEventQueueOverflow()
+{
+    QFETCH(QsmDebugInterfaceSource::OverflowPolicy, policy);
+
+    QStateMachine qsm;
+    QState qsmFirst(&qsm);
+    qsmFirst.setObjectName(QStringLiteral("first"));
+    qsm.setInitialState(&qsmFirst);
+    QState qsmSecond(&qsm);
+    qsmSecond.setObjectName(QStringLiteral("second"));
+
+    QTimer timer;
+    timer.setInterval(0);
+    qsmFirst.addTransition(&timer, SIGNAL(timeout()), &qsmSecond);
+    qsmSecond.addTransition(&timer, SIGNAL(timeout()), &qsmFirst);
+    qsm.start();
+
+    QsmAdapter adapter;
+    QSignalSpy spy(&adapter, &QsmAdapter::repopulateView);
+    QVERIFY(spy.wait(1000));
+    adapter.interface.setQStateMachine(&qsm);
+    QVERIFY(spy.wait(1000));
+
+    adapter.interface.setOverflowPolicy(policy);
+    QCOMPARE(adapter.interface.overflowPolicy(), policy);
+    adapter.interface.setMaximumQueueSize(4);
+    adapter.interface.setBatchInterval(60 * 1000);
+    timer.start();
+    QTRY_VERIFY(adapter.interface.droppedEventCount() > 0);
+    timer.stop();
+    QTest::qWait(10);
+
+    // the client recovers from the lost configuration updates
+    adapter.interface.setBatchInterval(0);
+    const QString current = qsm.configuration().contains(&qsmFirst) ? QStringLiteral("first") : QStringLiteral("second");
+    const auto runtime = adapter.machine()->runtimeController();
+    QTRY_COMPARE(runtime->activeConfiguration().size(), 1);
+    QTRY_COMPARE(runtime->activeConfiguration().values().at(0)->label(), current);
+}
+
+void QsmIntegrationTest::testMacrostep() // NOLINT(readability-function-cognitive-complexity)
+{
+    QStateMachine qsm;
+    QState qsmFirst(&qsm);
+    qsm.setInitialState(&qsmFirst);
+    QState qsmFirstChild(&qsmFirst);
+    qsmFirst.setInitialState(&qsmFirstChild);
+    QState qsmSecond(&qsm);
+    QState qsmSecondChild(&qsmSecond);
+    qsmSecond.setInitialState(&qsmSecondChild);
+
+    QTimer timer;
+    timer.setInterval(10);
+    timer.setSingleShot(true);
+    qsmFirstChild.addTransition(&timer, SIGNAL(timeout()), &qsmSecond);
+    qsmSecondChild.addTransition(&timer, SIGNAL(timeout()), &qsmFirst);
+    qsm.start();
+
+    QsmAdapter adapter;
+    QSignalSpy spy(&adapter, &QsmAdapter::repopulateView);
+    QVERIFY(spy.wait(1000));
+    const QSignalSpy batchSpy(adapter.debugInterface(), &DebugInterfaceReplica::eventBatch);
+    adapter.interface.setQStateMachine(&qsm);
+    QVERIFY(spy.wait(1000));
+    QTRY_VERIFY(!configurationUpdates(batchSpy).isEmpty());
+
+    // exiting and entering two states each results in one update
+    auto count = configurationUpdates(batchSpy).count();
+    timer.start();
+    QTRY_VERIFY(qsm.configuration().contains(&qsmSecondChild));
+    QTRY_COMPARE(configurationUpdates(batchSpy).count(), count + 1);
+    QTest::qWait(50);
+    QCOMPARE(configurationUpdates(batchSpy).count(), count + 1);
+    const auto update = configurationUpdates(batchSpy).last();
+    QCOMPARE(update.entered.size(), 2);
+    QCOMPARE(update.exited.size(), 2);
+
+    const auto messageCount = [&batchSpy]() {
+        int result = 0;
+        for (const auto &arguments : batchSpy) {
+            const auto batch = arguments.at(0).value<DebugInterface::EventBatch>();
+            result += static_cast<int>(std::count_if(batch.events.cbegin(), batch.events.cend(), [](const DebugInterface::Event &event) {
+                return event.type == DebugInterface::Event::MessageEvent;
+            }));
+        }
+        return result;
+    };
+    QCOMPARE(messageCount(), 0);
+
+    // messages are only sent on request
+    adapter.setMessagesEnabled(true);
+    QTest::qWait(10);
+    count = configurationUpdates(batchSpy).count();
+    timer.start();
+    QTRY_VERIFY(qsm.configuration().contains(&qsmFirstChild));
+    QTRY_COMPARE(configurationUpdates(batchSpy).count(), count + 1);
+    QCOMPARE(messageCount(), 4);
+
+    // and no longer once the only client asking for them withdraws
+    adapter.setMessagesEnabled(false);
+    QTest::qWait(10);
+    count = configurationUpdates(batchSpy).count();
+    timer.start();
+    QTRY_VERIFY(qsm.configuration().contains(&qsmSecondChild));
+    QTRY_COMPARE(configurationUpdates(batchSpy).count(), count + 1);
+    QCOMPARE(messageCount(), 4);
+}
+
+void QsmIntegrationTest::testStepBoundaries()
+{
+    QStateMachine qsm;
+    QState qsmFirst(&qsm);
+    qsm.setInitialState(&qsmFirst);
+    QState qsmSecond(&qsm);
+    QState qsmThird(&qsm);
+
+    QTimer timer;
+    timer.setInterval(10);
+    timer.setSingleShot(true);
+    qsmFirst.addTransition(&timer, SIGNAL(timeout()), &qsmSecond);
+    // eventless, taken within the same macrostep right after entering the second state
+    qsmSecond.addTransition(&qsmThird);
+    qsm.start();
+
+    QsmAdapter adapter;
+    QSignalSpy spy(&adapter, &QsmAdapter::repopulateView);
+    QVERIFY(spy.wait(1000));
+    const QSignalSpy batchSpy(adapter.debugInterface(), &DebugInterfaceReplica::eventBatch);
+    adapter.interface.setQStateMachine(&qsm);
+    QVERIFY(spy.wait(1000));
+    QTRY_VERIFY(!configurationUpdates(batchSpy).isEmpty());
+
+    const auto contains = [](const DebugInterface::StateMachineConfiguration &config, const QAbstractState *state) {
+        return std::any_of(config.cbegin(), config.cend(), [state](DebugInterface::StateId id) {
+            return id == reinterpret_cast<quint64>(state);
+        });
+    };
+
+    // the configuration between the two steps is published as well
+    const auto count = configurationUpdates(batchSpy).count();
+    timer.start();
+    QTRY_VERIFY(qsm.configuration().contains(&qsmThird));
+    QTRY_COMPARE(configurationUpdates(batchSpy).count(), count + 2);
+    const auto updates = configurationUpdates(batchSpy).mid(count);
+    QVERIFY(contains(updates.at(0).entered, &qsmSecond));
+    QVERIFY(contains(updates.at(0).exited, &qsmFirst));
+    QVERIFY(contains(updates.at(1).entered, &qsmThird));
+    QVERIFY(contains(updates.at(1).exited, &qsmSecond));
+}
+
+void QsmIntegrationTest::testStatesAddedLater() // NOLINT(readability-function-cognitive-complexity)
+{
+    QStateMachine qsm;
+    QState qsmFirst(&qsm);
+    qsmFirst.setObjectName(QStringLiteral("first"));
+    qsm.setInitialState(&qsmFirst);
+
+    QsmAdapter adapter;
+    QSignalSpy spy(&adapter, &QsmAdapter::repopulateView);
+    QVERIFY(spy.wait(1000));
+    adapter.interface.setQStateMachine(&qsm);
+    QVERIFY(spy.wait(1000));
+    const StateMachine *machine = adapter.machine();
+    QVERIFY(machine);
+
+    const auto labels = [machine]() {
+        QStringList result;
+        for (const Element *element : machine->findChildren<Element *>()) {
+            result << element->label();
+        }
+        return result;
+    };
+    QVERIFY(labels().contains(QStringLiteral("first")));
+
+    // the new states and transitions get watched and sent without repopulating
+    auto qsmSecond = new QState(&qsm);
+    qsmSecond->setObjectName(QStringLiteral("second"));
+    auto qsmSecondChild = new QState(qsmSecond);
+    qsmSecondChild->setObjectName(QStringLiteral("secondChild"));
+    qsmSecond->setInitialState(qsmSecondChild);
+    QTimer timer;
+    timer.setInterval(10);
+    timer.setSingleShot(true);
+    auto transition = qsmFirst.addTransition(&timer, SIGNAL(timeout()), qsmSecond);
+    transition->setObjectName(QStringLiteral("toSecond"));
+
+    QTRY_VERIFY(labels().contains(QStringLiteral("secondChild")));
+    QTRY_VERIFY(labels().contains(QStringLiteral("toSecond")));
+    QVERIFY(labels().contains(QStringLiteral("second")));
+    QCOMPARE(spy.count(), 2);
+
+    // and their runtime events are reported
+    qsm.start();
+    const auto runtime = machine->runtimeController();
+    QTRY_COMPARE(runtime->activeConfiguration().size(), 1);
+    timer.start();
+    QTRY_COMPARE(runtime->lastTransitions().size(), 1);
+    QCOMPARE(runtime->lastTransitions().at(0)->label(), QStringLiteral("toSecond"));
+    QTRY_COMPARE(runtime->activeConfiguration().size(), 2);
+}
+
+void QsmIntegrationTest::testLabelTable() // NOLINT(readability-function-cognitive-complexity)
+{
+    QStateMachine qsm;
+    QState qsmFirst(&qsm);
+    qsm.setInitialState(&qsmFirst);
+    QState qsmSecond(&qsm);
+
+    QTimer timer;
+    timer.setInterval(0);
+    timer.setSingleShot(true);
+    auto toSecond = qsmFirst.addTransition(&timer, SIGNAL(timeout()), &qsmSecond);
+    toSecond->setObjectName(QStringLiteral("toSecond"));
+    auto toFirst = qsmSecond.addTransition(&timer, SIGNAL(timeout()), &qsmFirst);
+    toFirst->setObjectName(QStringLiteral("toFirst"));
+    qsm.start();
+
+    QsmAdapter adapter;
+    QSignalSpy spy(&adapter, &QsmAdapter::repopulateView);
+    QVERIFY(spy.wait(1000));
+    const QSignalSpy batchSpy(adapter.debugInterface(), &DebugInterfaceReplica::eventBatch);
+    adapter.interface.setQStateMachine(&qsm);
+    QVERIFY(spy.wait(1000));
+
+    for (int i = 0; i < 6; ++i) {
+        timer.start();
+        QTRY_VERIFY(qsm.configuration().contains(i % 2 ? &qsmFirst : &qsmSecond));
+    }
+    const auto transitionEventCount = [&batchSpy]() {
+        int result = 0;
+        for (const auto &arguments : batchSpy) {
+            const auto batch = arguments.at(0).value<DebugInterface::EventBatch>();
+            result += static_cast<int>(std::count_if(batch.events.cbegin(), batch.events.cend(), [](const DebugInterface::Event &event) {
+                return event.type == DebugInterface::Event::TransitionEvent;
+            }));
+        }
+        return result;
+    };
+    QTRY_COMPARE(transitionEventCount(), 6);
+    QTRY_COMPARE(adapter.machine()->runtimeController()->lastTransitions().last()->label(), QStringLiteral("toFirst"));
+
+    // every label is sent once, the transition events only refer to it
+    QStringList labels;
+    int transitionEvents = 0;
+    for (const auto &arguments : batchSpy) {
+        const auto batch = arguments.at(0).value<DebugInterface::EventBatch>();
+        labels += batch.labels;
+        for (const auto &event : batch.events) {
+            if (event.type == DebugInterface::Event::TransitionEvent) {
+                ++transitionEvents;
+                QVERIFY(event.label < static_cast<quint32>(labels.size()));
+                QCOMPARE(labels.at(static_cast<int>(event.label)), transitionEvents % 2 ? QStringLiteral("toSecond") : QStringLiteral("toFirst"));
+            }
+        }
+    }
+    QCOMPARE(transitionEvents, 6);
+    QCOMPARE(labels, QStringList({ QStringLiteral("toSecond"), QStringLiteral("toFirst") }));
+}
+
+void QsmIntegrationTest::testRecentEvents() // NOLINT(readability-function-cognitive-complexity)
+{
+    QStateMachine qsm;
+    QState qsmFirst(&qsm);
+    qsm.setInitialState(&qsmFirst);
+    QState qsmSecond(&qsm);
+    qsmSecond.setObjectName(QStringLiteral("second"));
+
+    QTimer timer;
+    timer.setInterval(0);
+    timer.setSingleShot(true);
+    auto toSecond = qsmFirst.addTransition(&timer, SIGNAL(timeout()), &qsmSecond);
+    toSecond->setObjectName(QStringLiteral("toSecond"));
+    auto toFirst = qsmSecond.addTransition(&timer, SIGNAL(timeout()), &qsmFirst);
+    toFirst->setObjectName(QStringLiteral("toFirst"));
+    qsm.start();
+
+    QsmAdapter adapter;
+    QSignalSpy spy(&adapter, &QsmAdapter::repopulateView);
+    QVERIFY(spy.wait(1000));
+    adapter.interface.setQStateMachine(&qsm);
+    QVERIFY(spy.wait(1000));
+
+    for (int i = 0; i < 3; ++i) {
+        timer.start();
+        QTRY_VERIFY(qsm.configuration().contains(i % 2 ? &qsmFirst : &qsmSecond));
+    }
+
+    // the recorded events are returned with the token of the request
+    QSignalSpy recentSpy(adapter.debugInterface(), &DebugInterfaceReplica::recentEvents);
+    adapter.debugInterface()->requestRecentEvents(42);
+    QVERIFY(recentSpy.wait(1000));
+    const auto events = recentSpy.last().at(0).value<DebugInterface::RecentEvents>();
+    QCOMPARE(events.request, quint64(42));
+    QVERIFY(events.isValid());
+    const auto transitionCount = static_cast<int>(std::count(events.types.cbegin(), events.types.cend(), quint8(DebugInterface::RecentEvents::TransitionTriggered)));
+    QCOMPARE(transitionCount, 3);
+    QVERIFY(std::is_sorted(events.times.cbegin(), events.times.cend()));
+    QVERIFY(events.times.last() <= events.now);
+
+    // a client connecting some time later replays them
+    QTest::qWait(100);
+    QRemoteObjectNode lateNode(QUrl(QStringLiteral("local:registry")));
+    auto lateReplica = lateNode.acquire<DebugInterfaceReplica>();
+    QVERIFY(lateReplica->waitForSource());
+    DebugInterfaceClient lateClient;
+    QSignalSpy lateSpy(&lateClient, &DebugInterfaceClient::repopulateView);
+    lateClient.setDebugInterface(lateReplica);
+    QVERIFY(lateSpy.wait(1000));
+
+    RuntimeController *runtimeController = lateClient.machine()->runtimeController();
+    QTRY_COMPARE(runtimeController->lastTransitions().size(), 3);
+    const auto transitions = runtimeController->lastTransitions();
+    QCOMPARE(transitions.at(0)->label(), QStringLiteral("toSecond"));
+    QCOMPARE(transitions.at(1)->label(), QStringLiteral("toFirst"));
+    QCOMPARE(transitions.at(2)->label(), QStringLiteral("toSecond"));
+    QTRY_COMPARE(runtimeController->activeConfiguration().size(), 1);
+    State *second = runtimeController->activeConfiguration().values()[0];
+    QCOMPARE(second->label(), QStringLiteral("second"));
+
+    // no half-done configuration of a step is shown
+    const auto configurations = runtimeController->lastConfigurations();
+    for (const auto &configuration : configurations) {
+        QCOMPARE(configuration.size(), 1);
+    }
+
+    // the replayed events are no runtime events, the statistics only take the time of entering
+    QCOMPARE(runtimeController->transitionCount(), quint64(0));
+    QCOMPARE(runtimeController->fireCountForTransition(transitions.at(0)), quint64(0));
+    const auto statistics = runtimeController->statisticsForState(second);
+    QCOMPARE(statistics.visitCount, quint64(1));
+    QVERIFY(statistics.lastEntered < -50); // before the client got created
+
+    // the repopulation cleared the first client as well, it recovers its history from the same reply
+    RuntimeController *firstRuntimeController = adapter.machine()->runtimeController();
+    QTRY_COMPARE(firstRuntimeController->lastTransitions().size(), 3);
+    const auto firstTransitions = firstRuntimeController->lastTransitions();
+    QCOMPARE(firstTransitions.at(0)->label(), QStringLiteral("toSecond"));
+    QCOMPARE(firstTransitions.at(1)->label(), QStringLiteral("toFirst"));
+    QCOMPARE(firstTransitions.at(2)->label(), QStringLiteral("toSecond"));
+    QTRY_COMPARE(firstRuntimeController->activeConfiguration().size(), 1);
+
+    delete lateReplica;
 }
 
 QTEST_MAIN(QsmIntegrationTest)
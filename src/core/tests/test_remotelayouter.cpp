@@ -0,0 +1,198 @@
+/*
+  This file is part of the KDAB State Machine Editor Library.
+
+  SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company <info@kdab.com>
+
+  SPDX-License-Identifier: LGPL-2.1-only OR LicenseRef-KDAB-KDStateMachineEditor
+
+  Licensees holding valid commercial KDAB State Machine Editor Library
+  licenses may use this file in accordance with the KDAB State Machine Editor
+  Library License Agreement provided with the Software.
+
+  Contact info@kdab.com if any conditions of this licensing are not clear to you.
+*/
+
+#include <config-kdsme.h>
+#include <config-test.h>
+
+#include "util.h"
+
+#include "layerwiselayouter.h"
+#include "layoutproperties.h"
+#include "remotelayouter.h"
+#include "state.h"
+#include "sugiyamalayouter.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+#include <QTest>
+
+using namespace KDSME;
+
+class RemoteLayouterTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testProtocol();
+    void testUnknownLayouter();
+    void testWorker();
+    void testParallelRegions();
+    void testFallback();
+    void testBrokenWorker_data();
+    void testBrokenWorker();
+    void testStopWorkers();
+
+private:
+    static QString fileName()
+    {
+        return QStringLiteral(TEST_DATA_DIR "/scxml/microwave.scxml");
+    }
+};
+
+void RemoteLayouterTest::testProtocol()
+{
+    const QScopedPointer<StateMachine> remote(TestUtil::importMachine(fileName()));
+    QVERIFY(remote);
+
+    SugiyamaLayouter layouter;
+    const QList<QRectF> localGeometry = TestUtil::layoutGeometry(fileName(), &layouter);
+
+    // run the worker side in-process, the result must be the same
+    const LayoutProperties properties;
+    const QByteArray request = RemoteLayouter::encodeRequest(remote.data(), &properties, SugiyamaLayouter::staticMetaObject.className());
+    const QByteArray reply = RemoteLayouter::processRequest(request);
+    QRectF remoteRect;
+    QVERIFY(RemoteLayouter::applyReply(reply, remote.data(), &remoteRect));
+
+    QVERIFY(remoteRect.isValid());
+    QCOMPARE(TestUtil::stateGeometry(remote.data()), localGeometry);
+}
+
+void RemoteLayouterTest::testUnknownLayouter()
+{
+    const QScopedPointer<StateMachine> machine(TestUtil::importMachine(fileName()));
+    QVERIFY(machine);
+
+    const LayoutProperties properties;
+    const QByteArray reply = RemoteLayouter::processRequest(RemoteLayouter::encodeRequest(machine.data(), &properties, "NoSuchLayouter"));
+    QVERIFY(!RemoteLayouter::applyReply(reply, machine.data()));
+}
+
+void RemoteLayouterTest::testWorker()
+{
+    // the build system points KDSME_LAYOUT_WORKER to the real worker
+    const QString program = RemoteLayouter::workerProgram();
+    if (!QFileInfo(program).isExecutable()) {
+        QSKIP("kdsme_layoutworker not found");
+    }
+
+    // without a fallback, only the worker can have changed the geometry
+    RemoteLayouter layouter;
+    layouter.setLayouterName(SugiyamaLayouter::staticMetaObject.className());
+    layouter.setFallbackLayouterName(QByteArray());
+    SugiyamaLayouter local;
+    const QList<QRectF> localGeometry = TestUtil::layoutGeometry(fileName(), &local);
+    QCOMPARE(TestUtil::layoutGeometry(fileName(), &layouter), localGeometry);
+
+    // the worker process is reused for the next request
+    QCOMPARE(TestUtil::layoutGeometry(fileName(), &layouter), localGeometry);
+}
+
+void RemoteLayouterTest::testParallelRegions()
+{
+#if HAVE_GRAPHVIZ
+    if (!QFileInfo(RemoteLayouter::workerProgram()).isExecutable()) {
+        QSKIP("kdsme_layoutworker not found");
+    }
+
+    // the parallel layouter sends the regions to the workers, the result must be the same
+    const QString parallelFileName = QStringLiteral(TEST_DATA_DIR "/scxml/parallelstate.scxml");
+    LayerwiseLayouter sequentialLayouter;
+    const QList<QRectF> sequentialGeometry = TestUtil::layoutGeometry(parallelFileName, &sequentialLayouter);
+    QVERIFY(!sequentialGeometry.isEmpty());
+    LayerwiseLayouter parallelLayouter;
+    parallelLayouter.setParallel(true);
+    QCOMPARE(TestUtil::layoutGeometry(parallelFileName, &parallelLayouter), sequentialGeometry);
+#else
+    QSKIP("Regions are only sent to the workers with Graphviz");
+#endif
+}
+
+void RemoteLayouterTest::testFallback()
+{
+    const QString program = RemoteLayouter::workerProgram();
+    RemoteLayouter::setWorkerProgram(QStringLiteral("/nonexistent/kdsme_layoutworker"));
+
+    // the worker cannot be started, the state still gets laid out in-process
+    RemoteLayouter layouter;
+    QVERIFY(layouter.mayBlock());
+    const QList<QRectF> geometry = TestUtil::layoutGeometry(fileName(), &layouter);
+    RemoteLayouter::setWorkerProgram(program);
+
+    SugiyamaLayouter fallback;
+    QCOMPARE(geometry, TestUtil::layoutGeometry(fileName(), &fallback));
+}
+
+void RemoteLayouterTest::testBrokenWorker_data()
+{
+    QTest::addColumn<QByteArray>("script");
+
+    // both read part of the request only
+    QTest::newRow("crash") << QByteArray("head -c 4 > /dev/null\nkill -SEGV $$\n");
+    QTest::newRow("exit") << QByteArray("head -c 4 > /dev/null\nexit 1\n");
+    QTest::newRow("stall") << QByteArray("head -c 4 > /dev/null\nexec sleep 60\n");
+}
+
+void RemoteLayouterTest::testBrokenWorker()
+{
+#ifndef Q_OS_UNIX
+    QSKIP("The fake workers are shell scripts");
+#endif
+    QFETCH(QByteArray, script);
+
+    const QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QFile worker(dir.filePath(QStringLiteral("worker.sh")));
+    QVERIFY(worker.open(QIODevice::WriteOnly));
+    worker.write("#!/bin/sh\n" + script);
+    worker.close();
+    QVERIFY(worker.setPermissions(worker.permissions() | QFileDevice::ExeOwner));
+
+    const QString program = RemoteLayouter::workerProgram();
+    RemoteLayouter::setWorkerProgram(worker.fileName());
+
+    RemoteLayouter layouter;
+    layouter.setTimeout(500);
+    QElapsedTimer timer;
+    timer.start();
+    const QList<QRectF> geometry = TestUtil::layoutGeometry(fileName(), &layouter);
+    const qint64 elapsed = timer.elapsed();
+    RemoteLayouter::setWorkerProgram(program);
+
+    // the request is given up on, and laid out in-process instead
+    QVERIFY2(elapsed < 10000, QByteArray::number(elapsed).constData());
+    SugiyamaLayouter fallback;
+    QCOMPARE(geometry, TestUtil::layoutGeometry(fileName(), &fallback));
+}
+
+void RemoteLayouterTest::testStopWorkers()
+{
+    const QScopedPointer<StateMachine> machine(TestUtil::importMachine(fileName()));
+    QVERIFY(machine);
+    const QList<QRectF> geometry = TestUtil::stateGeometry(machine.data());
+
+    // requests fail right away once the workers are stopped
+    RemoteLayouter::stopWorkers();
+    RemoteLayouter layouter;
+    layouter.setFallbackLayouterName(QByteArray());
+    const LayoutProperties properties;
+    QVERIFY(!layouter.layout(machine.data(), &properties).isValid());
+    QCOMPARE(TestUtil::stateGeometry(machine.data()), geometry);
+}
+
+QTEST_MAIN(RemoteLayouterTest)
+
+#include "test_remotelayouter.moc"
@@ -0,0 +1,159 @@
+/*
+  This file is part of the KDAB State Machine Editor Library.
+
+  SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company <info@kdab.com>
+
+  SPDX-License-Identifier: LGPL-2.1-only OR LicenseRef-KDAB-KDStateMachineEditor
+
+  Licensees holding valid commercial KDAB State Machine Editor Library
+  licenses may use this file in accordance with the KDAB State Machine Editor
+  Library License Agreement provided with the Software.
+
+  Contact info@kdab.com if any conditions of this licensing are not clear to you.
+*/
+
+#include <config-test.h>
+
+#include "runtimecontroller.h"
+#include "runtimehistory.h"
+#include "state.h"
+#include "transition.h"
+#include "util.h"
+
+#include <QSignalSpy>
+#include <QTest>
+
+using namespace KDSME;
+
+class RuntimeHistoryTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testLookup();
+    void testSeek();
+    void testClear();
+};
+
+void RuntimeHistoryTest::testLookup() // NOLINT(readability-function-cognitive-complexity)
+{
+    const QScopedPointer<StateMachine> machine(TestUtil::importMachine(QStringLiteral(TEST_DATA_DIR "/scxml/microwave.scxml")));
+    const auto states = machine->findChildren<State *>();
+    const auto transitions = machine->findChildren<Transition *>();
+    QVERIFY(states.size() > 2);
+    QVERIFY(!transitions.isEmpty());
+
+    RuntimeController *controller = machine->runtimeController();
+    RuntimeHistory history(controller);
+    history.setCheckpointInterval(16);
+    history.setMemoryLimit(256); // force spilling
+
+    // expected events, unchanged configurations are not logged
+    QList<RuntimeHistory::Event> expected;
+    RuntimeController::Configuration current;
+    for (int i = 0; i < 500; ++i) {
+        Transition *transition = transitions.at(i % transitions.size());
+        controller->setLastTransition(transition);
+        expected.append({ RuntimeHistory::Event::TransitionEvent, 0, current, transition });
+
+        const RuntimeController::Configuration configuration = { machine.data(), states.at(i % states.size()), states.at((i * 7) % states.size()) };
+        controller->setActiveConfiguration(configuration);
+        if (configuration != current) {
+            current = configuration;
+            expected.append({ RuntimeHistory::Event::ConfigurationEvent, 0, current, nullptr });
+        }
+    }
+
+    QCOMPARE(history.eventCount(), quint64(expected.size()));
+    QVERIFY(history.spilledSize() > 0);
+    QVERIFY(history.memoryUsage() < history.spilledSize());
+
+    qint64 previousTime = 0;
+    for (quint64 i = 0; i < history.eventCount(); ++i) {
+        const RuntimeHistory::Event event = history.event(i);
+        QCOMPARE(event.type, expected.at(static_cast<int>(i)).type);
+        QCOMPARE(event.transition, expected.at(static_cast<int>(i)).transition);
+        QCOMPARE(event.configuration, expected.at(static_cast<int>(i)).configuration);
+        QCOMPARE(history.configurationAt(i), event.configuration);
+
+        QVERIFY(event.time >= previousTime);
+        previousTime = event.time;
+        // events logged within the same nanosecond map to the newest of them
+        const qint64 found = history.eventAt(event.time);
+        QVERIFY(found >= qint64(i));
+        QCOMPARE(history.event(static_cast<quint64>(found)).time, event.time);
+    }
+    QVERIFY(history.configurationAt(0).isEmpty());
+    QVERIFY(history.event(history.eventCount()).configuration.isEmpty());
+    QCOMPARE(history.eventAt(-1), qint64(-1));
+    QCOMPARE(history.eventAt(history.duration() + 1), qint64(history.eventCount() - 1));
+}
+
+void RuntimeHistoryTest::testSeek()
+{
+    const QScopedPointer<StateMachine> machine(TestUtil::importMachine(QStringLiteral(TEST_DATA_DIR "/scxml/microwave.scxml")));
+    const auto states = machine->findChildren<State *>();
+    RuntimeController *controller = machine->runtimeController();
+    controller->setActiveConfiguration({ states.at(0) });
+
+    // the configuration at construction time is logged too
+    RuntimeHistory history(controller);
+    QCOMPARE(history.eventCount(), quint64(1));
+    controller->setActiveConfiguration({ states.at(1) });
+    controller->setActiveConfiguration({ states.at(2) });
+    QCOMPARE(history.eventCount(), quint64(3));
+    QCOMPARE(history.position(), qint64(-1));
+
+    const QSignalSpy positionSpy(&history, &RuntimeHistory::positionChanged);
+    const QSignalSpy receivedSpy(controller, &RuntimeController::configurationReceived);
+    history.seek(1);
+    QCOMPARE(history.position(), qint64(1));
+    QCOMPARE(positionSpy.count(), 1);
+    QCOMPARE(controller->activeConfiguration(), RuntimeController::Configuration({ states.at(1) }));
+    QCOMPARE(history.eventCount(), quint64(3));
+
+    // looking at the past is no runtime event
+    QCOMPARE(receivedSpy.count(), 0);
+    QCOMPARE(controller->statisticsForState(states.at(1)).visitCount, quint64(1));
+
+    history.seekToLive();
+    QCOMPARE(history.position(), qint64(-1));
+    QCOMPARE(controller->activeConfiguration(), RuntimeController::Configuration({ states.at(2) }));
+    QCOMPARE(history.eventCount(), quint64(3));
+
+    // new events move the history back to live
+    history.seek(0);
+    controller->setActiveConfiguration({ states.at(1) });
+    QCOMPARE(history.position(), qint64(-1));
+    QCOMPARE(history.eventCount(), quint64(4));
+}
+
+void RuntimeHistoryTest::testClear()
+{
+    const QScopedPointer<StateMachine> machine(TestUtil::importMachine(QStringLiteral(TEST_DATA_DIR "/scxml/microwave.scxml")));
+    const auto states = machine->findChildren<State *>();
+    RuntimeController *controller = machine->runtimeController();
+    RuntimeHistory history(controller);
+    history.setMemoryLimit(0);
+    history.setCheckpointInterval(1);
+    for (int i = 0; i < 10; ++i) {
+        controller->setActiveConfiguration({ states.at(i % states.size()) });
+    }
+    QCOMPARE(history.eventCount(), quint64(10));
+    QVERIFY(history.spilledSize() > 0);
+
+    history.clear();
+    QCOMPARE(history.eventCount(), quint64(0));
+    QCOMPARE(history.spilledSize(), qint64(0));
+    QCOMPARE(history.duration(), qint64(0));
+    QCOMPARE(history.eventAt(0), qint64(-1));
+
+    const RuntimeController::Configuration configuration = { machine.data(), states.at(0) };
+    controller->setActiveConfiguration(configuration);
+    QCOMPARE(history.eventCount(), quint64(1));
+    QCOMPARE(history.configurationAt(0), configuration);
+}
+
+QTEST_MAIN(RuntimeHistoryTest)
+
+#include "test_runtimehistory.moc"
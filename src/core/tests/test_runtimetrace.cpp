@@ -0,0 +1,171 @@
+/*
+  This file is part of the KDAB State Machine Editor Library.
+
+  SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company <info@kdab.com>
+
+  SPDX-License-Identifier: LGPL-2.1-only OR LicenseRef-KDAB-KDStateMachineEditor
+
+  Licensees holding valid commercial KDAB State Machine Editor Library
+  licenses may use this file in accordance with the KDAB State Machine Editor
+  Library License Agreement provided with the Software.
+
+  Contact info@kdab.com if any conditions of this licensing are not clear to you.
+*/
+
+#include <config-test.h>
+
+#include "runtimecontroller.h"
+#include "runtimetrace.h"
+#include "state.h"
+#include "transition.h"
+#include "util.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <algorithm>
+#include <type_traits>
+
+using namespace KDSME;
+
+class RuntimeTraceTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testRecordAndReplay();
+    void testSpeed();
+    void testInvalidFile();
+
+private:
+    /// @return The configurations and transitions in @p spy as indices into the elements of @p machine
+    template<typename T>
+    static QList<QList<int>> indices(const QSignalSpy &spy, const StateMachine *machine)
+    {
+        const auto elements = machine->findChildren<T *>();
+        QList<QList<int>> result;
+        for (const auto &arguments : spy) {
+            QList<int> event;
+            if constexpr (std::is_same_v<T, State>) {
+                const auto configuration = arguments.at(0).value<RuntimeController::Configuration>();
+                for (State *state : configuration) {
+                    event << static_cast<int>(elements.indexOf(state));
+                }
+                std::sort(event.begin(), event.end());
+            } else {
+                event << static_cast<int>(elements.indexOf(arguments.at(0).value<T *>()));
+            }
+            result << event;
+        }
+        return result;
+    }
+};
+
+void RuntimeTraceTest::testRecordAndReplay() // NOLINT(readability-function-cognitive-complexity)
+{
+    const QTemporaryDir dir;
+    const QString fileName = dir.filePath(QStringLiteral("trace.kdsmetrace"));
+
+    const QScopedPointer<StateMachine> machine(TestUtil::importMachine(QStringLiteral(TEST_DATA_DIR "/scxml/microwave.scxml")));
+    const auto states = machine->findChildren<State *>();
+    const auto transitions = machine->findChildren<Transition *>();
+    QVERIFY(states.size() > 2);
+    QVERIFY(!transitions.isEmpty());
+
+    RuntimeController *controller = machine->runtimeController();
+    controller->setCoalesceUpdates(true); // recording must not depend on published updates
+    RuntimeTraceRecorder recorder(controller);
+    QVERIFY(recorder.start(fileName));
+    QVERIFY(recorder.isRecording());
+
+    const QSignalSpy recordedConfigurations(controller, &RuntimeController::configurationReceived);
+    const QSignalSpy recordedTransitions(controller, &RuntimeController::transitionReceived);
+    for (int i = 0; i < 1000; ++i) {
+        controller->setLastTransition(transitions.at(i % transitions.size()));
+        controller->setActiveConfiguration({ machine.data(), states.at(i % states.size()), states.at((i * 7) % states.size()) });
+    }
+    recorder.stop();
+    QVERIFY(!recorder.isRecording());
+    QVERIFY(recorder.errorString().isEmpty());
+    QCOMPARE(recorder.eventCount(), quint64(recordedConfigurations.count() + recordedTransitions.count()));
+
+    // replay on another instance of the same machine
+    const QScopedPointer<StateMachine> replayMachine(TestUtil::importMachine(QStringLiteral(TEST_DATA_DIR "/scxml/microwave.scxml")));
+    RuntimeTracePlayer player;
+    player.setMachine(replayMachine.data());
+    player.setSpeed(0);
+    QVERIFY(player.open(fileName));
+    QVERIFY(!player.atEnd());
+
+    RuntimeController *replayController = replayMachine->runtimeController();
+    const QSignalSpy replayedConfigurations(replayController, &RuntimeController::configurationReceived);
+    const QSignalSpy replayedTransitions(replayController, &RuntimeController::transitionReceived);
+    const QSignalSpy finishedSpy(&player, &RuntimeTracePlayer::finished);
+    player.play();
+    QVERIFY(player.isPlaying());
+    QTRY_COMPARE(finishedSpy.count(), 1);
+    QVERIFY(!player.isPlaying());
+    QVERIFY(player.atEnd());
+    QCOMPARE(player.position(), recorder.eventCount());
+
+    QCOMPARE(indices<State>(replayedConfigurations, replayMachine.data()), indices<State>(recordedConfigurations, machine.data()));
+    QCOMPARE(indices<Transition>(replayedTransitions, replayMachine.data()), indices<Transition>(recordedTransitions, machine.data()));
+
+    // rewinding
+    player.stop();
+    QCOMPARE(player.position(), quint64(0));
+    QVERIFY(replayController->activeConfiguration().isEmpty());
+    QVERIFY(!player.atEnd());
+}
+
+void RuntimeTraceTest::testSpeed()
+{
+    const QTemporaryDir dir;
+    const QString fileName = dir.filePath(QStringLiteral("trace.kdsmetrace"));
+
+    const QScopedPointer<StateMachine> machine(TestUtil::importMachine(QStringLiteral(TEST_DATA_DIR "/scxml/microwave.scxml")));
+    const auto states = machine->findChildren<State *>();
+    RuntimeTraceRecorder recorder(machine->runtimeController());
+    QVERIFY(recorder.start(fileName));
+    machine->runtimeController()->setActiveConfiguration({ states.at(0) });
+    QTest::qWait(200);
+    machine->runtimeController()->setActiveConfiguration({ states.at(1) });
+    recorder.stop();
+
+    RuntimeTracePlayer player;
+    player.setMachine(machine.data());
+    player.setSpeed(2);
+    QVERIFY(player.open(fileName));
+    const QSignalSpy finishedSpy(&player, &RuntimeTracePlayer::finished);
+
+    QElapsedTimer timer;
+    timer.start();
+    player.play();
+    QTRY_COMPARE(finishedSpy.count(), 1);
+    QVERIFY(timer.elapsed() >= 90);
+    QVERIFY(player.time() >= 200 * 1000000LL);
+    QCOMPARE(machine->runtimeController()->activeConfiguration(), RuntimeController::Configuration({ states.at(1) }));
+}
+
+void RuntimeTraceTest::testInvalidFile()
+{
+    const QTemporaryDir dir;
+    const QString fileName = dir.filePath(QStringLiteral("invalid.kdsmetrace"));
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write("This is not a trace");
+    file.close();
+
+    RuntimeTracePlayer player;
+    QVERIFY(!player.open(fileName));
+    QVERIFY(!player.errorString().isEmpty());
+    QVERIFY(!player.isOpen());
+    QVERIFY(!player.open(dir.filePath(QStringLiteral("missing.kdsmetrace"))));
+}
+
+QTEST_MAIN(RuntimeTraceTest)
+
+#include "test_runtimetrace.moc"
@@ -13,10 +13,12 @@
   Contact info@kdab.com if any conditions of this licensing are not clear to you.
 */
 
+#include "runtimecontroller.h"
 #include "state.h"
 #include "transition.h"
 
 #include <QDebug>
+#include <QSignalSpy>
 #include <QTest>
 
 using namespace KDSME;
@@ -28,6 +30,12 @@ class StateMachineTest : public QObject
 private Q_SLOTS:
     void testProperties();
     void testParentChildRelationship();
+    void testIncomingTransitions();
+    void testActiveness();
+    void testConfigurationBits();
+    void testCoalescedUpdates();
+    void testStatistics();
+    void testActiveRegion();
 };
 
 void StateMachineTest::testProperties()
@@ -63,6 +71,278 @@ void StateMachineTest::testParentChildRelationship() // NOLINT(readability-funct
     QCOMPARE(t11.sourceState(), &s11);
 }
 
+void StateMachineTest::testIncomingTransitions()
+{
+    StateMachine machine;
+    State s1(&machine);
+    State s2(&machine);
+    auto *s3 = new State(&machine);
+
+    Transition t1(&s1);
+    t1.setTargetState(&s2);
+    auto *t2 = new Transition(&s1);
+    t2->setTargetState(&s2);
+    QCOMPARE(s2.incomingTransitions(), QList<Transition *>() << &t1 << t2);
+    QVERIFY(s1.incomingTransitions().isEmpty());
+
+    t1.setTargetState(s3);
+    QCOMPARE(s2.incomingTransitions(), QList<Transition *>() << t2);
+    QCOMPARE(s3->incomingTransitions(), QList<Transition *>() << &t1);
+
+    delete t2;
+    QVERIFY(s2.incomingTransitions().isEmpty());
+
+    // transitions do not keep pointing to deleted states
+    delete s3;
+    QCOMPARE(t1.targetState(), nullptr);
+}
+
+void StateMachineTest::testActiveness()
+{
+    StateMachine machine;
+    State s1(&machine);
+    State s2(&machine);
+    State s3(&machine);
+
+    RuntimeController controller;
+    controller.setHistorySize(2);
+    QSignalSpy s1Spy(&s1, &State::activenessChanged);
+    QSignalSpy s3Spy(&s3, &State::activenessChanged);
+
+    controller.setActiveConfiguration({ &s1 });
+    QCOMPARE(s1.activeness(), 1.f);
+    QCOMPARE(controller.activenessForState(&s1), 1.f);
+    QCOMPARE(s1Spy.count(), 1);
+
+    controller.setActiveConfiguration({ &s1, &s2 });
+    QCOMPARE(s1.activeness(), 1.f);
+    QCOMPARE(s2.activeness(), 1.f);
+    QCOMPARE(s1Spy.count(), 1); // still active, no notification
+
+    controller.setActiveConfiguration({ &s2 });
+    QCOMPARE(s1.activeness(), 0.5f);
+    QCOMPARE(controller.activenessForState(&s1), 0.5f);
+    QCOMPARE(s2.activeness(), 1.f);
+    QCOMPARE(s1Spy.count(), 2);
+
+    // s1 drops out of the history
+    controller.setActiveConfiguration({ &s2, &s3 });
+    QCOMPARE(s1.activeness(), 0.f);
+    QCOMPARE(controller.activenessForState(&s1), 0.f);
+    QCOMPARE(s1Spy.count(), 3);
+    QCOMPARE(s3Spy.count(), 1);
+
+    controller.clear();
+    QCOMPARE(s2.activeness(), 0.f);
+    QCOMPARE(s3.activeness(), 0.f);
+    QCOMPARE(s3Spy.count(), 2);
+}
+
+void StateMachineTest::testConfigurationBits() // NOLINT(readability-function-cognitive-complexity)
+{
+    StateMachine machine;
+    State s1(&machine);
+    State s2(&machine);
+    State s3(&machine);
+
+    RuntimeController controller;
+    QCOMPARE(controller.indexOfState(&s1), -1);
+    QVERIFY(controller.activeConfigurationBits().isEmpty());
+
+    controller.setActiveConfiguration({ &s1, &s2 });
+    const int i1 = controller.indexOfState(&s1);
+    const int i2 = controller.indexOfState(&s2);
+    QVERIFY(i1 >= 0 && i2 >= 0 && i1 != i2);
+    QCOMPARE(controller.indexOfState(&s3), -1);
+    QCOMPARE(controller.stateAt(i1), &s1);
+    QCOMPARE(controller.stateAt(i2), &s2);
+    QCOMPARE(controller.stateAt(42), nullptr);
+    QCOMPARE(controller.activeConfigurationBits().count(true), 2);
+    QVERIFY(controller.isActive(&s1));
+    QVERIFY(!controller.isActive(&s3));
+    QCOMPARE(controller.activeConfiguration(), RuntimeController::Configuration({ &s1, &s2 }));
+
+    // indices are stable, new states get appended
+    controller.setActiveConfiguration({ &s3 });
+    QCOMPARE(controller.indexOfState(&s1), i1);
+    QCOMPARE(controller.indexOfState(&s3), 2);
+    QVERIFY(!controller.isActive(&s1));
+    QVERIFY(controller.isActive(&s3));
+
+    // equal to the newest configuration despite the shorter bit array of the older one
+    controller.setActiveConfiguration({ &s1, &s2 });
+    QSignalSpy spy(&controller, &RuntimeController::activeConfigurationChanged);
+    controller.setActiveConfiguration({ &s2, &s1 });
+    QCOMPARE(spy.count(), 0);
+
+    const QList<RuntimeController::Configuration> expected = {
+        { &s1, &s2 },
+        { &s3 },
+        { &s1, &s2 }
+    };
+    QCOMPARE(controller.lastConfigurations(), expected);
+
+    controller.clear();
+    QCOMPARE(controller.indexOfState(&s1), -1);
+    QVERIFY(controller.activeConfiguration().isEmpty());
+    QVERIFY(controller.lastConfigurations().isEmpty());
+}
+
+void StateMachineTest::testCoalescedUpdates() // NOLINT(readability-function-cognitive-complexity)
+{
+    StateMachine machine;
+    State s1(&machine);
+    State s2(&machine);
+    State s3(&machine);
+    Transition t1(&s1);
+    t1.setTargetState(&s2);
+    Transition t2(&s2);
+    t2.setTargetState(&s3);
+
+    RuntimeController controller;
+    controller.setCoalesceUpdates(true);
+    controller.setUpdateInterval(10);
+    QSignalSpy configurationSpy(&controller, &RuntimeController::activeConfigurationChanged);
+    QSignalSpy transitionSpy(&controller, &RuntimeController::lastTransitionChanged);
+
+    controller.setActiveConfiguration({ &s1 });
+    for (int i = 0; i < 100; ++i) {
+        controller.setLastTransition(&t1);
+        controller.setActiveConfiguration({ &s2 });
+        controller.setLastTransition(&t2);
+        controller.setActiveConfiguration({ &s3 });
+    }
+
+    // nothing published yet
+    QCOMPARE(configurationSpy.count(), 0);
+    QVERIFY(controller.activeConfiguration().isEmpty());
+    QCOMPARE(controller.lastTransition(), nullptr);
+    QCOMPARE(controller.transitionCount(), quint64(200));
+
+    QTRY_COMPARE(configurationSpy.count(), 1);
+    QCOMPARE(transitionSpy.count(), 1);
+    QCOMPARE(controller.activeConfiguration(), RuntimeController::Configuration({ &s3 }));
+    QCOMPARE(controller.lastTransition(), &t2);
+    QCOMPARE(controller.skippedTransitionCount(), quint64(199));
+    QCOMPARE(controller.skippedConfigurationCount(), quint64(200));
+
+    // flushing explicitly, and when leaving the coalescing mode
+    controller.setLastTransition(&t1);
+    controller.setActiveConfiguration({ &s2 });
+    controller.flushUpdates();
+    QCOMPARE(configurationSpy.count(), 2);
+    QCOMPARE(controller.lastTransition(), &t1);
+
+    controller.setActiveConfiguration({ &s1 });
+    controller.setCoalesceUpdates(false);
+    QCOMPARE(configurationSpy.count(), 3);
+    QCOMPARE(controller.activeConfiguration(), RuntimeController::Configuration({ &s1 }));
+
+    controller.setLastTransition(&t2);
+    QCOMPARE(transitionSpy.count(), 3);
+    QCOMPARE(controller.transitionCount(), quint64(202));
+    QCOMPARE(controller.skippedTransitionCount(), quint64(199));
+}
+
+void StateMachineTest::testStatistics() // NOLINT(readability-function-cognitive-complexity)
+{
+    StateMachine machine;
+    State s1(&machine);
+    State s2(&machine);
+    Transition t1(&s1);
+    t1.setTargetState(&s2);
+
+    RuntimeController controller;
+    controller.setHistorySize(2);
+    QSignalSpy spy(&controller, &RuntimeController::statisticsChanged);
+
+    controller.setActiveConfiguration({ &s1 });
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.at(0).at(0).value<QList<Element *>>(), QList<Element *>() << &s1);
+    QTest::qWait(10);
+
+    // statistics are kept beyond the history size
+    for (int i = 0; i < 10; ++i) {
+        controller.setLastTransition(&t1);
+        controller.setActiveConfiguration({ &s2 });
+        controller.setActiveConfiguration({ &s1 });
+    }
+    QCOMPARE(controller.statisticsForState(&s1).visitCount, quint64(11));
+    QCOMPARE(controller.statisticsForState(&s2).visitCount, quint64(10));
+    QCOMPARE(controller.fireCountForTransition(&t1), quint64(10));
+    QVERIFY(controller.statisticsForState(&s1).dwellTime >= 10);
+    QVERIFY(controller.statisticsForState(&s2).lastEntered <= controller.statisticsTime());
+
+    // also when coalescing
+    controller.setCoalesceUpdates(true);
+    spy.clear();
+    controller.setActiveConfiguration({ &s2 });
+    controller.setActiveConfiguration({ &s1 });
+    QCOMPARE(spy.count(), 0);
+    QCOMPARE(controller.statisticsForState(&s2).visitCount, quint64(11));
+    controller.flushUpdates();
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.at(0).at(0).value<QList<Element *>>().size(), 2);
+
+    // active states count as visited once after a reset, views get notified about all of them
+    spy.clear();
+    controller.resetStatistics();
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.at(0).at(0).value<QList<Element *>>().size(), 3);
+    QCOMPARE(controller.statisticsForState(&s1).visitCount, quint64(1));
+    QCOMPARE(controller.statisticsForState(&s2).visitCount, quint64(0));
+    QCOMPARE(controller.fireCountForTransition(&t1), quint64(0));
+
+    controller.clear();
+    QCOMPARE(controller.statisticsForState(&s1).visitCount, quint64(0));
+}
+
+void StateMachineTest::testActiveRegion() // NOLINT(readability-function-cognitive-complexity)
+{
+    StateMachine machine;
+    State parent(&machine);
+    parent.setPos(QPointF(100, 100));
+    parent.setWidth(300);
+    parent.setHeight(300);
+    State s1(&parent);
+    s1.setPos(QPointF(10, 10));
+    s1.setWidth(50);
+    s1.setHeight(50);
+    State s2(&parent);
+    s2.setPos(QPointF(100, 100));
+    s2.setWidth(50);
+    s2.setHeight(50);
+
+    RuntimeController controller;
+    QSignalSpy spy(&controller, &RuntimeController::activeRegionChanged);
+
+    // in scene coordinates, not relative to the parent
+    controller.setActiveConfiguration({ &s1 });
+    QCOMPARE(controller.activeRegion(), QRectF(110, 110, 50, 50));
+    controller.setActiveConfiguration({ &s1, &s2 });
+    QCOMPARE(controller.activeRegion(), QRectF(110, 110, 140, 140));
+    controller.setActiveConfiguration({ &parent, &s1, &s2 });
+    QCOMPARE(controller.activeRegion(), QRectF(100, 100, 300, 300));
+    QCOMPARE(spy.count(), 3);
+
+    // s1 is inside the region without touching its border, nothing changes
+    controller.setActiveConfiguration({ &parent, &s2 });
+    QCOMPARE(controller.activeRegion(), QRectF(100, 100, 300, 300));
+    QCOMPARE(spy.count(), 3);
+
+    controller.setActiveConfiguration({ &s2 });
+    QCOMPARE(controller.activeRegion(), QRectF(200, 200, 50, 50));
+
+    // moving an ancestor moves the region
+    parent.setPos(QPointF(0, 0));
+    QTRY_COMPARE(controller.activeRegion(), QRectF(100, 100, 50, 50));
+    s2.setWidth(100);
+    QTRY_COMPARE(controller.activeRegion(), QRectF(100, 100, 100, 50));
+
+    controller.clear();
+    QCOMPARE(controller.activeRegion(), QRectF());
+}
+
 QTEST_MAIN(StateMachineTest)
 
 #include "test_statemachine.moc"
@@ -0,0 +1,159 @@
+/*
+  This file is part of the KDAB State Machine Editor Library.
+
+  SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company <info@kdab.com>
+
+  SPDX-License-Identifier: LGPL-2.1-only OR LicenseRef-KDAB-KDStateMachineEditor
+
+  Licensees holding valid commercial KDAB State Machine Editor Library
+  licenses may use this file in accordance with the KDAB State Machine Editor
+  Library License Agreement provided with the Software.
+
+  Contact info@kdab.com if any conditions of this licensing are not clear to you.
+*/
+
+#include <config-test.h>
+
+#include "elementutil.h"
+#include "layoutproperties.h"
+#include "layoutresult.h"
+#include "objecthelper.h"
+#include "parsehelper.h"
+#include "scxmlimporter.h"
+#include "state.h"
+#include "sugiyamalayouter.h"
+#include "transition.h"
+
+#include <QTest>
+
+using namespace KDSME;
+using namespace ObjectHelper;
+
+class SugiyamaLayouterTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testLayers();
+    void testCycle();
+    void testNoOverlaps_data();
+    void testNoOverlaps();
+
+private:
+    static State *addState(State *parent, const QString &label)
+    {
+        auto *state = new State(parent);
+        state->setLabel(label);
+        return state;
+    }
+
+    static Transition *addTransition(State *source, State *target)
+    {
+        auto *transition = new Transition(source);
+        transition->setTargetState(target);
+        return transition;
+    }
+};
+
+void SugiyamaLayouterTest::testLayers()
+{
+    /*
+        State chart:
+            (A) -> (B) -> (C)
+             \-------------^
+    */
+    StateMachine machine;
+    State *a = addState(&machine, QStringLiteral("A"));
+    State *b = addState(&machine, QStringLiteral("B"));
+    State *c = addState(&machine, QStringLiteral("C"));
+    addTransition(a, b);
+    addTransition(b, c);
+    addTransition(a, c);
+
+    const LayoutProperties properties;
+    const LayoutResult result = SugiyamaLayouter::computeLayout(&machine, &properties);
+    QCOMPARE(result.states.size(), 3);
+    QCOMPARE(result.transitions.size(), 3);
+    result.apply();
+
+    // one layer per state, top to bottom
+    QVERIFY(a->boundingRect().bottom() < b->boundingRect().top());
+    QVERIFY(b->boundingRect().bottom() < c->boundingRect().top());
+
+    const QRectF boundingRect = result.boundingRect;
+    QCOMPARE(boundingRect.topLeft(), QPointF());
+    for (const State *state : { a, b, c }) {
+        QVERIFY(boundingRect.contains(state->boundingRect()));
+    }
+}
+
+void SugiyamaLayouterTest::testCycle()
+{
+    /*
+        State chart:
+            (A) -> (B) -> (C) -> (A), (C) -> (C)
+    */
+    StateMachine machine;
+    State *a = addState(&machine, QStringLiteral("A"));
+    State *b = addState(&machine, QStringLiteral("B"));
+    State *c = addState(&machine, QStringLiteral("C"));
+    addTransition(a, b);
+    addTransition(b, c);
+    Transition *backEdge = addTransition(c, a);
+    Transition *selfLoop = addTransition(c, c);
+
+    const LayoutProperties properties;
+    SugiyamaLayouter layouter;
+    layouter.layout(&machine, &properties);
+
+    QVERIFY(a->boundingRect().bottom() < b->boundingRect().top());
+    QVERIFY(b->boundingRect().bottom() < c->boundingRect().top());
+    QVERIFY(!backEdge->shape().isEmpty());
+    QVERIFY(!selfLoop->shape().isEmpty());
+
+    // the edge closing the cycle still starts at its source state
+    const QPointF start = c->absolutePos() + backEdge->pos() + backEdge->shape().pointAtPercent(0);
+    QVERIFY(qAbs(start.y() - c->absolutePos().y()) < 1.0);
+}
+
+void SugiyamaLayouterTest::testNoOverlaps_data()
+{
+    QTest::addColumn<QString>("fileName");
+
+    QTest::newRow("parallelstate") << QStringLiteral(TEST_DATA_DIR "/scxml/parallelstate.scxml");
+    QTest::newRow("microwave") << QStringLiteral(TEST_DATA_DIR "/scxml/microwave.scxml");
+    QTest::newRow("calculator") << QStringLiteral(TEST_DATA_DIR "/scxml/calculator.scxml");
+}
+
+void SugiyamaLayouterTest::testNoOverlaps()
+{
+    QFETCH(QString, fileName);
+
+    ScxmlImporter importer(ParseHelper::readFile(fileName));
+    const QScopedPointer<StateMachine> machine(importer.import());
+    QVERIFY(machine);
+
+    const LayoutProperties properties;
+    SugiyamaLayouter layouter;
+    layouter.layout(machine.data(), &properties);
+
+    const auto states = copy_if_type<State *>(machine->findChildren<Element *>());
+    for (const State *state : states) {
+        QVERIFY(state->width() > 0);
+        QVERIFY(state->height() > 0);
+
+        // regions contain their children, which do not overlap each other
+        const auto childStates = state->childStates();
+        const QRectF region(QPointF(), QSizeF(state->width(), state->height()));
+        for (int i = 0; i < childStates.size(); ++i) {
+            QVERIFY(region.contains(childStates.at(i)->boundingRect()));
+            for (int j = i + 1; j < childStates.size(); ++j) {
+                QVERIFY(!childStates.at(i)->boundingRect().intersects(childStates.at(j)->boundingRect()));
+            }
+        }
+    }
+}
+
+QTEST_MAIN(SugiyamaLayouterTest)
+
+#include "test_sugiyamalayouter.moc"
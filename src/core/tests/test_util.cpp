@@ -14,6 +14,7 @@
 */
 
 #include "elementwalker.h"
+#include "ringbuffer.h"
 #include "state.h"
 #include "transition.h"
 
@@ -29,6 +30,7 @@ class UtilTest : public QObject // clazy:exclude=ctor-missing-parent-argument
 
 private Q_SLOTS:
     void testElementWalker();
+    void testRingBuffer();
 };
 
 void UtilTest::testElementWalker()
@@ -74,6 +76,53 @@ void UtilTest::testElementWalker()
     QCOMPARE(count, 1);
 }
 
+void UtilTest::testRingBuffer()
+{
+    RingBuffer<int> buffer(3);
+    QVERIFY(buffer.isEmpty());
+    QCOMPARE(buffer.indexOf(1), -1);
+
+    buffer.enqueue(1);
+    buffer.enqueue(2);
+    QCOMPARE(buffer.entries(), QList<int>() << 1 << 2);
+
+    // wraps around, dropping the oldest items
+    buffer.enqueue(3);
+    buffer.enqueue(4);
+    buffer.enqueue(5);
+    QCOMPARE(buffer.size(), 3);
+    QCOMPARE(buffer.entries(), QList<int>() << 3 << 4 << 5);
+    QCOMPARE(buffer.head(), 3);
+    QCOMPARE(buffer.last(), 5);
+    QCOMPARE(buffer.fromNewest(0), 5);
+    QCOMPARE(buffer.fromNewest(2), 3);
+    QCOMPARE(buffer.indexOf(4), 1);
+    QCOMPARE(buffer.indexOf(1), -1);
+
+    QList<int> iterated;
+    for (int value : buffer) {
+        iterated << value;
+    }
+    QCOMPARE(iterated, buffer.entries());
+
+    // keeps the newest items when shrinking
+    buffer.setCapacity(2);
+    QCOMPARE(buffer.entries(), QList<int>() << 4 << 5);
+    buffer.enqueue(6);
+    QCOMPARE(buffer.entries(), QList<int>() << 5 << 6);
+
+    buffer.setCapacity(4);
+    buffer.enqueue(7);
+    buffer.enqueue(8);
+    buffer.enqueue(9);
+    QCOMPARE(buffer.entries(), QList<int>() << 6 << 7 << 8 << 9);
+
+    buffer.clear();
+    QVERIFY(buffer.isEmpty());
+    buffer.enqueue(10);
+    QCOMPARE(buffer.entries(), QList<int>() << 10);
+}
+
 QTEST_MAIN(UtilTest)
 
 #include "test_util.moc"
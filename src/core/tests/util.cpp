@@ -15,6 +15,13 @@
 
 #include "util.h"
 
+#include "layouter.h"
+#include "layoutproperties.h"
+#include "objecthelper.h"
+#include "parsehelper.h"
+#include "scxmlimporter.h"
+#include "state.h"
+
 #include <QEventLoop>
 #include <QObject>
 #include <QSignalSpy>
@@ -34,3 +41,31 @@ bool TestUtil::waitForSignal(const QObject *obj, const char *signal, std::chrono
     loop.exec();
     return timeoutSpy.isEmpty();
 }
+
+KDSME::StateMachine *TestUtil::importMachine(const QString &fileName)
+{
+    KDSME::ScxmlImporter importer(ParseHelper::readFile(fileName));
+    return importer.import();
+}
+
+QList<QRectF> TestUtil::stateGeometry(const KDSME::State *root)
+{
+    QList<QRectF> geometry;
+    const auto states = ObjectHelper::copy_if_type<KDSME::State *>(root->findChildren<KDSME::Element *>());
+    for (const KDSME::State *state : states) {
+        geometry << QRectF(state->pos(), QSizeF(state->width(), state->height()));
+    }
+    return geometry;
+}
+
+QList<QRectF> TestUtil::layoutGeometry(const QString &fileName, KDSME::Layouter *layouter)
+{
+    const QScopedPointer<KDSME::StateMachine> machine(importMachine(fileName));
+    if (!machine) {
+        return {};
+    }
+
+    const KDSME::LayoutProperties properties;
+    layouter->layout(machine.data(), &properties);
+    return stateGeometry(machine.data());
+}
@@ -16,13 +16,22 @@
 #ifndef TESTS_UTIL_H
 #define TESTS_UTIL_H
 
-#include <qglobal.h>
+#include <QList>
+#include <QRectF>
+
 #include <chrono>
 
 QT_BEGIN_NAMESPACE
 class QObject;
+class QString;
 QT_END_NAMESPACE
 
+namespace KDSME {
+class Layouter;
+class State;
+class StateMachine;
+}
+
 namespace TestUtil {
 
 /**
@@ -35,6 +44,25 @@ namespace TestUtil {
  */
 bool waitForSignal(const QObject *obj, const char *signal, std::chrono::milliseconds timeout = std::chrono::seconds { 1 });
 
+/**
+ * Imports the SCXML file \p fileName
+ *
+ * \return the new state machine, owned by the caller, or nullptr on failure
+ */
+KDSME::StateMachine *importMachine(const QString &fileName);
+
+/**
+ * \return the geometry of all states below \p root, in the order of QObject::findChildren()
+ */
+QList<QRectF> stateGeometry(const KDSME::State *root);
+
+/**
+ * Lays out \p fileName in a fresh state machine using \p layouter
+ *
+ * \return the resulting stateGeometry(), empty on import failure
+ */
+QList<QRectF> layoutGeometry(const QString &fileName, KDSME::Layouter *layouter);
+
 }
 
 #endif
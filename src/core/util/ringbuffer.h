@@ -17,8 +17,10 @@
 #ifndef KDSME_UTIL_RINGBUFFER_H
 #define KDSME_UTIL_RINGBUFFER_H
 
-#include <QQueue>
 #include <QList>
+#include <QVector>
+
+#include <iterator>
 
 namespace KDSME {
 
@@ -29,6 +31,11 @@ namespace KDSME {
  *
  * Or, in other words, RingBuffer is a QQueue with limited capacity.
  *
+ * The items are kept in one contiguous block of at most capacity() items, which is
+ * reused once full, hence enqueue() is O(1) and never allocates after the buffer filled up.
+ * Iterating from begin() to end() visits the items from the oldest to the newest one
+ * without copying them.
+ *
  * The API is essentially simplified version of QVector, which additional methods
  * such as @ref enqueue(), @ref setCapacity()
  *
@@ -38,6 +45,57 @@ template<class T>
 class RingBuffer
 {
 public:
+    class const_iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = int;
+        using pointer = const T *;
+        using reference = const T &;
+
+        const_iterator() = default;
+
+        inline const T &operator*() const
+        {
+            return m_buffer->at(m_index);
+        }
+        inline const T *operator->() const
+        {
+            return &m_buffer->at(m_index);
+        }
+        inline const_iterator &operator++()
+        {
+            ++m_index;
+            return *this;
+        }
+        inline const_iterator operator++(int)
+        {
+            const_iterator it = *this;
+            ++m_index;
+            return it;
+        }
+        inline bool operator==(const const_iterator &other) const
+        {
+            return m_index == other.m_index && m_buffer == other.m_buffer;
+        }
+        inline bool operator!=(const const_iterator &other) const
+        {
+            return !(*this == other);
+        }
+
+    private:
+        friend class RingBuffer;
+        const_iterator(const RingBuffer *buffer, int index)
+            : m_buffer(buffer)
+            , m_index(index)
+        {
+        }
+
+        const RingBuffer *m_buffer = nullptr;
+        int m_index = 0;
+    };
+
     /**
      * Construct a ring buffer with initial capacity @p capacity
      */
@@ -46,17 +104,32 @@ public:
     {
     }
 
+    inline int capacity() const
+    {
+        return m_capacity;
+    }
+
     /**
      * (Re-)set the capacity of this ring buffer to @p capacity
      *
-     * @note Will run cleanup() afterwards and remove items if capacity decreased
-     * @sa cleanup()
+     * @note Removes the oldest items if capacity decreased
      */
     void setCapacity(int capacity)
     {
         Q_ASSERT(capacity > 0);
+        if (capacity == m_capacity)
+            return;
+
+        // move the newest items to the front of a new block
+        const int count = qMin(size(), capacity);
+        QVector<T> entries;
+        entries.reserve(count);
+        for (int i = size() - count; i < size(); ++i) {
+            entries.append(at(i));
+        }
+        m_entries = std::move(entries);
+        m_start = 0;
         m_capacity = capacity;
-        cleanup();
     }
 
     /**
@@ -64,8 +137,15 @@ public:
      */
     void enqueue(T t)
     {
-        m_entries.enqueue(t);
-        cleanup();
+        if (m_entries.size() < m_capacity) {
+            m_entries.append(std::move(t));
+            return;
+        }
+
+        m_entries[m_start] = std::move(t);
+        if (++m_start == m_capacity) {
+            m_start = 0;
+        }
     }
 
     /**
@@ -74,46 +154,86 @@ public:
     void clear()
     {
         m_entries.clear();
+        m_start = 0;
     }
 
+    /**
+     * Returns the item at index position @p i, 0 being the oldest item
+     */
     inline const T &at(int i) const
     {
-        return m_entries.at(i);
+        Q_ASSERT(i >= 0 && i < size());
+        const int index = m_start + i;
+        return m_entries.at(index < m_entries.size() ? index : index - m_entries.size());
+    }
+    /**
+     * Returns the item at index position @p i, counted from the newest item
+     *
+     * fromNewest(0) is the same as last()
+     */
+    inline const T &fromNewest(int i) const
+    {
+        return at(size() - 1 - i);
     }
     inline int size() const
     {
         return m_entries.size();
     }
+    inline bool isEmpty() const
+    {
+        return m_entries.isEmpty();
+    }
+    /**
+     * Returns the index position of the first occurrence of @p t, 0 being the oldest item,
+     * or -1 if no item matched
+     */
+    int indexOf(const T &t) const
+    {
+        for (int i = 0; i < size(); ++i) {
+            if (at(i) == t) {
+                return i;
+            }
+        }
+        return -1;
+    }
     /**
      * Returns a reference to the queue's head item.
      * This function assumes that the queue isn't empty.
      */
-    inline T head() const
+    inline const T &head() const
     {
-        return m_entries.head();
+        return at(0);
     }
     /**
      * Returns a reference to the last item in the list.
      * The list must not be empty.
      */
-    inline T last() const
+    inline const T &last() const
     {
-        return m_entries.last();
+        return at(size() - 1);
     }
-    inline QList<T> entries() const
+    inline const_iterator begin() const
     {
-        return m_entries;
+        return const_iterator(this, 0);
     }
-
-private:
-    void cleanup()
+    inline const_iterator end() const
     {
-        while (m_entries.size() > m_capacity) {
-            m_entries.dequeue();
-        }
+        return const_iterator(this, size());
+    }
+    /**
+     * Returns a copy of all items, from the oldest to the newest one
+     *
+     * @note Allocates, prefer iterating the buffer itself
+     */
+    QList<T> entries() const
+    {
+        return QList<T>(begin(), end());
     }
 
-    QQueue<T> m_entries;
+private:
+    QVector<T> m_entries;
+    /// Index of the oldest item in m_entries
+    int m_start = 0;
     int m_capacity;
 };
 
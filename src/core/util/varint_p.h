@@ -0,0 +1,60 @@
+/*
+  This file is part of the KDAB State Machine Editor Library.
+
+  SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company <info@kdab.com>
+
+  SPDX-License-Identifier: LGPL-2.1-only OR LicenseRef-KDAB-KDStateMachineEditor
+
+  Licensees holding valid commercial KDAB State Machine Editor Library
+  licenses may use this file in accordance with the KDAB State Machine Editor
+  Library License Agreement provided with the Software.
+
+  Contact info@kdab.com if any conditions of this licensing are not clear to you.
+*/
+
+#ifndef KDSME_UTIL_VARINT_P_H
+#define KDSME_UTIL_VARINT_P_H
+
+#include <QByteArray>
+
+namespace KDSME {
+
+/// Unsigned LEB128 encoding, as used by the binary runtime logs
+namespace Varint {
+
+inline void append(QByteArray &buffer, quint64 value)
+{
+    while (value >= 0x80) {
+        buffer.append(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    buffer.append(static_cast<char>(value));
+}
+
+/**
+ * Read a value from @p data of @p size bytes at @p offset, which gets advanced
+ *
+ * @return False in case the value is truncated or does not fit into 64 bits
+ */
+inline bool read(const uchar *data, qint64 size, qint64 *offset, quint64 *value)
+{
+    quint64 result = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (*offset >= size) {
+            return false;
+        }
+        const uchar byte = data[(*offset)++];
+        result |= quint64(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            *value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+}
+
+}
+
+#endif // KDSME_UTIL_VARINT_P_H
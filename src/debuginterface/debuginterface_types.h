@@ -17,8 +17,12 @@
 #define KDSME_DEBUGINTERFACE_TYPES_H
 
 #include <QDataStream>
+#include <QHash>
 #include <QList>
 #include <QMetaType>
+#include <QStringList>
+
+#include <algorithm>
 
 QT_BEGIN_NAMESPACE
 class QAbstractTransition;
@@ -98,6 +102,252 @@ inline QDataStream &operator>>(QDataStream &in, StateType &value)
 
 typedef QList<StateId> StateMachineConfiguration;
 
+/**
+ * A change of the active configuration
+ *
+ * Updates are numbered consecutively. A keyframe carries the complete configuration in
+ * @c entered, other updates only the states entered and exited since the previous update.
+ * Clients missing an update wait for the next keyframe.
+ */
+struct ConfigurationUpdate
+{
+    quint64 sequence = 0;
+    bool keyframe = false;
+    StateMachineConfiguration entered;
+    StateMachineConfiguration exited;
+};
+
+inline QDataStream &operator<<(QDataStream &out, const ConfigurationUpdate &value)
+{
+    out << value.sequence << value.keyframe << value.entered << value.exited;
+    return out;
+}
+
+inline QDataStream &operator>>(QDataStream &in, ConfigurationUpdate &value)
+{
+    in >> value.sequence >> value.keyframe >> value.entered >> value.exited;
+    return in;
+}
+
+/// A runtime event queued by a debug source
+struct Event
+{
+    enum Type : quint8
+    {
+        MessageEvent,
+        ConfigurationEvent,
+        TransitionEvent
+    };
+
+    Type type = MessageEvent;
+    /// The message
+    QString text;
+    ConfigurationUpdate configuration;
+    TransitionId transition = { 0 };
+    /// Label of the triggered transition, as index into the label table, see EventBatch
+    quint32 label = 0;
+};
+
+inline QDataStream &operator<<(QDataStream &out, const Event &value)
+{
+    out << static_cast<quint8>(value.type);
+    switch (value.type) {
+    case Event::MessageEvent:
+        out << value.text;
+        break;
+    case Event::ConfigurationEvent:
+        out << value.configuration;
+        break;
+    case Event::TransitionEvent:
+        out << value.transition << value.label;
+        break;
+    }
+    return out;
+}
+
+inline QDataStream &operator>>(QDataStream &in, Event &value)
+{
+    quint8 type;
+    in >> type;
+    value.type = static_cast<Event::Type>(type);
+    switch (value.type) {
+    case Event::MessageEvent:
+        in >> value.text;
+        break;
+    case Event::ConfigurationEvent:
+        in >> value.configuration;
+        break;
+    case Event::TransitionEvent:
+        in >> value.transition >> value.label;
+        break;
+    default:
+        in.setStatus(QDataStream::ReadCorruptData);
+        break;
+    }
+    return in;
+}
+
+/**
+ * Events sent by a debug source in one message
+ *
+ * Labels are sent only once: each batch appends the labels first used by its events to the
+ * label table, which starts over whenever the graph gets repopulated.
+ */
+struct EventBatch
+{
+    QList<Event> events;
+    /// Labels to append to the label table, before handling the events
+    QStringList labels;
+    /// Number of events the source dropped since the previous batch, see OverflowPolicy
+    quint64 droppedEvents = 0;
+};
+
+inline QDataStream &operator<<(QDataStream &out, const EventBatch &value)
+{
+    out << value.events << value.labels << value.droppedEvents;
+    return out;
+}
+
+inline QDataStream &operator>>(QDataStream &in, EventBatch &value)
+{
+    in >> value.events >> value.labels >> value.droppedEvents;
+    return in;
+}
+
+/**
+ * The complete graph of a state machine in one message
+ *
+ * Element properties are stored in flat arrays indexed by the element's position, labels are
+ * indices into a table of unique strings. Parents precede their children, so clients can
+ * create all states in a single pass.
+ */
+struct GraphSnapshot
+{
+    enum StateFlag : quint8
+    {
+        HasChildren = 0x1,
+        ConnectToInitial = 0x2
+    };
+
+    void addState(StateId id, StateId parent, bool hasChildren, const QString &label, StateType type, bool connectToInitial)
+    {
+        stateIds << id.id;
+        stateParents << parent.id;
+        stateTypes << static_cast<quint8>(type);
+        stateFlags << static_cast<quint8>((hasChildren ? HasChildren : 0) | (connectToInitial ? ConnectToInitial : 0));
+        stateLabels << addString(label);
+    }
+
+    void addTransition(TransitionId id, StateId source, StateId target, const QString &label)
+    {
+        transitionIds << id.id;
+        transitionSources << source.id;
+        transitionTargets << target.id;
+        transitionLabels << addString(label);
+    }
+
+    int addString(const QString &string)
+    {
+        const auto it = stringIndices.constFind(string);
+        if (it != stringIndices.constEnd()) {
+            return *it;
+        }
+        const int index = static_cast<int>(strings.size());
+        strings << string;
+        stringIndices.insert(string, index);
+        return index;
+    }
+
+    /// @return Whether the arrays are consistent, i.e. safe to index
+    bool isValid() const
+    {
+        const auto isString = [this](int index) { return index >= 0 && index < strings.size(); };
+        return stateParents.size() == stateIds.size() && stateTypes.size() == stateIds.size()
+            && stateFlags.size() == stateIds.size() && stateLabels.size() == stateIds.size()
+            && transitionSources.size() == transitionIds.size() && transitionTargets.size() == transitionIds.size()
+            && transitionLabels.size() == transitionIds.size()
+            && std::all_of(stateLabels.cbegin(), stateLabels.cend(), isString)
+            && std::all_of(transitionLabels.cbegin(), transitionLabels.cend(), isString);
+    }
+
+    QList<quint64> stateIds;
+    QList<quint64> stateParents;
+    QList<quint8> stateTypes;
+    QList<quint8> stateFlags;
+    QList<int> stateLabels;
+
+    QList<quint64> transitionIds;
+    QList<quint64> transitionSources;
+    QList<quint64> transitionTargets;
+    QList<int> transitionLabels;
+
+    QStringList strings;
+    /// Only used while building the snapshot, not transferred
+    QHash<QString, int> stringIndices;
+};
+
+inline QDataStream &operator<<(QDataStream &out, const GraphSnapshot &value)
+{
+    out << value.stateIds << value.stateParents << value.stateTypes << value.stateFlags << value.stateLabels
+        << value.transitionIds << value.transitionSources << value.transitionTargets << value.transitionLabels
+        << value.strings;
+    return out;
+}
+
+inline QDataStream &operator>>(QDataStream &in, GraphSnapshot &value)
+{
+    in >> value.stateIds >> value.stateParents >> value.stateTypes >> value.stateFlags >> value.stateLabels
+        >> value.transitionIds >> value.transitionSources >> value.transitionTargets >> value.transitionLabels
+        >> value.strings;
+    value.stringIndices.clear();
+    return in;
+}
+
+/**
+ * The most recent runtime events recorded by a debug source, oldest first
+ *
+ * Sent on request, so clients connecting while the machine is running can catch up. As all clients
+ * receive them, the request is identified by a token chosen by the requesting client. Repopulating
+ * the graph clears all clients though, so each of them may replay the next ones.
+ */
+struct RecentEvents
+{
+    enum Type : quint8
+    {
+        StateEntered,
+        StateExited,
+        TransitionTriggered
+    };
+
+    /// @return Whether the arrays are consistent
+    bool isValid() const
+    {
+        return types.size() == times.size() && ids.size() == times.size();
+    }
+
+    /// Token passed to requestRecentEvents()
+    quint64 request = 0;
+    /// Time the events were collected, on the monotonic clock of the source, in nanoseconds
+    qint64 now = 0;
+    /// Time of each event, on the same clock as @c now
+    QList<qint64> times;
+    QList<quint8> types;
+    /// A StateId or TransitionId, depending on the type
+    QList<quint64> ids;
+};
+
+inline QDataStream &operator<<(QDataStream &out, const RecentEvents &value)
+{
+    out << value.request << value.now << value.times << value.types << value.ids;
+    return out;
+}
+
+inline QDataStream &operator>>(QDataStream &in, RecentEvents &value)
+{
+    in >> value.request >> value.now >> value.times >> value.types >> value.ids;
+    return in;
+}
+
 inline void registerTypes() // krazy:exclude=inline
 {
 #if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
@@ -105,6 +355,10 @@ inline void registerTypes() // krazy:exclude=inline
     qRegisterMetaTypeStreamOperators<StateMachineConfiguration>();
     qRegisterMetaTypeStreamOperators<TransitionId>();
     qRegisterMetaTypeStreamOperators<StateType>();
+    qRegisterMetaTypeStreamOperators<GraphSnapshot>();
+    qRegisterMetaTypeStreamOperators<ConfigurationUpdate>();
+    qRegisterMetaTypeStreamOperators<EventBatch>();
+    qRegisterMetaTypeStreamOperators<RecentEvents>();
 #endif
 }
 
@@ -115,5 +369,9 @@ Q_DECLARE_METATYPE(KDSME::DebugInterface::StateId)
 Q_DECLARE_METATYPE(KDSME::DebugInterface::TransitionId)
 Q_DECLARE_METATYPE(KDSME::DebugInterface::StateMachineConfiguration)
 Q_DECLARE_METATYPE(KDSME::DebugInterface::StateType)
+Q_DECLARE_METATYPE(KDSME::DebugInterface::GraphSnapshot)
+Q_DECLARE_METATYPE(KDSME::DebugInterface::ConfigurationUpdate)
+Q_DECLARE_METATYPE(KDSME::DebugInterface::EventBatch)
+Q_DECLARE_METATYPE(KDSME::DebugInterface::RecentEvents)
 
 #endif
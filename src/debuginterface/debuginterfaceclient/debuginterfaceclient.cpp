@@ -24,6 +24,7 @@
 #include "transition.h"
 
 #include <QDebug>
+#include <QRandomGenerator>
 
 #define IF_DEBUG(x)
 
@@ -55,6 +56,7 @@ public:
         : q(q)
         , m_debugInterface(nullptr)
         , m_machine(nullptr)
+        , m_clientId(QRandomGenerator::global()->generate64() | 1)
     {
         DebugInterface::registerTypes();
     }
@@ -64,10 +66,14 @@ public Q_SLOTS:
     void stateAdded(const DebugInterface::StateId stateId, const DebugInterface::StateId parentId, const bool hasChildren,
                     const QString &label, const DebugInterface::StateType type, const bool connectToInitial);
     void stateConfigurationChanged(const DebugInterface::StateMachineConfiguration &config);
+    void stateConfigurationUpdated(const DebugInterface::ConfigurationUpdate &update);
     void transitionAdded(const DebugInterface::TransitionId transitionId, const DebugInterface::StateId source,
                          const DebugInterface::StateId target, const QString &label);
+    void graphSnapshot(const DebugInterface::GraphSnapshot &snapshot);
     void statusChanged(const bool haveStateMachine, const bool running);
     void transitionTriggered(DebugInterface::TransitionId transition, const QString &label);
+    void eventBatch(const DebugInterface::EventBatch &batch);
+    void recentEvents(const DebugInterface::RecentEvents &events);
 
     void repopulateView();
     void clearGraph();
@@ -75,22 +81,51 @@ public Q_SLOTS:
     void stateChanged(QRemoteObjectReplica::State state);
 
 public:
+    /// Fetch the graph, the current configuration and the recent events
+    void repopulate();
+
     DebugInterfaceClient *q;
     DebugInterfaceReplica *m_debugInterface;
 
     QHash<DebugInterface::StateId, State *> m_idToStateMap;
     QHash<DebugInterface::TransitionId, Transition *> m_idToTransitionMap;
     StateMachine *m_machine;
+
+    /// Labels referenced by the received events, see EventBatch
+    QStringList m_labels;
+
+    /// The configuration built from the received updates
+    RuntimeController::Configuration m_configuration;
+    quint64 m_nextConfigurationSequence = 0;
+    /// Set when an update got lost, updates are ignored until the next keyframe
+    bool m_awaitingKeyframe = true;
+    /**
+     * Set when the graph got cleared, by this client repopulating or by another one
+     *
+     * Recent events are sent to all clients, the next ones restore the history of
+     * every client which got cleared, whoever requested them.
+     */
+    bool m_replayPending = false;
+
+    /// Identifies this client towards the source, see setMessagesEnabled()
+    const quint64 m_clientId;
+    bool m_messagesEnabled = false;
 };
 
 DebugInterfaceClient::DebugInterfaceClient(QObject *parent)
     : RuntimeController(parent)
     , d(new Private(this))
 {
+    // remote machines may transition way faster than we can render
+    setCoalesceUpdates(true);
 }
 
 DebugInterfaceClient::~DebugInterfaceClient()
 {
+    // the source would keep sending messages for us otherwise
+    if (d->m_messagesEnabled && d->m_debugInterface && d->m_debugInterface->isReplicaValid()) {
+        d->m_debugInterface->setMessagesEnabled(d->m_clientId, false);
+    }
 }
 
 DebugInterfaceReplica *DebugInterfaceClient::debugInterface() const
@@ -104,18 +139,30 @@ void DebugInterfaceClient::setDebugInterface(DebugInterfaceReplica *debugInterfa
         return;
 
     if (d->m_debugInterface) {
+        if (d->m_messagesEnabled && d->m_debugInterface->isReplicaValid()) {
+            d->m_debugInterface->setMessagesEnabled(d->m_clientId, false);
+        }
+
         disconnect(d->m_debugInterface, &DebugInterfaceReplica::message,
                    d.data(), &Private::showMessage);
         disconnect(d->m_debugInterface, &DebugInterfaceReplica::stateConfigurationChanged,
                    d.data(), &Private::stateConfigurationChanged);
+        disconnect(d->m_debugInterface, &DebugInterfaceReplica::stateConfigurationUpdated,
+                   d.data(), &Private::stateConfigurationUpdated);
         disconnect(d->m_debugInterface, &DebugInterfaceReplica::stateAdded,
                    d.data(), &Private::stateAdded);
         disconnect(d->m_debugInterface, &DebugInterfaceReplica::transitionAdded,
                    d.data(), &Private::transitionAdded);
+        disconnect(d->m_debugInterface, &DebugInterfaceReplica::graphSnapshot,
+                   d.data(), &Private::graphSnapshot);
         disconnect(d->m_debugInterface, &DebugInterfaceReplica::statusChanged,
                    d.data(), &Private::statusChanged);
         disconnect(d->m_debugInterface, &DebugInterfaceReplica::transitionTriggered,
                    d.data(), &Private::transitionTriggered);
+        disconnect(d->m_debugInterface, &DebugInterfaceReplica::eventBatch,
+                   d.data(), &Private::eventBatch);
+        disconnect(d->m_debugInterface, &DebugInterfaceReplica::recentEvents,
+                   d.data(), &Private::recentEvents);
         disconnect(d->m_debugInterface, &DebugInterfaceReplica::aboutToRepopulateGraph,
                    d.data(), &Private::clearGraph);
         disconnect(d->m_debugInterface, &DebugInterfaceReplica::graphRepopulated,
@@ -133,14 +180,22 @@ void DebugInterfaceClient::setDebugInterface(DebugInterfaceReplica *debugInterfa
                 d.data(), &Private::showMessage);
         connect(d->m_debugInterface, &DebugInterfaceReplica::stateConfigurationChanged,
                 d.data(), &Private::stateConfigurationChanged);
+        connect(d->m_debugInterface, &DebugInterfaceReplica::stateConfigurationUpdated,
+                d.data(), &Private::stateConfigurationUpdated);
         connect(d->m_debugInterface, &DebugInterfaceReplica::stateAdded,
                 d.data(), &Private::stateAdded);
         connect(d->m_debugInterface, &DebugInterfaceReplica::transitionAdded,
                 d.data(), &Private::transitionAdded);
+        connect(d->m_debugInterface, &DebugInterfaceReplica::graphSnapshot,
+                d.data(), &Private::graphSnapshot);
         connect(d->m_debugInterface, &DebugInterfaceReplica::statusChanged,
                 d.data(), &Private::statusChanged);
         connect(d->m_debugInterface, &DebugInterfaceReplica::transitionTriggered,
                 d.data(), &Private::transitionTriggered);
+        connect(d->m_debugInterface, &DebugInterfaceReplica::eventBatch,
+                d.data(), &Private::eventBatch);
+        connect(d->m_debugInterface, &DebugInterfaceReplica::recentEvents,
+                d.data(), &Private::recentEvents);
         connect(d->m_debugInterface, &DebugInterfaceReplica::aboutToRepopulateGraph,
                 d.data(), &Private::clearGraph);
         connect(d->m_debugInterface, &DebugInterfaceReplica::graphRepopulated,
@@ -148,7 +203,7 @@ void DebugInterfaceClient::setDebugInterface(DebugInterfaceReplica *debugInterfa
         connect(d->m_debugInterface, &DebugInterfaceReplica::stateChanged,
                 d.data(), &Private::stateChanged);
 
-        d->m_debugInterface->repopulateGraph();
+        d->repopulate();
     }
 }
 
@@ -157,6 +212,23 @@ StateMachine *DebugInterfaceClient::machine() const
     return d->m_machine;
 }
 
+bool DebugInterfaceClient::messagesEnabled() const
+{
+    return d->m_messagesEnabled;
+}
+
+void DebugInterfaceClient::setMessagesEnabled(bool enabled)
+{
+    if (d->m_messagesEnabled == enabled)
+        return;
+
+    d->m_messagesEnabled = enabled;
+    // otherwise sent once connected, see Private::repopulate()
+    if (d->m_debugInterface && d->m_debugInterface->isReplicaValid()) {
+        d->m_debugInterface->setMessagesEnabled(d->m_clientId, enabled);
+    }
+}
+
 void DebugInterfaceClient::Private::showMessage(const QString &message)
 {
     Q_UNUSED(message);
@@ -169,6 +241,35 @@ void DebugInterfaceClient::Private::stateConfigurationChanged(const StateMachine
     q->setActiveConfiguration(smeConfig);
 }
 
+void DebugInterfaceClient::Private::stateConfigurationUpdated(const ConfigurationUpdate &update)
+{
+    IF_DEBUG(qDebug() << "stateConfigurationUpdated" << update.sequence << update.keyframe << update.entered.size() << update.exited.size());
+
+    if (update.keyframe) {
+        m_configuration = toSmeConfiguration(update.entered, m_idToStateMap);
+        m_awaitingKeyframe = false;
+    } else if (m_awaitingKeyframe) {
+        return;
+    } else if (update.sequence != m_nextConfigurationSequence) {
+        IF_DEBUG(qDebug() << "Missed configuration updates" << m_nextConfigurationSequence << "to" << update.sequence - 1 << ", resynchronizing");
+        m_awaitingKeyframe = true;
+        m_debugInterface->requestConfigurationKeyframe();
+        return;
+    } else {
+        for (const StateId &id : update.exited) {
+            m_configuration.remove(m_idToStateMap.value(id));
+        }
+        for (const StateId &id : update.entered) {
+            if (auto state = m_idToStateMap.value(id)) {
+                m_configuration.insert(state);
+            }
+        }
+    }
+    m_nextConfigurationSequence = update.sequence + 1;
+
+    q->setActiveConfiguration(m_configuration);
+}
+
 void DebugInterfaceClient::Private::stateAdded(const StateId stateId, const StateId parentId, const bool hasChildren,
                                                const QString &label, const StateType type, const bool connectToInitial)
 {
@@ -230,6 +331,30 @@ void DebugInterfaceClient::Private::transitionAdded(const TransitionId transitio
     m_idToTransitionMap[transitionId] = transition;
 }
 
+void DebugInterfaceClient::Private::graphSnapshot(const GraphSnapshot &snapshot)
+{
+    IF_DEBUG(qDebug() << "graphSnapshot" << snapshot.stateIds.size() << snapshot.transitionIds.size());
+
+    if (!snapshot.isValid()) {
+        qWarning() << "Ignoring inconsistent graph snapshot";
+        return;
+    }
+
+    m_idToStateMap.reserve(m_idToStateMap.size() + snapshot.stateIds.size());
+    for (qsizetype i = 0; i < snapshot.stateIds.size(); ++i) {
+        const quint8 flags = snapshot.stateFlags.at(i);
+        stateAdded(StateId { snapshot.stateIds.at(i) }, StateId { snapshot.stateParents.at(i) },
+                   (flags & GraphSnapshot::HasChildren) != 0, snapshot.strings.at(snapshot.stateLabels.at(i)),
+                   static_cast<StateType>(snapshot.stateTypes.at(i)), (flags & GraphSnapshot::ConnectToInitial) != 0);
+    }
+
+    m_idToTransitionMap.reserve(m_idToTransitionMap.size() + snapshot.transitionIds.size());
+    for (qsizetype i = 0; i < snapshot.transitionIds.size(); ++i) {
+        transitionAdded(TransitionId { snapshot.transitionIds.at(i) }, StateId { snapshot.transitionSources.at(i) },
+                        StateId { snapshot.transitionTargets.at(i) }, snapshot.strings.at(snapshot.transitionLabels.at(i)));
+    }
+}
+
 void DebugInterfaceClient::Private::statusChanged(const bool haveStateMachine, const bool running)
 {
     Q_UNUSED(haveStateMachine);
@@ -246,12 +371,123 @@ void DebugInterfaceClient::Private::transitionTriggered(TransitionId transitionI
     q->setLastTransition(m_idToTransitionMap.value(transitionId));
 }
 
+void DebugInterfaceClient::Private::eventBatch(const EventBatch &batch)
+{
+    IF_DEBUG(qDebug() << "eventBatch" << batch.events.size() << batch.droppedEvents);
+
+    m_labels += batch.labels;
+    for (const Event &event : batch.events) {
+        switch (event.type) {
+        case Event::MessageEvent:
+            showMessage(event.text);
+            break;
+        case Event::ConfigurationEvent:
+            stateConfigurationUpdated(event.configuration);
+            break;
+        case Event::TransitionEvent:
+            transitionTriggered(event.transition, m_labels.value(event.label));
+            break;
+        }
+    }
+}
+
+void DebugInterfaceClient::Private::recentEvents(const RecentEvents &events)
+{
+    IF_DEBUG(qDebug() << "recentEvents" << events.ids.size() << (events.times.isEmpty() ? 0 : events.now - events.times.first()));
+
+    if (!m_replayPending) {
+        return;
+    }
+    m_replayPending = false;
+
+    if (!events.isValid() || m_awaitingKeyframe) {
+        return;
+    }
+
+    // the events lead to the current configuration, walk back to the one before the first event
+    RuntimeController::Configuration configuration = m_configuration;
+    for (qsizetype i = events.ids.size() - 1; i >= 0; --i) {
+        State *state = m_idToStateMap.value(StateId { events.ids.at(i) });
+        if (events.types.at(i) == RecentEvents::StateEntered) {
+            configuration.remove(state);
+        } else if (events.types.at(i) == RecentEvents::StateExited && state) {
+            configuration.insert(state);
+        }
+    }
+
+    // Replay them step by step, each step exits states, triggers transitions, then enters states.
+    // Only the configuration after the entries of a step is a real one.
+    enum Phase { Exiting, Triggering, Entering };
+    Phase phase = Exiting;
+    bool changed = false;
+    const auto finishStep = [&]() {
+        if (changed) {
+            q->showConfiguration(configuration);
+            changed = false;
+        }
+    };
+
+    QHash<State *, qint64> enteredTimes;
+    q->showConfiguration(configuration);
+    for (qsizetype i = 0; i < events.ids.size(); ++i) {
+        switch (events.types.at(i)) {
+        case RecentEvents::StateExited:
+            if (phase != Exiting) {
+                finishStep();
+                phase = Exiting;
+            }
+            changed = configuration.remove(m_idToStateMap.value(StateId { events.ids.at(i) })) || changed;
+            break;
+        case RecentEvents::TransitionTriggered:
+            if (phase == Entering) {
+                finishStep();
+            }
+            phase = Triggering;
+            q->showTransition(m_idToTransitionMap.value(TransitionId { events.ids.at(i) }));
+            break;
+        case RecentEvents::StateEntered:
+            phase = Entering;
+            if (State *state = m_idToStateMap.value(StateId { events.ids.at(i) })) {
+                configuration.insert(state);
+                enteredTimes.insert(state, events.times.at(i));
+                changed = true;
+            }
+            break;
+        }
+    }
+    finishStep();
+    q->showConfiguration(m_configuration);
+
+    // the active states were entered before this client knew about them
+    const qint64 now = q->statisticsTime();
+    for (auto it = enteredTimes.cbegin(); it != enteredTimes.cend(); ++it) {
+        q->setEnteredTime(it.key(), now - (events.now - it.value()) / 1000000);
+    }
+}
+
+void DebugInterfaceClient::Private::repopulate()
+{
+    m_debugInterface->repopulateGraph();
+    m_debugInterface->requestRecentEvents(m_clientId);
+    // the source may have been restarted, enabling twice is harmless
+    if (m_messagesEnabled) {
+        m_debugInterface->setMessagesEnabled(m_clientId, true);
+    }
+}
+
 void DebugInterfaceClient::Private::clearGraph()
 {
     IF_DEBUG(qDebug());
 
     m_idToStateMap.clear();
     m_idToTransitionMap.clear();
+    m_configuration.clear();
+    m_labels.clear();
+    // the source sends a keyframe after repopulating, and the recent events on request
+    m_awaitingKeyframe = true;
+    m_replayPending = true;
+    // drop pending updates referring to the elements about to be deleted
+    q->clear();
 
     Q_EMIT q->clearGraph();
 }
@@ -259,7 +495,7 @@ void DebugInterfaceClient::Private::clearGraph()
 void DebugInterfaceClient::Private::stateChanged(QRemoteObjectReplica::State state)
 {
     if (state == QRemoteObjectReplica::Valid) {
-        m_debugInterface->repopulateGraph();
+        repopulate();
     } else {
         clearGraph();
     }
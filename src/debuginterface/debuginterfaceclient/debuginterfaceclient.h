@@ -41,6 +41,17 @@ public:
 
     KDSME::StateMachine *machine() const;
 
+    /**
+     * Whether the source sends a message for each state entered and exited
+     *
+     * The request is withdrawn when switching to another debug interface or destroying
+     * the client, other clients of the same source keep getting messages as they asked.
+     *
+     * @note Default is false
+     */
+    bool messagesEnabled() const;
+    void setMessagesEnabled(bool enabled);
+
 Q_SIGNALS:
     void repopulateView();
     void clearGraph();
@@ -0,0 +1,97 @@
+/*
+  This file is part of the KDAB State Machine Editor Library.
+
+  SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company <info@kdab.com>
+
+  SPDX-License-Identifier: LGPL-2.1-only OR LicenseRef-KDAB-KDStateMachineEditor
+
+  Licensees holding valid commercial KDAB State Machine Editor Library
+  licenses may use this file in accordance with the KDAB State Machine Editor
+  Library License Agreement provided with the Software.
+
+  Contact info@kdab.com if any conditions of this licensing are not clear to you.
+*/
+
+#ifndef CONFIGURATIONENCODER_H
+#define CONFIGURATIONENCODER_H
+
+#include "debuginterface_types.h"
+
+#include <QSet>
+
+namespace KDSME {
+namespace DebugInterface {
+
+/**
+ * Turns the configurations of a debug source into numbered ConfigurationUpdate messages
+ *
+ * Every KeyframeInterval updates, and whenever requested, the complete configuration is sent.
+ */
+class ConfigurationEncoder
+{
+public:
+    static constexpr int KeyframeInterval = 64;
+
+    /// Make the next update a keyframe, even if the configuration did not change
+    void requestKeyframe()
+    {
+        m_keyframeRequested = true;
+    }
+
+    bool isKeyframeRequested() const
+    {
+        return m_keyframeRequested;
+    }
+
+    /**
+     * Encode the change from the previous @p configuration into @p update
+     *
+     * @return False in case there is nothing to send
+     */
+    bool encode(const QSet<quint64> &configuration, ConfigurationUpdate *update)
+    {
+        const bool keyframe = m_keyframeRequested || m_sinceKeyframe >= KeyframeInterval;
+        if (!keyframe && configuration == m_configuration) {
+            return false;
+        }
+
+        update->sequence = m_sequence++;
+        update->keyframe = keyframe;
+        update->entered.clear();
+        update->exited.clear();
+        if (keyframe) {
+            update->entered.reserve(configuration.size());
+            for (quint64 id : configuration) {
+                update->entered << StateId { id };
+            }
+            m_sinceKeyframe = 0;
+            m_keyframeRequested = false;
+        } else {
+            for (quint64 id : configuration) {
+                if (!m_configuration.contains(id)) {
+                    update->entered << StateId { id };
+                }
+            }
+            for (quint64 id : std::as_const(m_configuration)) {
+                if (!configuration.contains(id)) {
+                    update->exited << StateId { id };
+                }
+            }
+            ++m_sinceKeyframe;
+        }
+
+        m_configuration = configuration;
+        return true;
+    }
+
+private:
+    QSet<quint64> m_configuration;
+    quint64 m_sequence = 0;
+    int m_sinceKeyframe = 0;
+    bool m_keyframeRequested = true;
+};
+
+}
+}
+
+#endif // CONFIGURATIONENCODER_H
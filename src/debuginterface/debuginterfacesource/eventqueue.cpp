@@ -0,0 +1,135 @@
+/*
+  This file is part of the KDAB State Machine Editor Library.
+
+  SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company <info@kdab.com>
+
+  SPDX-License-Identifier: LGPL-2.1-only OR LicenseRef-KDAB-KDStateMachineEditor
+
+  Licensees holding valid commercial KDAB State Machine Editor Library
+  licenses may use this file in accordance with the KDAB State Machine Editor
+  Library License Agreement provided with the Software.
+
+  Contact info@kdab.com if any conditions of this licensing are not clear to you.
+*/
+
+#include "eventqueue_p.h"
+
+#include <utility>
+
+using namespace KDSME::DebugInterface;
+
+namespace {
+
+const int DEFAULT_INTERVAL = 20;
+const int DEFAULT_CAPACITY = 4096;
+
+}
+
+EventQueue::EventQueue(QObject *parent)
+    : QObject(parent)
+    , m_capacity(DEFAULT_CAPACITY)
+{
+    m_timer.setSingleShot(true);
+    m_timer.setInterval(DEFAULT_INTERVAL);
+    connect(&m_timer, &QTimer::timeout, this, &EventQueue::flush);
+}
+
+EventQueue::~EventQueue()
+{
+}
+
+int EventQueue::interval() const
+{
+    return m_timer.interval();
+}
+
+void EventQueue::setInterval(int msecs)
+{
+    m_timer.setInterval(qMax(msecs, 0));
+}
+
+int EventQueue::capacity() const
+{
+    return m_capacity;
+}
+
+void EventQueue::setCapacity(int capacity)
+{
+    m_capacity = qMax(capacity, 1);
+    while (m_events.size() > m_capacity) {
+        drop(0);
+    }
+}
+
+EventQueue::OverflowPolicy EventQueue::overflowPolicy() const
+{
+    return m_overflowPolicy;
+}
+
+void EventQueue::setOverflowPolicy(OverflowPolicy policy)
+{
+    m_overflowPolicy = policy;
+}
+
+quint64 EventQueue::droppedEventCount() const
+{
+    return m_droppedEvents;
+}
+
+void EventQueue::enqueue(const Event &event)
+{
+    if (m_events.size() >= m_capacity && m_overflowPolicy == Aggregate && !m_aggregating) {
+        for (qsizetype i = m_events.size() - 1; i >= 0; --i) {
+            if (m_events.at(i).type != Event::TransitionEvent) {
+                drop(i);
+            }
+        }
+
+        m_aggregating = true;
+        Q_EMIT keyframeNeeded();
+        m_aggregating = false;
+
+        // already covered by the keyframe
+        if (event.type == Event::ConfigurationEvent && !event.configuration.keyframe) {
+            ++m_droppedEvents;
+            ++m_droppedSinceBatch;
+            return;
+        }
+    }
+
+    while (m_events.size() >= m_capacity) {
+        drop(0);
+    }
+
+    m_events.append(event);
+    if (!m_timer.isActive()) {
+        m_timer.start();
+    }
+}
+
+void EventQueue::resetLabels()
+{
+    m_labelIndices.clear();
+    m_newLabels.clear();
+}
+
+void EventQueue::flush()
+{
+    m_timer.stop();
+    if (m_events.isEmpty() && m_newLabels.isEmpty() && m_droppedSinceBatch == 0) {
+        return;
+    }
+
+    EventBatch batch;
+    batch.events = std::exchange(m_events, {});
+    batch.labels = std::exchange(m_newLabels, {});
+    batch.droppedEvents = std::exchange(m_droppedSinceBatch, 0);
+    Q_EMIT batchReady(batch);
+}
+
+void EventQueue::drop(qsizetype index)
+{
+    m_events.removeAt(index);
+    ++m_droppedEvents;
+    ++m_droppedSinceBatch;
+}
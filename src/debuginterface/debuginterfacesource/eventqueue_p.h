@@ -0,0 +1,118 @@
+/*
+  This file is part of the KDAB State Machine Editor Library.
+
+  SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company <info@kdab.com>
+
+  SPDX-License-Identifier: LGPL-2.1-only OR LicenseRef-KDAB-KDStateMachineEditor
+
+  Licensees holding valid commercial KDAB State Machine Editor Library
+  licenses may use this file in accordance with the KDAB State Machine Editor
+  Library License Agreement provided with the Software.
+
+  Contact info@kdab.com if any conditions of this licensing are not clear to you.
+*/
+
+#ifndef EVENTQUEUE_H
+#define EVENTQUEUE_H
+
+#include "debuginterface_types.h"
+
+#include <QHash>
+#include <QObject>
+#include <QTimer>
+
+namespace KDSME {
+namespace DebugInterface {
+
+/**
+ * Bounded queue of the runtime events of a debug source, sent in batches
+ *
+ * Events are collected for at most interval() milliseconds, so the instrumented application
+ * never waits for the remote connection per event. Once capacity() events are queued, events
+ * get dropped according to overflowPolicy().
+ *
+ * The queue also keeps the label table of the batches, see EventBatch.
+ */
+class EventQueue : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum OverflowPolicy
+    {
+        /// Drop the oldest event
+        DropOldest,
+        /**
+         * Drop queued messages and configuration updates, and request a keyframe through
+         * keyframeNeeded() which replaces the configuration updates
+         */
+        Aggregate
+    };
+
+    explicit EventQueue(QObject *parent = nullptr);
+    ~EventQueue();
+
+    int interval() const;
+    void setInterval(int msecs);
+
+    int capacity() const;
+    void setCapacity(int capacity);
+
+    OverflowPolicy overflowPolicy() const;
+    void setOverflowPolicy(OverflowPolicy policy);
+
+    /// Number of events dropped since the creation of the queue
+    quint64 droppedEventCount() const;
+
+    void enqueue(const Event &event);
+
+    /**
+     * @return The index of the label of the element with the given @p id in the label table
+     *
+     * The label is created by calling @p format, only the first time it is needed.
+     */
+    template<typename Format>
+    quint32 labelIndex(quint64 id, Format format)
+    {
+        const auto it = m_labelIndices.constFind(id);
+        if (it != m_labelIndices.constEnd()) {
+            return *it;
+        }
+
+        const auto index = static_cast<quint32>(m_labelIndices.size());
+        m_labelIndices.insert(id, index);
+        m_newLabels << format();
+        return index;
+    }
+
+    /// Start a new label table, call after flushing the events referring to the old one
+    void resetLabels();
+
+public Q_SLOTS:
+    /// Send the queued events right away
+    void flush();
+
+Q_SIGNALS:
+    void batchReady(const KDSME::DebugInterface::EventBatch &batch);
+    /// Emitted by the Aggregate policy, the receiver is expected to enqueue a keyframe
+    void keyframeNeeded();
+
+private:
+    void drop(qsizetype index);
+
+    QTimer m_timer;
+    QList<Event> m_events;
+    QHash<quint64, quint32> m_labelIndices;
+    /// Labels not sent yet
+    QStringList m_newLabels;
+    int m_capacity;
+    OverflowPolicy m_overflowPolicy = DropOldest;
+    quint64 m_droppedEvents = 0;
+    quint64 m_droppedSinceBatch = 0;
+    bool m_aggregating = false;
+};
+
+}
+}
+
+#endif // EVENTQUEUE_H
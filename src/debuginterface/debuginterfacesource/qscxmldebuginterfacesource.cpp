@@ -19,6 +19,10 @@
 
 #include "rep_debuginterface_source.h"
 
+#include "configurationencoder_p.h"
+#include "eventqueue_p.h"
+#include "recenteventring_p.h"
+
 #include "objecthelper.h"
 
 #include <QScxmlStateMachine>
@@ -57,6 +61,30 @@ StateType makeStateType(QScxmlStateMachineInfo::StateType stateType)
     return OtherState;
 }
 
+EventQueue::OverflowPolicy toQueuePolicy(QScxmlDebugInterfaceSource::OverflowPolicy policy)
+{
+    switch (policy) {
+    case QScxmlDebugInterfaceSource::DropOldest:
+        return EventQueue::DropOldest;
+    case QScxmlDebugInterfaceSource::Aggregate:
+        return EventQueue::Aggregate;
+    }
+    Q_UNREACHABLE();
+    return EventQueue::DropOldest;
+}
+
+QScxmlDebugInterfaceSource::OverflowPolicy fromQueuePolicy(EventQueue::OverflowPolicy policy)
+{
+    switch (policy) {
+    case EventQueue::DropOldest:
+        return QScxmlDebugInterfaceSource::DropOldest;
+    case EventQueue::Aggregate:
+        return QScxmlDebugInterfaceSource::Aggregate;
+    }
+    Q_UNREACHABLE();
+    return QScxmlDebugInterfaceSource::DropOldest;
+}
+
 }
 
 class QScxmlDebugInterfaceSource::Private : public DebugInterfaceSource
@@ -69,6 +97,8 @@ public:
     QScxmlStateMachine *qScxmlStateMachine() const;
     void setQScxmlStateMachine(QScxmlStateMachine *machine);
 
+    EventQueue *m_eventQueue;
+
 private Q_SLOTS:
     void stateEntered(QScxmlStateMachineInfo::StateId state);
     void stateExited(QScxmlStateMachineInfo::StateId state);
@@ -79,10 +109,14 @@ private Q_SLOTS:
     void toggleRunning();
 
     void repopulateGraph() override;
+    void requestConfigurationKeyframe() override;
+    void setMessagesEnabled(quint64 client, bool enabled) override;
+    void requestRecentEvents(quint64 request) override;
 
 private:
-    void addState(QScxmlStateMachineInfo::StateId state);
-    void addTransition(QScxmlStateMachineInfo::TransitionId transition);
+    void enqueueMessage(const QString &message);
+    void addState(QScxmlStateMachineInfo::StateId state, GraphSnapshot &snapshot);
+    void addTransition(QScxmlStateMachineInfo::TransitionId transition, GraphSnapshot &snapshot);
 
     QString labelForState(QScxmlStateMachineInfo::StateId state) const
     {
@@ -113,6 +147,10 @@ private:
     QSet<QScxmlStateMachineInfo::StateId> m_recursionGuard;
     QSet<QScxmlStateMachineInfo::TransitionId> m_recursionGuardForTransition;
     QVector<QScxmlStateMachineInfo::StateId> m_lastStateConfig;
+    ConfigurationEncoder m_configurationEncoder;
+    /// Clients which asked for messages, see DebugInterfaceClient::setMessagesEnabled()
+    QSet<quint64> m_messageClients;
+    RecentEventRing m_recentEvents;
 };
 
 QScxmlDebugInterfaceSource::QScxmlDebugInterfaceSource()
@@ -139,41 +177,96 @@ QObject *QScxmlDebugInterfaceSource::remoteObjectSource() const
     return d.data();
 }
 
+int QScxmlDebugInterfaceSource::batchInterval() const
+{
+    return d->m_eventQueue->interval();
+}
+
+void QScxmlDebugInterfaceSource::setBatchInterval(int msecs)
+{
+    d->m_eventQueue->setInterval(msecs);
+}
+
+int QScxmlDebugInterfaceSource::maximumQueueSize() const
+{
+    return d->m_eventQueue->capacity();
+}
+
+void QScxmlDebugInterfaceSource::setMaximumQueueSize(int size)
+{
+    d->m_eventQueue->setCapacity(size);
+}
+
+QScxmlDebugInterfaceSource::OverflowPolicy QScxmlDebugInterfaceSource::overflowPolicy() const
+{
+    return fromQueuePolicy(d->m_eventQueue->overflowPolicy());
+}
+
+void QScxmlDebugInterfaceSource::setOverflowPolicy(OverflowPolicy policy)
+{
+    d->m_eventQueue->setOverflowPolicy(toQueuePolicy(policy));
+}
+
+quint64 QScxmlDebugInterfaceSource::droppedEventCount() const
+{
+    return d->m_eventQueue->droppedEventCount();
+}
+
 QScxmlDebugInterfaceSource::Private::Private(QObject *parent)
     : DebugInterfaceSource(parent)
+    , m_eventQueue(new EventQueue(this))
 {
     DebugInterface::registerTypes();
 
+    connect(m_eventQueue, &EventQueue::batchReady, this, &DebugInterfaceSource::eventBatch);
+    connect(m_eventQueue, &EventQueue::keyframeNeeded, this, &Private::requestConfigurationKeyframe);
+
     updateStartStop();
 }
 
 void QScxmlDebugInterfaceSource::Private::repopulateGraph()
 {
+    // events refer to the graph about to be replaced
+    m_eventQueue->flush();
+    m_eventQueue->resetLabels();
+
     Q_EMIT aboutToRepopulateGraph();
 
     updateStartStop();
 
+    GraphSnapshot snapshot;
     if (m_info) {
+        const auto states = m_info->allStates();
+        const auto transitions = m_info->allTransitions();
+        snapshot.stateIds.reserve(states.size() + 1);
+        snapshot.transitionIds.reserve(transitions.size());
+
         // root state is not part of 'allStates', add it manually
-        addState(QScxmlStateMachineInfo::InvalidStateId);
+        addState(QScxmlStateMachineInfo::InvalidStateId, snapshot);
 
-        const auto states = m_info->allStates();
         for (auto stateId : states) {
-            addState(stateId);
+            addState(stateId, snapshot);
         }
 
-        const auto transitions = m_info->allTransitions();
         for (auto transition : transitions) {
-            addTransition(transition);
+            addTransition(transition, snapshot);
         }
 
         m_recursionGuard.clear();
         m_recursionGuardForTransition.clear();
     }
+    Q_EMIT graphSnapshot(snapshot);
 
     Q_EMIT graphRepopulated();
 
     // make sure to pass the current config to the listener
+    requestConfigurationKeyframe();
+    m_eventQueue->flush();
+}
+
+void QScxmlDebugInterfaceSource::Private::requestConfigurationKeyframe()
+{
+    m_configurationEncoder.requestKeyframe();
     handleStateConfigurationChanged();
 }
 
@@ -187,6 +280,7 @@ void QScxmlDebugInterfaceSource::Private::setQScxmlStateMachine(QScxmlStateMachi
     repopulateGraph();
 
     m_info.reset();
+    m_recentEvents.clear();
 
     handleStateConfigurationChanged();
 
@@ -196,6 +290,9 @@ void QScxmlDebugInterfaceSource::Private::setQScxmlStateMachine(QScxmlStateMachi
     if (m_info) {
         connect(m_info.data(), &QScxmlStateMachineInfo::statesEntered, this,
                 [this](const QVector<QScxmlStateMachineInfo::StateId> &states) {
+                    for (auto state : states) {
+                        m_recentEvents.record(RecentEvents::StateEntered, makeStateId(state));
+                    }
                     // TODO: Don't just use the first
                     if (!states.isEmpty()) {
                         stateEntered(states.first());
@@ -203,6 +300,9 @@ void QScxmlDebugInterfaceSource::Private::setQScxmlStateMachine(QScxmlStateMachi
                 });
         connect(m_info.data(), &QScxmlStateMachineInfo::statesExited, this,
                 [this](const QVector<QScxmlStateMachineInfo::StateId> &states) {
+                    for (auto state : states) {
+                        m_recentEvents.record(RecentEvents::StateExited, makeStateId(state));
+                    }
                     // TODO: Don't just use the first
                     if (!states.isEmpty()) {
                         stateExited(states.first());
@@ -210,6 +310,9 @@ void QScxmlDebugInterfaceSource::Private::setQScxmlStateMachine(QScxmlStateMachi
                 });
         connect(m_info.data(), &QScxmlStateMachineInfo::transitionsTriggered,
                 this, [this](const QVector<QScxmlStateMachineInfo::TransitionId> &transitions) {
+                    for (auto transition : transitions) {
+                        m_recentEvents.record(RecentEvents::TransitionTriggered, makeTransitionId(transition));
+                    }
                     // TODO: Don't just use the first
                     if (!transitions.isEmpty()) {
                         handleTransitionTriggered(transitions.first());
@@ -222,18 +325,45 @@ void QScxmlDebugInterfaceSource::Private::setQScxmlStateMachine(QScxmlStateMachi
 
 void QScxmlDebugInterfaceSource::Private::handleTransitionTriggered(QScxmlStateMachineInfo::TransitionId transition)
 {
-    Q_EMIT transitionTriggered(makeTransitionId(transition), labelForTransition(transition));
+    Event event;
+    event.type = Event::TransitionEvent;
+    event.transition = makeTransitionId(transition);
+    event.label = m_eventQueue->labelIndex(event.transition, [transition, this]() { return labelForTransition(transition); });
+    m_eventQueue->enqueue(event);
+}
+
+void QScxmlDebugInterfaceSource::Private::setMessagesEnabled(quint64 client, bool enabled)
+{
+    if (enabled) {
+        m_messageClients.insert(client);
+    } else {
+        m_messageClients.remove(client);
+    }
+}
+
+void QScxmlDebugInterfaceSource::Private::requestRecentEvents(quint64 request)
+{
+    // the events have to lead to the configuration the clients know about
+    m_eventQueue->flush();
+
+    RecentEvents events = m_recentEvents.snapshot();
+    events.request = request;
+    Q_EMIT recentEvents(events);
 }
 
 void QScxmlDebugInterfaceSource::Private::stateEntered(QScxmlStateMachineInfo::StateId state)
 {
-    Q_EMIT message(tr("State entered: %1").arg(labelForState(state)));
+    if (!m_messageClients.isEmpty()) {
+        enqueueMessage(tr("State entered: %1").arg(labelForState(state)));
+    }
     handleStateConfigurationChanged();
 }
 
 void QScxmlDebugInterfaceSource::Private::stateExited(QScxmlStateMachineInfo::StateId state)
 {
-    Q_EMIT message(tr("State exited: %1").arg(labelForState(state)));
+    if (!m_messageClients.isEmpty()) {
+        enqueueMessage(tr("State exited: %1").arg(labelForState(state)));
+    }
     handleStateConfigurationChanged();
 }
 
@@ -244,21 +374,25 @@ void QScxmlDebugInterfaceSource::Private::handleStateConfigurationChanged()
         newConfig = m_info->configuration();
     }
 
-    if (newConfig == m_lastStateConfig) {
+    if (newConfig == m_lastStateConfig && !m_configurationEncoder.isKeyframeRequested()) {
         return;
     }
     m_lastStateConfig = newConfig;
 
-    StateMachineConfiguration config;
+    QSet<quint64> config;
     config.reserve(newConfig.size());
     for (auto state : std::as_const(newConfig)) {
-        config << makeStateId(state);
+        config.insert(makeStateId(state));
     }
 
-    Q_EMIT stateConfigurationChanged(config);
+    Event event;
+    event.type = Event::ConfigurationEvent;
+    if (m_configurationEncoder.encode(config, &event.configuration)) {
+        m_eventQueue->enqueue(event);
+    }
 }
 
-void QScxmlDebugInterfaceSource::Private::addState(QScxmlStateMachineInfo::StateId state)
+void QScxmlDebugInterfaceSource::Private::addState(QScxmlStateMachineInfo::StateId state, GraphSnapshot &snapshot)
 {
     if (m_recursionGuard.contains(state)) {
         return;
@@ -267,7 +401,7 @@ void QScxmlDebugInterfaceSource::Private::addState(QScxmlStateMachineInfo::State
     m_recursionGuard.insert(state);
 
     auto parentState = m_info->stateParent(state);
-    addState(parentState); // be sure that parent is added first
+    addState(parentState, snapshot); // be sure that parent is added first
 
     const auto children = m_info->stateChildren(state);
     const bool hasChildren = !children.isEmpty();
@@ -283,17 +417,17 @@ void QScxmlDebugInterfaceSource::Private::addState(QScxmlStateMachineInfo::State
     Q_ASSERT(parentInitialTransitionTargets.size() <= 1); // assume there can only be at most one 'initial state'
     const auto parentInitialState = parentInitialTransitionTargets.value(0);
     const bool connectToInitial = parentInitialState == state; // TODO ?
-    Q_EMIT stateAdded(makeStateId(state), makeStateId(parentState),
+    snapshot.addState(makeStateId(state), makeStateId(parentState),
                       hasChildren, labelForState(state),
                       makeStateType(m_info->stateType(state)), connectToInitial);
 
     // add sub-states
-    Q_FOREACH (int child, m_info->stateChildren(state)) {
-        addState(child);
+    for (int child : children) {
+        addState(child, snapshot);
     }
 }
 
-void QScxmlDebugInterfaceSource::Private::addTransition(QScxmlStateMachineInfo::TransitionId transition)
+void QScxmlDebugInterfaceSource::Private::addTransition(QScxmlStateMachineInfo::TransitionId transition, GraphSnapshot &snapshot)
 {
     if (m_recursionGuardForTransition.contains(transition)) {
         return;
@@ -303,17 +437,26 @@ void QScxmlDebugInterfaceSource::Private::addTransition(QScxmlStateMachineInfo::
 
     const auto sourceState = m_info->transitionSource(transition);
     const auto targetStates = m_info->transitionTargets(transition);
-    addState(sourceState);
+    addState(sourceState, snapshot);
     for (int targetState : targetStates) {
-        addState(targetState);
+        addState(targetState, snapshot);
     }
 
+    const QString label = labelForTransition(transition);
     for (int targetState : targetStates) {
-        Q_EMIT transitionAdded(makeTransitionId(transition), makeStateId(sourceState),
-                               makeStateId(targetState), labelForTransition(transition));
+        snapshot.addTransition(makeTransitionId(transition), makeStateId(sourceState),
+                               makeStateId(targetState), label);
     }
 }
 
+void QScxmlDebugInterfaceSource::Private::enqueueMessage(const QString &message)
+{
+    Event event;
+    event.type = Event::MessageEvent;
+    event.text = message;
+    m_eventQueue->enqueue(event);
+}
+
 void QScxmlDebugInterfaceSource::Private::updateStartStop()
 {
     Q_EMIT statusChanged(qScxmlStateMachine() != nullptr, qScxmlStateMachine() && qScxmlStateMachine()->isRunning());
@@ -19,6 +19,10 @@
 
 #include "rep_debuginterface_source.h"
 
+#include "configurationencoder_p.h"
+#include "eventqueue_p.h"
+#include "recenteventring_p.h"
+
 #include "qsmwatcher_p.h"
 
 #include "objecthelper.h"
@@ -44,6 +48,18 @@ TransitionId makeTransitionId(QAbstractTransition *transition)
     return TransitionId { reinterpret_cast<quint64>(transition) };
 }
 
+StateType stateType(QAbstractState *state)
+{
+    if (qobject_cast<QFinalState *>(state)) {
+        return FinalState;
+    } else if (auto historyState = qobject_cast<QHistoryState *>(state)) {
+        return historyState->historyType() == QHistoryState::ShallowHistory ? ShallowHistoryState : DeepHistoryState;
+    } else if (qobject_cast<QStateMachine *>(state)) {
+        return StateMachineState;
+    }
+    return OtherState;
+}
+
 QString labelForTransition(QAbstractTransition *transition)
 {
     const QString objectName = transition->objectName();
@@ -60,6 +76,30 @@ QString labelForTransition(QAbstractTransition *transition)
     return ObjectHelper::displayString(transition);
 }
 
+EventQueue::OverflowPolicy toQueuePolicy(QsmDebugInterfaceSource::OverflowPolicy policy)
+{
+    switch (policy) {
+    case QsmDebugInterfaceSource::DropOldest:
+        return EventQueue::DropOldest;
+    case QsmDebugInterfaceSource::Aggregate:
+        return EventQueue::Aggregate;
+    }
+    Q_UNREACHABLE();
+    return EventQueue::DropOldest;
+}
+
+QsmDebugInterfaceSource::OverflowPolicy fromQueuePolicy(EventQueue::OverflowPolicy policy)
+{
+    switch (policy) {
+    case EventQueue::DropOldest:
+        return QsmDebugInterfaceSource::DropOldest;
+    case EventQueue::Aggregate:
+        return QsmDebugInterfaceSource::Aggregate;
+    }
+    Q_UNREACHABLE();
+    return QsmDebugInterfaceSource::DropOldest;
+}
+
 }
 
 class QsmDebugInterfaceSource::Private : public DebugInterfaceSource
@@ -69,31 +109,52 @@ class QsmDebugInterfaceSource::Private : public DebugInterfaceSource
 public:
     explicit Private(QObject *parent = nullptr);
 
-    void addState(QAbstractState *state);
-    void addTransition(QAbstractTransition *transition);
+    void addState(QAbstractState *state, GraphSnapshot &snapshot);
+    void addTransition(QAbstractTransition *transition, GraphSnapshot &snapshot);
 
     QStateMachine *qStateMachine() const;
     void setQStateMachine(QStateMachine *machine);
 
+    EventQueue *m_eventQueue;
+
 private Q_SLOTS:
     void stateEntered(QAbstractState *state);
     void stateExited(QAbstractState *state);
     void handleStateConfigurationChanged();
     void handleTransitionTriggered(QAbstractTransition *);
+    void handleStateAdded(QAbstractState *state);
+    void handleTransitionAdded(QAbstractTransition *transition);
+    void updateConfiguration();
 
     void updateStartStop();
     void toggleRunning();
 
     void repopulateGraph() override;
+    void requestConfigurationKeyframe() override;
+    void setMessagesEnabled(quint64 client, bool enabled) override;
+    void requestRecentEvents(quint64 request) override;
 
 private:
     void updateStateItems();
+    void enqueueMessage(const QString &message);
+    /// Update the configuration once control returns to the event loop
+    void scheduleConfigurationUpdate();
+    /// Publish the configuration reached by the previous step, if states were entered since it ended
+    void finishStep(QAbstractState *exitedState);
+    void publishConfiguration(const QSet<QAbstractState *> &newConfig);
 
     bool mayAddState(QAbstractState *state);
 
     QSMWatcher *m_stateMachineWatcher;
     QSet<QAbstractState *> m_recursionGuard;
     QSet<QAbstractState *> m_lastStateConfig;
+    ConfigurationEncoder m_configurationEncoder;
+    bool m_configurationUpdateScheduled = false;
+    /// Whether states were entered since the last exit or triggered transition
+    bool m_enteringStates = false;
+    /// Clients which asked for messages, see DebugInterfaceClient::setMessagesEnabled()
+    QSet<quint64> m_messageClients;
+    RecentEventRing m_recentEvents;
 };
 
 QsmDebugInterfaceSource::QsmDebugInterfaceSource()
@@ -120,34 +181,88 @@ QObject *QsmDebugInterfaceSource::remoteObjectSource() const
     return d.data();
 }
 
+int QsmDebugInterfaceSource::batchInterval() const
+{
+    return d->m_eventQueue->interval();
+}
+
+void QsmDebugInterfaceSource::setBatchInterval(int msecs)
+{
+    d->m_eventQueue->setInterval(msecs);
+}
+
+int QsmDebugInterfaceSource::maximumQueueSize() const
+{
+    return d->m_eventQueue->capacity();
+}
+
+void QsmDebugInterfaceSource::setMaximumQueueSize(int size)
+{
+    d->m_eventQueue->setCapacity(size);
+}
+
+QsmDebugInterfaceSource::OverflowPolicy QsmDebugInterfaceSource::overflowPolicy() const
+{
+    return fromQueuePolicy(d->m_eventQueue->overflowPolicy());
+}
+
+void QsmDebugInterfaceSource::setOverflowPolicy(OverflowPolicy policy)
+{
+    d->m_eventQueue->setOverflowPolicy(toQueuePolicy(policy));
+}
+
+quint64 QsmDebugInterfaceSource::droppedEventCount() const
+{
+    return d->m_eventQueue->droppedEventCount();
+}
+
 QsmDebugInterfaceSource::Private::Private(QObject *parent)
     : DebugInterfaceSource(parent)
+    , m_eventQueue(new EventQueue(this))
     , m_stateMachineWatcher(new QSMWatcher(this))
 {
     DebugInterface::registerTypes();
 
+    connect(m_eventQueue, &EventQueue::batchReady, this, &DebugInterfaceSource::eventBatch);
+    connect(m_eventQueue, &EventQueue::keyframeNeeded, this, &Private::requestConfigurationKeyframe);
+
     connect(m_stateMachineWatcher, SIGNAL(stateEntered(QAbstractState *)),
             SLOT(stateEntered(QAbstractState *)));
     connect(m_stateMachineWatcher, SIGNAL(stateExited(QAbstractState *)),
             SLOT(stateExited(QAbstractState *)));
     connect(m_stateMachineWatcher, SIGNAL(transitionTriggered(QAbstractTransition *)),
             SLOT(handleTransitionTriggered(QAbstractTransition *)));
+    connect(m_stateMachineWatcher, &QSMWatcher::stateAdded, this, &Private::handleStateAdded);
+    connect(m_stateMachineWatcher, &QSMWatcher::transitionAdded, this, &Private::handleTransitionAdded);
 
     updateStartStop();
 }
 
 void QsmDebugInterfaceSource::Private::repopulateGraph()
 {
+    // events refer to the graph about to be replaced
+    m_eventQueue->flush();
+    m_eventQueue->resetLabels();
+
     Q_EMIT aboutToRepopulateGraph();
 
     updateStartStop();
 
-    addState(qStateMachine());
+    GraphSnapshot snapshot;
+    addState(qStateMachine(), snapshot);
     m_recursionGuard.clear();
+    Q_EMIT graphSnapshot(snapshot);
 
     Q_EMIT graphRepopulated();
 
     // make sure to pass the current config to the listener
+    requestConfigurationKeyframe();
+    m_eventQueue->flush();
+}
+
+void QsmDebugInterfaceSource::Private::requestConfigurationKeyframe()
+{
+    m_configurationEncoder.requestKeyframe();
     handleStateConfigurationChanged();
 }
 
@@ -179,6 +294,8 @@ void QsmDebugInterfaceSource::Private::setQStateMachine(QStateMachine *machine)
 
     // m_stateModel->setStateMachine(machine);
     handleStateConfigurationChanged();
+    m_recentEvents.clear();
+    m_enteringStates = false;
 
     m_stateMachineWatcher->setWatchedStateMachine(machine);
     repopulateGraph();
@@ -193,18 +310,110 @@ void QsmDebugInterfaceSource::Private::setQStateMachine(QStateMachine *machine)
 
 void QsmDebugInterfaceSource::Private::handleTransitionTriggered(QAbstractTransition *transition)
 {
-    Q_EMIT transitionTriggered(makeTransitionId(transition), ObjectHelper::displayString(transition));
+    // a transition without exits, e.g. a targetless one, starts the next step as well
+    finishStep(nullptr);
+
+    m_recentEvents.record(RecentEvents::TransitionTriggered, makeTransitionId(transition));
+
+    Event event;
+    event.type = Event::TransitionEvent;
+    event.transition = makeTransitionId(transition);
+    event.label = m_eventQueue->labelIndex(event.transition, [transition]() { return ObjectHelper::displayString(transition); });
+    m_eventQueue->enqueue(event);
+}
+
+void QsmDebugInterfaceSource::Private::handleStateAdded(QAbstractState *state)
+{
+    // a single addition is cheap enough to be sent on its own
+    QState *parentState = state->parentState();
+    Q_EMIT stateAdded(makeStateId(state), makeStateId(parentState),
+                      state->findChild<QAbstractState *>() != nullptr, ObjectHelper::displayString(state),
+                      stateType(state), parentState && parentState->initialState() == state);
+}
+
+void QsmDebugInterfaceSource::Private::handleTransitionAdded(QAbstractTransition *transition)
+{
+    Q_EMIT transitionAdded(makeTransitionId(transition), makeStateId(transition->sourceState()),
+                           makeStateId(transition->targetState()), labelForTransition(transition));
+}
+
+void QsmDebugInterfaceSource::Private::setMessagesEnabled(quint64 client, bool enabled)
+{
+    if (enabled) {
+        m_messageClients.insert(client);
+    } else {
+        m_messageClients.remove(client);
+    }
+}
+
+void QsmDebugInterfaceSource::Private::requestRecentEvents(quint64 request)
+{
+    // the events have to lead to the configuration the clients know about
+    if (m_configurationUpdateScheduled) {
+        updateConfiguration();
+    }
+    m_eventQueue->flush();
+
+    RecentEvents events = m_recentEvents.snapshot();
+    events.request = request;
+    Q_EMIT recentEvents(events);
 }
 
 void QsmDebugInterfaceSource::Private::stateEntered(QAbstractState *state)
 {
-    Q_EMIT message(tr("State entered: %1").arg(ObjectHelper::displayString(state)));
-    handleStateConfigurationChanged();
+    m_recentEvents.record(RecentEvents::StateEntered, makeStateId(state));
+    if (!m_messageClients.isEmpty()) {
+        enqueueMessage(tr("State entered: %1").arg(ObjectHelper::displayString(state)));
+    }
+    m_enteringStates = true;
+    scheduleConfigurationUpdate();
 }
 
 void QsmDebugInterfaceSource::Private::stateExited(QAbstractState *state)
 {
-    Q_EMIT message(tr("State exited: %1").arg(ObjectHelper::displayString(state)));
+    finishStep(state);
+
+    m_recentEvents.record(RecentEvents::StateExited, makeStateId(state));
+    if (!m_messageClients.isEmpty()) {
+        enqueueMessage(tr("State exited: %1").arg(ObjectHelper::displayString(state)));
+    }
+    scheduleConfigurationUpdate();
+}
+
+void QsmDebugInterfaceSource::Private::scheduleConfigurationUpdate()
+{
+    if (m_configurationUpdateScheduled) {
+        return;
+    }
+
+    // QStateMachine processes all events queued so far in one go, the configurations
+    // between the steps are published by finishStep(), this one takes the last step
+    m_configurationUpdateScheduled = true;
+    QMetaObject::invokeMethod(this, &Private::updateConfiguration, Qt::QueuedConnection);
+}
+
+void QsmDebugInterfaceSource::Private::finishStep(QAbstractState *exitedState)
+{
+    if (!m_enteringStates) {
+        return;
+    }
+    m_enteringStates = false;
+
+    // Each step exits states, triggers transitions, then enters states. QStateMachine removes
+    // a state from its configuration right before announcing its exit, hence add it back.
+    QSet<QAbstractState *> config;
+    if (qStateMachine()) {
+        config = qStateMachine()->configuration();
+    }
+    if (exitedState) {
+        config.insert(exitedState);
+    }
+    publishConfiguration(config);
+}
+
+void QsmDebugInterfaceSource::Private::updateConfiguration()
+{
+    m_configurationUpdateScheduled = false;
     handleStateConfigurationChanged();
 }
 
@@ -214,22 +423,30 @@ void QsmDebugInterfaceSource::Private::handleStateConfigurationChanged()
     if (qStateMachine()) {
         newConfig = qStateMachine()->configuration();
     }
+    publishConfiguration(newConfig);
+}
 
-    if (newConfig == m_lastStateConfig) {
+void QsmDebugInterfaceSource::Private::publishConfiguration(const QSet<QAbstractState *> &newConfig)
+{
+    if (newConfig == m_lastStateConfig && !m_configurationEncoder.isKeyframeRequested()) {
         return;
     }
     m_lastStateConfig = newConfig;
 
-    StateMachineConfiguration config;
+    QSet<quint64> config;
     config.reserve(newConfig.size());
     for (QAbstractState *state : std::as_const(newConfig)) {
-        config << makeStateId(state);
+        config.insert(makeStateId(state));
     }
 
-    Q_EMIT stateConfigurationChanged(config);
+    Event event;
+    event.type = Event::ConfigurationEvent;
+    if (m_configurationEncoder.encode(config, &event.configuration)) {
+        m_eventQueue->enqueue(event);
+    }
 }
 
-void QsmDebugInterfaceSource::Private::addState(QAbstractState *state)
+void QsmDebugInterfaceSource::Private::addState(QAbstractState *state, GraphSnapshot &snapshot)
 {
     if (!state)
         return;
@@ -243,7 +460,7 @@ void QsmDebugInterfaceSource::Private::addState(QAbstractState *state)
 
     QState *parentState = state->parentState();
     if (parentState) {
-        addState(parentState); // be sure that parent is added first
+        addState(parentState, snapshot); // be sure that parent is added first
     }
 
     const bool hasChildren = state->findChild<QAbstractState *>();
@@ -251,41 +468,40 @@ void QsmDebugInterfaceSource::Private::addState(QAbstractState *state)
     // add a connection from parent state to initial state if
     // parent state is valid and parent state has an initial state
     const bool connectToInitial = parentState && parentState->initialState() == state;
-    StateType type = OtherState;
-    if (qobject_cast<QFinalState *>(state)) {
-        type = FinalState;
-    } else if (auto historyState = qobject_cast<QHistoryState *>(state)) {
-        type = historyState->historyType() == QHistoryState::ShallowHistory ? ShallowHistoryState : DeepHistoryState;
-    } else if (qobject_cast<QStateMachine *>(state)) {
-        type = StateMachineState;
-    }
-
-    Q_EMIT stateAdded(makeStateId(state), makeStateId(parentState),
-                      hasChildren, label, type, connectToInitial);
+    snapshot.addState(makeStateId(state), makeStateId(parentState),
+                      hasChildren, label, stateType(state), connectToInitial);
 
     // add outgoing transitions
     Q_FOREACH (auto transition, state->findChildren<QAbstractTransition *>(QString(), Qt::FindDirectChildrenOnly)) {
-        addTransition(transition);
+        addTransition(transition, snapshot);
     }
 
     // add sub-states
     Q_FOREACH (auto child, state->findChildren<QAbstractState *>(QString(), Qt::FindDirectChildrenOnly)) {
-        addState(child);
+        addState(child, snapshot);
     }
 }
 
-void QsmDebugInterfaceSource::Private::addTransition(QAbstractTransition *transition)
+void QsmDebugInterfaceSource::Private::addTransition(QAbstractTransition *transition, GraphSnapshot &snapshot)
 {
     QState *sourceState = transition->sourceState();
     QAbstractState *targetState = transition->targetState();
-    addState(sourceState);
-    addState(targetState);
+    addState(sourceState, snapshot);
+    addState(targetState, snapshot);
 
     const QString label = labelForTransition(transition);
-    Q_EMIT transitionAdded(makeTransitionId(transition), makeStateId(sourceState),
+    snapshot.addTransition(makeTransitionId(transition), makeStateId(sourceState),
                            makeStateId(targetState), label);
 }
 
+void QsmDebugInterfaceSource::Private::enqueueMessage(const QString &message)
+{
+    Event event;
+    event.type = Event::MessageEvent;
+    event.text = message;
+    m_eventQueue->enqueue(event);
+}
+
 void QsmDebugInterfaceSource::Private::updateStartStop()
 {
     Q_EMIT statusChanged(qStateMachine() != nullptr, qStateMachine() && qStateMachine()->isRunning());
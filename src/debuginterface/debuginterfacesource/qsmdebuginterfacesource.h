@@ -42,6 +42,44 @@ public:
      */
     QObject *remoteObjectSource() const;
 
+    enum OverflowPolicy
+    {
+        /// Drop the oldest queued events
+        DropOldest,
+        /**
+         * Drop the queued messages and configuration updates, and send the current
+         * configuration as keyframe instead
+         */
+        Aggregate
+    };
+
+    /**
+     * Time in milliseconds runtime events are collected before being sent in one batch
+     *
+     * @note Default is 20 ms
+     */
+    int batchInterval() const;
+    void setBatchInterval(int msecs);
+
+    /**
+     * Maximum number of queued runtime events, see overflowPolicy()
+     *
+     * @note Default is 4096
+     */
+    int maximumQueueSize() const;
+    void setMaximumQueueSize(int size);
+
+    /**
+     * What to do with new events while the queue is full
+     *
+     * @note Default is DropOldest
+     */
+    OverflowPolicy overflowPolicy() const;
+    void setOverflowPolicy(OverflowPolicy policy);
+
+    /// Number of runtime events dropped because the queue was full
+    quint64 droppedEventCount() const;
+
 private:
     class Private;
     QScopedPointer<Private> d;
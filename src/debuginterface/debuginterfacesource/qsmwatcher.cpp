@@ -16,10 +16,13 @@
 #include "qsmwatcher_p.h"
 
 #include <QAbstractTransition>
+#include <QChildEvent>
 #include <QFinalState>
 #include <QState>
 #include <QStateMachine>
 
+#include <utility>
+
 QSMWatcher::QSMWatcher(QObject *parent)
     : QObject(parent)
     , m_watchedStateMachine(nullptr)
@@ -38,12 +41,10 @@ void QSMWatcher::setWatchedStateMachine(QStateMachine *machine)
         return;
     }
 
-    m_watchedStateMachine = machine;
-
     clearWatchedStates();
-    const auto children = machine->findChildren<QAbstractState *>();
-    for (QAbstractState *state : children) {
-        watchState(state);
+    m_watchedStateMachine = machine;
+    if (machine) {
+        watchTree(machine, false);
     }
 
     Q_EMIT watchedStateMachineChanged(machine);
@@ -54,52 +55,113 @@ QStateMachine *QSMWatcher::watchedStateMachine() const
     return m_watchedStateMachine;
 }
 
-void QSMWatcher::watchState(QAbstractState *state)
+bool QSMWatcher::eventFilter(QObject *watched, QEvent *event)
 {
-    if (state->machine() != m_watchedStateMachine) {
-        return;
+    if (event->type() == QEvent::ChildAdded) {
+        // the child is still being constructed, look at it once control returns to the event loop
+        if (m_addedChildren.isEmpty()) {
+            QMetaObject::invokeMethod(this, &QSMWatcher::watchAddedChildren, Qt::QueuedConnection);
+        }
+        m_addedChildren << static_cast<QChildEvent *>(event)->child();
     }
+    return QObject::eventFilter(watched, event);
+}
 
-    connect(state, SIGNAL(entered()),
-            this, SLOT(handleStateEntered()), Qt::UniqueConnection);
-    connect(state, SIGNAL(exited()),
-            this, SLOT(handleStateExited()), Qt::UniqueConnection);
-    connect(state, SIGNAL(destroyed(QObject *)),
-            this, SLOT(handleStateDestroyed()), Qt::UniqueConnection);
+void QSMWatcher::watchTree(QObject *root, bool notify)
+{
+    QVector<QAbstractState *> addedStates;
+    QVector<QAbstractTransition *> addedTransitions;
+
+    // states and transitions are direct children of their parent state
+    QVector<QObject *> pending { root };
+    while (!pending.isEmpty()) {
+        QObject *object = pending.takeLast();
+        if (auto transition = qobject_cast<QAbstractTransition *>(object)) {
+            if (!m_watchedTransitions.contains(transition)) {
+                watchTransition(transition);
+                addedTransitions << transition;
+            }
+            continue;
+        }
 
-    Q_FOREACH (QAbstractTransition *transition, state->findChildren<QAbstractTransition *>()) {
-        connect(transition, SIGNAL(triggered()),
-                this, SLOT(handleTransitionTriggered()), Qt::UniqueConnection);
+        auto state = qobject_cast<QAbstractState *>(object);
+        if (!state) {
+            continue;
+        }
+        if (state != m_watchedStateMachine) {
+            if (state->machine() != m_watchedStateMachine || m_watchedStates.contains(state)) {
+                continue;
+            }
+            watchState(state);
+            addedStates << state;
+        }
+
+        state->installEventFilter(this);
+        const auto &children = state->children();
+        // reversed, so that children are visited in order
+        for (auto it = children.crbegin(); it != children.crend(); ++it) {
+            pending << *it;
+        }
+    }
+
+    if (!notify) {
+        return;
+    }
+    for (QAbstractState *state : std::as_const(addedStates)) {
+        Q_EMIT stateAdded(state);
+    }
+    for (QAbstractTransition *transition : std::as_const(addedTransitions)) {
+        Q_EMIT transitionAdded(transition);
     }
-    m_watchedStates << state;
 }
 
-void QSMWatcher::clearWatchedStates()
+void QSMWatcher::watchState(QAbstractState *state)
+{
+    connect(state, &QAbstractState::entered, this, [this, state]() { handleStateEntered(state); });
+    connect(state, &QAbstractState::exited, this, [this, state]() { handleStateExited(state); });
+    connect(state, &QObject::destroyed, this, [this, state]() { m_watchedStates.remove(state); });
+    m_watchedStates.insert(state);
+}
+
+void QSMWatcher::watchTransition(QAbstractTransition *transition)
 {
-    Q_FOREACH (QAbstractState *state, m_watchedStates) {
-        disconnect(state, SIGNAL(entered()), this, SLOT(handleStateEntered()));
-        disconnect(state, SIGNAL(exited()), this, SLOT(handleStateExited()));
-        disconnect(state, SIGNAL(destroyed(QObject *)), this, SLOT(handleStateDestroyed()));
+    connect(transition, &QAbstractTransition::triggered, this, [this, transition]() { Q_EMIT transitionTriggered(transition); });
+    connect(transition, &QObject::destroyed, this, [this, transition]() { m_watchedTransitions.remove(transition); });
+    m_watchedTransitions.insert(transition);
+}
 
-        Q_FOREACH (QAbstractTransition *transition, state->findChildren<QAbstractTransition *>()) {
-            disconnect(transition, SIGNAL(triggered()), this, SLOT(handleTransitionTriggered()));
+void QSMWatcher::watchAddedChildren()
+{
+    const auto children = std::exchange(m_addedChildren, {});
+    for (const QPointer<QObject> &child : children) {
+        if (child && m_watchedStateMachine) {
+            watchTree(child, true);
         }
     }
-    m_watchedStates.clear();
 }
 
-void QSMWatcher::handleTransitionTriggered()
+void QSMWatcher::clearWatchedStates()
 {
-    QAbstractTransition *transition = qobject_cast<QAbstractTransition *>(QObject::sender());
-    Q_ASSERT(transition);
+    for (QAbstractState *state : std::as_const(m_watchedStates)) {
+        disconnect(state, nullptr, this, nullptr);
+        state->removeEventFilter(this);
+    }
+    for (QAbstractTransition *transition : std::as_const(m_watchedTransitions)) {
+        disconnect(transition, nullptr, this, nullptr);
+    }
+    if (m_watchedStateMachine) {
+        m_watchedStateMachine->removeEventFilter(this);
+    }
 
-    Q_EMIT transitionTriggered(transition);
+    m_watchedStates.clear();
+    m_watchedTransitions.clear();
+    m_addedChildren.clear();
+    m_lastEnteredState = nullptr;
+    m_lastExitedState = nullptr;
 }
 
-void QSMWatcher::handleStateEntered()
+void QSMWatcher::handleStateEntered(QAbstractState *state)
 {
-    QAbstractState *state = qobject_cast<QAbstractState *>(QObject::sender());
-    Q_ASSERT(state);
     if (state->machine() != m_watchedStateMachine) {
         return;
     }
@@ -112,11 +174,8 @@ void QSMWatcher::handleStateEntered()
     Q_EMIT stateEntered(state);
 }
 
-void QSMWatcher::handleStateExited()
+void QSMWatcher::handleStateExited(QAbstractState *state)
 {
-    QAbstractState *state = qobject_cast<QAbstractState *>(QObject::sender());
-    Q_ASSERT(state);
-
     if (state->machine() != m_watchedStateMachine) {
         return;
     }
@@ -128,13 +187,3 @@ void QSMWatcher::handleStateExited()
     m_lastExitedState = state;
     Q_EMIT stateExited(state);
 }
-
-void QSMWatcher::handleStateDestroyed()
-{
-    QAbstractState *state = static_cast<QAbstractState *>(QObject::sender());
-    Q_ASSERT(state);
-
-    const int index = m_watchedStates.indexOf(state);
-    Q_ASSERT(index != -1);
-    m_watchedStates.remove(index);
-}
@@ -17,6 +17,8 @@
 #define QSMWATCHER_H
 
 #include <QObject>
+#include <QPointer>
+#include <QSet>
 #include <QVector>
 
 QT_BEGIN_NAMESPACE
@@ -38,6 +40,8 @@ public:
     void setWatchedStateMachine(QStateMachine *machine);
     QStateMachine *watchedStateMachine() const;
 
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
 Q_SIGNALS:
     void stateEntered(QAbstractState *state);
     void stateExited(QAbstractState *state);
@@ -46,18 +50,29 @@ Q_SIGNALS:
 
     void watchedStateMachineChanged(QStateMachine *);
 
+    /// Emitted for states added to the watched machine later on, parents come first
+    void stateAdded(QAbstractState *state);
+    /// Emitted for transitions added to the watched machine later on, after their states
+    void transitionAdded(QAbstractTransition *transition);
+
 private Q_SLOTS:
-    void watchState(QAbstractState *state);
     void clearWatchedStates();
-
-    void handleStateEntered();
-    void handleStateExited();
-    void handleStateDestroyed();
-    void handleTransitionTriggered();
+    void watchAddedChildren();
 
 private:
+    /// Index @p root and all states and transitions below it in a single traversal
+    void watchTree(QObject *root, bool notify);
+    void watchState(QAbstractState *state);
+    void watchTransition(QAbstractTransition *transition);
+
+    void handleStateEntered(QAbstractState *state);
+    void handleStateExited(QAbstractState *state);
+
     QStateMachine *m_watchedStateMachine;
-    QVector<QAbstractState *> m_watchedStates;
+    QSet<QAbstractState *> m_watchedStates;
+    QSet<QAbstractTransition *> m_watchedTransitions;
+    /// Children added since the last watchAddedChildren(), not fully constructed yet when added
+    QVector<QPointer<QObject>> m_addedChildren;
 
     QAbstractState *m_lastEnteredState;
     QAbstractState *m_lastExitedState;
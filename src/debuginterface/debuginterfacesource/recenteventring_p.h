@@ -0,0 +1,117 @@
+/*
+  This file is part of the KDAB State Machine Editor Library.
+
+  SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company <info@kdab.com>
+
+  SPDX-License-Identifier: LGPL-2.1-only OR LicenseRef-KDAB-KDStateMachineEditor
+
+  Licensees holding valid commercial KDAB State Machine Editor Library
+  licenses may use this file in accordance with the KDAB State Machine Editor
+  Library License Agreement provided with the Software.
+
+  Contact info@kdab.com if any conditions of this licensing are not clear to you.
+*/
+
+#ifndef RECENTEVENTRING_H
+#define RECENTEVENTRING_H
+
+#include "debuginterface_types.h"
+
+#include <QElapsedTimer>
+
+#include <atomic>
+#include <memory>
+
+namespace KDSME {
+namespace DebugInterface {
+
+/**
+ * Fixed-size ring of the most recent runtime events of a debug source
+ *
+ * Recording never blocks and never allocates, so it can stay enabled while no client is
+ * connected. There must be a single writer, snapshot() may be called from any thread: each slot
+ * is guarded by a sequence number, slots overwritten while being read are skipped.
+ */
+class RecentEventRing
+{
+public:
+    static constexpr int DefaultCapacity = 1024;
+
+    explicit RecentEventRing(int capacity = DefaultCapacity)
+        : m_capacity(static_cast<quint64>(qMax(capacity, 1)))
+        , m_slots(new Slot[m_capacity])
+    {
+        m_clock.start();
+    }
+
+    void record(RecentEvents::Type type, quint64 id)
+    {
+        const quint64 position = m_written.load(std::memory_order_relaxed);
+        Slot &slot = m_slots[position % m_capacity];
+        // odd while writing
+        slot.sequence.store(2 * position + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.time.store(m_clock.nsecsElapsed(), std::memory_order_relaxed);
+        slot.type.store(type, std::memory_order_relaxed);
+        slot.id.store(id, std::memory_order_relaxed);
+        slot.sequence.store(2 * position + 2, std::memory_order_release);
+        m_written.store(position + 1, std::memory_order_release);
+    }
+
+    /// Forget the recorded events, e.g. because their ids became invalid
+    void clear()
+    {
+        m_first.store(m_written.load(std::memory_order_relaxed), std::memory_order_release);
+    }
+
+    /// @return The recorded events, oldest first
+    RecentEvents snapshot() const
+    {
+        RecentEvents result;
+        const quint64 written = m_written.load(std::memory_order_acquire);
+        const quint64 first = qMax(m_first.load(std::memory_order_acquire), written > m_capacity ? written - m_capacity : 0);
+        result.now = m_clock.nsecsElapsed();
+        result.times.reserve(static_cast<qsizetype>(written - first));
+        result.types.reserve(static_cast<qsizetype>(written - first));
+        result.ids.reserve(static_cast<qsizetype>(written - first));
+
+        for (quint64 position = first; position < written; ++position) {
+            const Slot &slot = m_slots[position % m_capacity];
+            const quint64 sequence = slot.sequence.load(std::memory_order_acquire);
+            if (sequence != 2 * position + 2) {
+                continue; // being overwritten
+            }
+            const qint64 time = slot.time.load(std::memory_order_relaxed);
+            const quint8 type = slot.type.load(std::memory_order_relaxed);
+            const quint64 id = slot.id.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.sequence.load(std::memory_order_relaxed) != sequence) {
+                continue;
+            }
+            result.times << time;
+            result.types << type;
+            result.ids << id;
+        }
+        return result;
+    }
+
+private:
+    struct Slot
+    {
+        std::atomic<quint64> sequence { 0 };
+        std::atomic<qint64> time { 0 };
+        std::atomic<quint8> type { 0 };
+        std::atomic<quint64> id { 0 };
+    };
+
+    const quint64 m_capacity;
+    const std::unique_ptr<Slot[]> m_slots;
+    QElapsedTimer m_clock;
+    std::atomic<quint64> m_written { 0 };
+    std::atomic<quint64> m_first { 0 };
+};
+
+}
+}
+
+#endif // RECENTEVENTRING_H
@@ -0,0 +1,89 @@
+/*
+  This file is part of the KDAB State Machine Editor Library.
+
+  SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company <info@kdab.com>
+
+  SPDX-License-Identifier: LGPL-2.1-only OR LicenseRef-KDAB-KDStateMachineEditor
+
+  Licensees holding valid commercial KDAB State Machine Editor Library
+  licenses may use this file in accordance with the KDAB State Machine Editor
+  Library License Agreement provided with the Software.
+
+  Contact info@kdab.com if any conditions of this licensing are not clear to you.
+*/
+
+/*
+  Layout worker process, started by KDSME::RemoteLayouter
+
+  Reads requests from stdin and writes the replies to stdout, each one prefixed
+  with its size as big-endian 32-bit integer. Exits once stdin gets closed.
+*/
+
+#include "remotelayouter.h"
+
+#include <QFile>
+#include <QGuiApplication>
+#include <QtEndian>
+
+#include <cstdio>
+#ifdef Q_OS_WIN
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+using namespace KDSME;
+
+namespace {
+
+/// Read exactly @p size bytes, blocking
+bool readFully(QFile *file, char *data, qint64 size)
+{
+    while (size > 0) {
+        const qint64 count = file->read(data, size);
+        if (count <= 0) {
+            return false;
+        }
+        data += count;
+        size -= count;
+    }
+    return true;
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    // font metrics are needed for the label sizes, but nothing is ever shown
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QGuiApplication app(argc, argv);
+
+#ifdef Q_OS_WIN
+    _setmode(_fileno(stdin), _O_BINARY);
+    _setmode(_fileno(stdout), _O_BINARY);
+#endif
+
+    QFile in;
+    QFile out;
+    if (!in.open(stdin, QIODevice::ReadOnly | QIODevice::Unbuffered)
+        || !out.open(stdout, QIODevice::WriteOnly | QIODevice::Unbuffered)) {
+        return 1;
+    }
+
+    char header[sizeof(quint32)];
+    while (readFully(&in, header, sizeof(header))) {
+        QByteArray request(qFromBigEndian<quint32>(header), Qt::Uninitialized);
+        if (!readFully(&in, request.data(), request.size())) {
+            return 1;
+        }
+
+        const QByteArray reply = RemoteLayouter::processRequest(request);
+        qToBigEndian<quint32>(reply.size(), header);
+        if (out.write(header, sizeof(header)) != sizeof(header) || out.write(reply) != reply.size()) {
+            return 1;
+        }
+        out.flush();
+    }
+    return 0;
+}
@@ -15,7 +15,10 @@
 
 #include "modifyelementcommand_p.h"
 
+#include "edgerouter.h"
 #include "element.h"
+#include "state.h"
+#include "transition.h"
 
 #include "debug.h"
 
@@ -75,6 +78,7 @@ void KDSME::ModifyElementCommand::redo()
         setElementGeometry(m_item.data(), m_newGeometry);
         break;
     }
+    rerouteTransitions();
 }
 
 void KDSME::ModifyElementCommand::undo()
@@ -92,6 +96,7 @@ void KDSME::ModifyElementCommand::undo()
         setElementGeometry(m_item.data(), m_oldGeometry);
         break;
     }
+    restoreTransitions();
 }
 
 bool ModifyElementCommand::mergeWith(const QUndoCommand *other)
@@ -110,6 +115,39 @@ bool ModifyElementCommand::mergeWith(const QUndoCommand *other)
     return true;
 }
 
+void ModifyElementCommand::rerouteTransitions()
+{
+    // Keep the transitions attached to a moved or resized state, without a full relayout
+    const auto *state = qobject_cast<State *>(m_item.data());
+    if (!state) {
+        return;
+    }
+
+    const auto transitions = EdgeRouter::incidentTransitions(state);
+    if (!m_transitionGeometrySaved) {
+        for (Transition *transition : transitions) {
+            m_oldTransitionGeometry.append({ transition, transition->pos(), transition->shape(), transition->labelBoundingRect() });
+        }
+        m_transitionGeometrySaved = true;
+    }
+
+    for (Transition *transition : transitions) {
+        EdgeRouter::route(transition);
+    }
+}
+
+void ModifyElementCommand::restoreTransitions()
+{
+    // Bring back the original routes instead of approximating them
+    for (const TransitionGeometry &geometry : std::as_const(m_oldTransitionGeometry)) {
+        if (geometry.transition) {
+            geometry.transition->setPos(geometry.pos);
+            geometry.transition->setShape(geometry.shape);
+            geometry.transition->setLabelBoundingRect(geometry.labelBoundingRect);
+        }
+    }
+}
+
 void KDSME::ModifyElementCommand::updateText()
 {
     const QString itemLabel = m_item ? m_item->label() : tr("<Unknown>");
@@ -18,13 +18,16 @@
 
 #include "command_p.h"
 
+#include <QPainterPath>
 #include <QPointer>
 #include <QPointF>
 #include <QRectF>
+#include <QVector>
 
 namespace KDSME {
 
 class Element;
+class Transition;
 
 /**
  * @brief Command for modifying properties of KDSME::Element
@@ -67,12 +70,25 @@ protected:
 
 private:
     void updateText();
+    void rerouteTransitions();
+    void restoreTransitions();
 
     QPointer<Element> m_item;
 
     // data
     QPointF m_moveByData;
     QRectF m_newGeometry, m_oldGeometry;
+
+    /// Geometry of the transitions attached to the item before the first redo
+    struct TransitionGeometry
+    {
+        QPointer<Transition> transition;
+        QPointF pos;
+        QPainterPath shape;
+        QRectF labelBoundingRect;
+    };
+    QVector<TransitionGeometry> m_oldTransitionGeometry;
+    bool m_transitionGeometrySaved = false;
 };
 
 }
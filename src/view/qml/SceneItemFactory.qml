@@ -63,8 +63,7 @@ Loader {
         if (!runtimeController)
             return 0;
 
-        runtimeController.activeConfiguration; // bind to active configuration
-        return runtimeController.activenessForState(state);
+        return state.activeness; // only notified for states whose activeness changed
     }
 
     function activenessForTransition(transition) {
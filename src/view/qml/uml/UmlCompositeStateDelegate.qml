@@ -142,7 +142,7 @@ Item {
             text: (element.expanded ? "-" : "+")
             onClicked: {
                 scene.setItemExpanded(control.element, !element.expanded);
-                scene.layout();
+                scene.layoutAsync();
             }
         }
     }
@@ -23,6 +23,8 @@
 #include "transition.h"
 #include "layouter.h"
 #include "layoutproperties.h"
+#include "layoutresult.h"
+#include "layoutsnapshot.h"
 #include "layoututils.h"
 #include "elementmodel.h"
 #include "elementwalker.h"
@@ -56,6 +58,9 @@ StateMachineScene::Private::Private(StateMachineScene *view)
     , m_zoom(1.0)
     , m_maximumDepth(3)
 {
+    m_layoutThreadPool.setMaxThreadCount(1);
+    // only regions which changed since the last run get laid out again
+    m_layouter->setIncremental(true);
 }
 
 StateMachineScene::StateMachineScene(QQuickItem *parent)
@@ -67,6 +72,9 @@ StateMachineScene::StateMachineScene(QQuickItem *parent)
 
 StateMachineScene::~StateMachineScene()
 {
+    // the background job must not outlive us
+    d->cancelPendingLayout();
+    d->m_layoutThreadPool.waitForDone();
 }
 
 LayoutProperties *StateMachineScene::layoutProperties() const
@@ -232,7 +240,7 @@ void StateMachineScene::setMaximumDepth(int maximumDepth)
     setViewState(RefreshState);
 
     d->updateItemVisibilities();
-    layout();
+    layoutAsync();
 
     setViewState(oldViewState);
 }
@@ -269,20 +277,105 @@ void StateMachineScene::layout()
         return;
     }
 
-    auto oldViewState = viewState();
-    setViewState(RefreshState);
+    // never block the user interface waiting for e.g. a worker process
+    if (d->m_layouter->mayBlock()) {
+        layoutAsync();
+        return;
+    }
+
+    d->layoutNow();
+}
+
+void StateMachineScene::Private::layoutNow()
+{
+    auto oldViewState = q->viewState();
+    q->setViewState(RefreshState);
 
     // reset
-    setZoom(1.0);
+    q->setZoom(1.0);
 
     QElapsedTimer timer;
     timer.start();
 
-    d->m_layouter->layout(d->m_rootState, layoutProperties());
+    // supersedes any layout still running in the background
+    cancelPendingLayout();
+
+    m_layouter->layout(m_rootState, q->layoutProperties());
 
     qCDebug(KDSME_VIEW) << "Layouting took" << timer.elapsed() << "ms";
 
-    setViewState(oldViewState);
+    q->setViewState(oldViewState);
+
+    Q_EMIT q->layoutFinished();
+}
+
+bool StateMachineScene::isLayoutPending() const
+{
+    return !d->m_pendingLayout.isNull();
+}
+
+void StateMachineScene::layoutAsync()
+{
+    qCDebug(KDSME_VIEW) << d->m_layouter << d->m_rootState;
+
+    if (!d->m_layouter || !d->m_rootState) {
+        return;
+    }
+
+    // the layouter works on unzoomed geometry
+    setZoom(1.0);
+
+    d->cancelPendingLayout();
+    QSharedPointer<LayoutSnapshot> snapshot(new LayoutSnapshot(d->m_rootState, layoutProperties(), d->m_layouter));
+    if (!snapshot->isValid()) {
+        d->layoutNow();
+        return;
+    }
+    d->m_pendingLayout = snapshot;
+
+    d->m_layoutThreadPool.start([this, snapshot]() {
+        QElapsedTimer timer;
+        timer.start();
+
+        if (!snapshot->layout()) {
+            return;
+        }
+
+        qCDebug(KDSME_VIEW) << "Layouting took" << timer.elapsed() << "ms";
+
+        QMetaObject::invokeMethod(
+            this, [this, snapshot]() { d->finishLayout(snapshot); }, Qt::QueuedConnection);
+    });
+}
+
+void StateMachineScene::Private::cancelPendingLayout()
+{
+    if (m_pendingLayout) {
+        m_pendingLayout->cancel();
+        m_pendingLayout.reset();
+    }
+}
+
+void StateMachineScene::Private::finishLayout(const QSharedPointer<LayoutSnapshot> &snapshot)
+{
+    if (snapshot != m_pendingLayout) {
+        return; // superseded by a newer request
+    }
+    m_pendingLayout.reset();
+
+    if (snapshot->root() != m_rootState) {
+        return;
+    }
+
+    auto oldViewState = q->viewState();
+    q->setViewState(RefreshState);
+
+    q->setZoom(1.0);
+    snapshot->apply();
+
+    q->setViewState(oldViewState);
+
+    Q_EMIT q->layoutFinished();
 }
 
 StateModel *StateMachineScene::stateModel() const
@@ -51,7 +51,12 @@ public:
     void setRootState(State *rootState);
 
     Layouter *layouter() const;
-    /// Ownership is transferred
+    /**
+     * Ownership is transferred
+     *
+     * The layouter keeps its settings. Enable Layouter::isIncremental() to only lay out the regions
+     * affected by a change again, as the default layouter of the scene does.
+     */
     void setLayouter(Layouter *layouter);
 
     qreal zoom() const;
@@ -77,8 +82,29 @@ public:
 
     KDSME::Element *currentState() const;
 
+    /// @return True while a layout run in the background did not finish yet, see layoutAsync()
+    bool isLayoutPending() const;
+
 public Q_SLOTS:
+    /**
+     * Lay out the state machine in the calling thread
+     *
+     * @note Goes through layoutAsync() instead in case the layouter may block, see Layouter::mayBlock(),
+     * e.g. for a RemoteLayouter. The geometry is then still the old one when this returns. Code
+     * depending on the new geometry should check isLayoutPending() and wait for layoutFinished().
+     */
     void layout();
+    /**
+     * Lay out the state machine in a background thread
+     *
+     * Takes a snapshot of the elements and applies the computed geometry in one batch
+     * once done, followed by layoutFinished(). A newer layout request supersedes
+     * (and cancels) a pending one.
+     *
+     * The background run uses a copy of the layouter, see Layouter::clone(). Falls back to
+     * a synchronous layout() in case the layouter cannot be copied.
+     */
+    void layoutAsync();
 
 Q_SIGNALS:
     void stateMachineChanged(KDSME::StateMachine *stateMachine);
@@ -86,6 +112,8 @@ Q_SIGNALS:
     void currentItemChanged(KDSME::Element *currentItem);
     void zoomChanged(qreal zoom);
     void maximumDepthChanged(int depth);
+    /// Emitted once the geometry of a layout run got applied to the elements
+    void layoutFinished();
 
 protected Q_SLOTS:
     void currentChanged(const QModelIndex &current, const QModelIndex &previous) override;
@@ -18,10 +18,15 @@
 
 #include "statemachinescene.h"
 
+#include <QSharedPointer>
+#include <QThreadPool>
+
 class QuickSceneItem;
 
 namespace KDSME {
 
+class LayoutSnapshot;
+
 struct StateMachineScene::Private
 {
     explicit Private(StateMachineScene *view);
@@ -38,6 +43,11 @@ struct StateMachineScene::Private
     void importTransitions(State *state);
     Transition *importTransition(Transition *transition);
 
+    /// Lay out in the calling thread, see StateMachineScene::layout()
+    void layoutNow();
+    void cancelPendingLayout();
+    void finishLayout(const QSharedPointer<LayoutSnapshot> &snapshot);
+
     StateMachineScene *q;
 
     State *m_rootState;
@@ -45,6 +55,10 @@ struct StateMachineScene::Private
     LayoutProperties *m_properties;
     qreal m_zoom;
     int m_maximumDepth;
+
+    /// Runs one background layout at a time, see layoutAsync()
+    QThreadPool m_layoutThreadPool;
+    QSharedPointer<LayoutSnapshot> m_pendingLayout;
 };
 
 }
@@ -59,6 +59,7 @@ private Q_SLOTS:
     void testModifyProperty();
     void testModifyTransition();
     void testModifyElement_moveBy();
+    void testModifyElement_moveByReroutesTransitions();
     void testModifyElement_setGeometry();
     void testReparentElement();
 };
@@ -239,6 +240,35 @@ void CommandsTest::testModifyElement_moveBy()
     QCOMPARE(item.pos(), QPointF(0, 0));
 }
 
+void CommandsTest::testModifyElement_moveByReroutesTransitions()
+{
+    TestHarness harness;
+    auto *s1 = new State(&harness.machine);
+    s1->setPos(QPointF(0, 0));
+    s1->setWidth(50);
+    s1->setHeight(20);
+    auto *s2 = new State(&harness.machine);
+    s2->setPos(QPointF(0, 100));
+    s2->setWidth(50);
+    s2->setHeight(20);
+    auto *transition = new Transition(s1);
+    transition->setTargetState(s2);
+    const QPainterPath originalPath(QPointF(25, 20));
+    transition->setShape(originalPath);
+
+    auto cmd = new ModifyElementCommand(s2);
+    cmd->moveBy(200, 0);
+    harness.undoStack.push(cmd);
+
+    // the transition now ends on the top border of the moved state
+    const QPointF end = s1->absolutePos() + transition->pos() + transition->shape().pointAtPercent(1);
+    QVERIFY(end.x() >= s2->absolutePos().x() && end.x() <= s2->absolutePos().x() + s2->width());
+    QVERIFY(qAbs(end.y() - s2->absolutePos().y()) < 1);
+
+    harness.undoStack.undo();
+    QCOMPARE(transition->shape(), originalPath);
+}
+
 void CommandsTest::testModifyElement_setGeometry() // NOLINT(readability-function-cognitive-complexity)
 {
     TestHarness harness;
@@ -304,6 +304,13 @@ QRectF StateMachineView::Private::adjustedViewRect() const
 
 void StateMachineView::fitInView()
 {
+    // fit the geometry the pending layout comes up with
+    if (scene()->isLayoutPending()) {
+        QObject::connect(scene(), &StateMachineScene::layoutFinished, this, &StateMachineView::fitInView,
+                         static_cast<Qt::ConnectionType>(Qt::UniqueConnection | Qt::SingleShotConnection));
+        return;
+    }
+
     const QRectF sceneRect = scene()->rootState()->boundingRect();
     const QRectF viewRect = d->adjustedViewRect();
     if (sceneRect.isEmpty() || viewRect.isEmpty())